@@ -0,0 +1,97 @@
+/*
+ * Prints a binary event log written by ns3::VanetEventLog as text.
+ *
+ * ./waf --run "vanet-event-log-decode --file=contrib/vanetsim/results/vanet-events.bin"
+ */
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+#include "../model/vanet-event-log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  std::string fileName ("contrib/vanetsim/results/vanet-events.bin");
+  int64_t nodeFilter = -1;
+  std::string eventFilter ("");
+
+  CommandLine cmd;
+  cmd.AddValue ("file", "Binary event log", fileName);
+  cmd.AddValue ("node", "Only print events of this node id (-1 for all)", nodeFilter);
+  cmd.AddValue ("event", "Only print events of this type (e.g. HANDOVER)", eventFilter);
+  cmd.Parse (argc, argv);
+
+  std::FILE *file = std::fopen (fileName.c_str (), "rb");
+  if (!file)
+    {
+      std::cerr << "Can't open " << fileName << std::endl;
+      return 1;
+    }
+
+  VanetEventLog::FileHeader header;
+  if (std::fread (&header, sizeof (header), 1, file) != 1 ||
+      std::memcmp (header.magic, "VNETLOG1", sizeof (header.magic)) != 0 ||
+      header.recordSize != sizeof (VanetEventLog::Record))
+    {
+      std::cerr << fileName << " is not a VANETSIM event log" << std::endl;
+      std::fclose (file);
+      return 1;
+    }
+
+  std::vector<VanetEventLog::Record> block (4096);
+  size_t n;
+  std::cout << std::fixed << std::setprecision (6);
+  while ((n = std::fread (block.data (), sizeof (VanetEventLog::Record), block.size (), file)) > 0)
+    {
+      for (size_t i = 0; i < n; i++)
+        {
+          const VanetEventLog::Record &r = block[i];
+          const char *name = VanetEventLog::GetEventName (r.type);
+          if ((nodeFilter >= 0 && r.nodeId != nodeFilter) ||
+              (!eventFilter.empty () && eventFilter != name))
+            continue;
+
+          std::cout << r.timeNs / 1e9 << " node=" << r.nodeId << " " << name;
+          switch (r.type)
+            {
+            case VanetEventLog::BEACON_TX:
+              std::cout << " bytes=" << r.arg0;
+              break;
+            case VanetEventLog::BEACON_RX:
+              std::cout << " rsu=" << r.arg0 << " signal=" << r.value
+                        << " noise=" << (int32_t) r.arg1 / 100.0;
+              break;
+            case VanetEventLog::DHCP_REQUEST_TX:
+              std::cout << " rsu=" << Ipv4Address (r.arg0) << " retry=" << r.arg1;
+              break;
+            case VanetEventLog::DHCP_REQUEST_RX:
+            case VanetEventLog::DHCP_OFFER_TX:
+              std::cout << " vehicle=" << r.arg0 << " addr=" << Ipv4Address (r.arg1);
+              break;
+            case VanetEventLog::DHCP_OFFER_RX:
+              std::cout << " rsu=" << r.arg0 << " addr=" << Ipv4Address (r.arg1);
+              break;
+            case VanetEventLog::HANDOVER:
+            case VanetEventLog::PING_PONG:
+              std::cout << " old-rsu=" << r.arg0 << " new-rsu=" << r.arg1;
+              break;
+            case VanetEventLog::LEASES_IN_USE:
+              std::cout << " leases=" << r.arg1;
+              break;
+            default:
+              std::cout << " arg0=" << r.arg0 << " arg1=" << r.arg1 << " value=" << r.value;
+            }
+          std::cout << "\n";
+        }
+    }
+
+  std::fclose (file);
+  return 0;
+}
@@ -0,0 +1,155 @@
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/wave-module.h"
+#include "ns3/wifi-80211p-helper.h"
+#include "ns3/wave-mac-helper.h"
+#include <chrono>
+#include <functional>
+
+#include "../model/beacon-search-net.h"
+#include "../model/beacon-rsu-net.h"
+#include "../model/handover-stats.h"
+#include "../model/vanet-sumo-client.h"
+#include "../model/rsu-deployment-helper.h"
+#include "../model/backhaul-routing.h"
+
+using namespace ns3;
+NS_LOG_COMPONENT_DEFINE ("vanet-example-rsu");
+
+/**
+ * RSUs generated from the junctions of the SUMO network instead of placed
+ * by hand, e.g.
+ *   ./waf --run "vanet-example-rsu --deploy=grid:50"
+ *   ./waf --run "vanet-example-rsu --deploy=coverage:0.9 --range=80 --fanOut=16"
+ *   ./waf --run "vanet-example-rsu --deploy=grid:50 --multiChannel=1"
+ */
+int
+main (int argc, char *argv[])
+{
+  std::string deploy = "junction:1";
+  std::string netFile = "contrib/vanetsim/traces/grid-map/map.net.xml";
+  std::string sumoConfig = "contrib/vanetsim/traces/grid-map/sim.sumocfg";
+  double range = 100;
+  uint32_t fanOut = 8;
+  uint32_t maxRsus = 0;
+  uint32_t nVehicles = 50;
+  double simTime = 300;
+  bool verbose = false;
+  bool multiChannel = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("deploy", "junction:<k>, grid:<spacing> or coverage:<fraction>", deploy);
+  cmd.AddValue ("net", "SUMO network with the candidate junctions", netFile);
+  cmd.AddValue ("sumo", "SUMO configuration", sumoConfig);
+  cmd.AddValue ("range", "Radius covered by an RSU for coverage (m)", range);
+  cmd.AddValue ("fanOut", "RSUs behind one backhaul router", fanOut);
+  cmd.AddValue ("maxRsus", "Upper bound on the RSUs (0: none)", maxRsus);
+  cmd.AddValue ("vehicles", "Size of the vehicle node pool", nVehicles);
+  cmd.AddValue ("simTime", "Simulation time (s)", simTime);
+  cmd.AddValue ("verbose", "Enable NS_LOG output", verbose);
+  cmd.AddValue ("multiChannel", "Hellos and DHCP on the CCH, data on per-RSU service channels",
+                multiChannel);
+  cmd.Parse (argc, argv);
+  LogComponentEnable ("rsu-deployment-helper", LOG_LEVEL_INFO);
+  if (verbose)
+    {
+      LogComponentEnable ("vanet-sumo-client", LOG_LEVEL_INFO);
+      LogComponentEnable ("beacon-search-net", LOG_LEVEL_INFO);
+    }
+
+  std::string phyMode ("OfdmRate6MbpsBW10MHz");
+  YansWifiPhyHelper wifiPhy = YansWifiPhyHelper::Default ();
+  wifiPhy.Set ("TxPowerStart", DoubleValue (25));
+  wifiPhy.Set ("TxPowerEnd", DoubleValue (25));
+  YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default ();
+  wifiPhy.SetChannel (wifiChannel.Create ());
+  NqosWaveMacHelper wifi80211pMac = NqosWaveMacHelper::Default ();
+  Wifi80211pHelper wifi80211p = Wifi80211pHelper::Default ();
+  wifi80211p.SetRemoteStationManager ("ns3::ConstantRateWifiManager", "DataMode",
+                                      StringValue (phyMode), "ControlMode", StringValue (phyMode));
+
+  /*** RSUs, backhaul and subnet plan from the network ***/
+  auto start = std::chrono::steady_clock::now ();
+  Ptr<RsuDeploymentHelper> deployment = CreateObject<RsuDeploymentHelper> ();
+  deployment->SetAttribute ("NetFile", StringValue (netFile));
+  deployment->SetAttribute ("Range", DoubleValue (range));
+  deployment->SetAttribute ("FanOut", UintegerValue (fanOut));
+  deployment->SetAttribute ("MaxRsus", UintegerValue (maxRsus));
+  deployment->SetAttribute ("MultiChannel", BooleanValue (multiChannel));
+  deployment->SetDeployment (deploy);
+  ApplicationContainer rsuApps = deployment->Install (wifi80211p, wifiPhy, wifi80211pMac);
+  rsuApps.Start (Seconds (5));
+  rsuApps.Stop (Seconds (simTime));
+  std::cout << deployment->GetRsus ().GetN () << " RSUs and "
+            << deployment->GetRouters ().GetN () << " routers set up in "
+            << std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ()
+            << " s" << std::endl;
+
+  /*** Vehicle pool, parked out of range until SUMO needs a node ***/
+  NodeContainer nodePool;
+  nodePool.Create (nVehicles);
+  uint32_t nodeCounter (0);
+  NetDeviceContainer vehicleDevices = wifi80211p.Install (wifiPhy, wifi80211pMac, nodePool);
+  if (multiChannel)
+    RsuDeploymentHelper::InstallControlRadio (wifi80211p, wifiPhy, wifi80211pMac, nodePool);
+  InternetStackHelper stack;
+  stack.Install (nodePool);
+  Ipv4AddressHelper address;
+  address.SetBase ("169.254.0.0", "255.255.0.0");
+  address.Assign (vehicleDevices);
+
+  MobilityHelper mobility;
+  Ptr<UniformDiscPositionAllocator> positionAlloc = CreateObject<UniformDiscPositionAllocator> ();
+  positionAlloc->SetX (-500.0);
+  positionAlloc->SetY (-500.0);
+  positionAlloc->SetRho (25.0);
+  mobility.SetPositionAllocator (positionAlloc);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodePool);
+
+  for (uint32_t i = 0; i < nodePool.GetN (); i++)
+    {
+      Ptr<BeaconSearchNet> app = CreateObject<BeaconSearchNet> ();
+      app->SetStartTime (Seconds (5));
+      app->SetStopTime (Seconds (simTime));
+      nodePool.Get (i)->AddApplication (app);
+    }
+
+  Ptr<VanetSumoClient> sumoClient = CreateObject<VanetSumoClient> ();
+  sumoClient->SetAttribute ("SumoConfigPath", StringValue (sumoConfig));
+  sumoClient->SetAttribute ("SynchInterval", TimeValue (Seconds (0.1)));
+  sumoClient->SetAttribute ("SumoGUI", BooleanValue (false));
+  sumoClient->SetAttribute ("SumoSeed", IntegerValue (10));
+
+  std::function<Ptr<Node> ()> setupNewWifiNode = [&] () -> Ptr<Node> {
+    if (nodeCounter >= nodePool.GetN ())
+      NS_FATAL_ERROR ("Node Pool empty!: " << nodeCounter << " nodes created.");
+    return nodePool.Get (nodeCounter++);
+  };
+
+  // host routes to the vehicles on the router paths, moved at each handover
+  Ptr<BackhaulRouting> backhaulRouting = CreateObject<BackhaulRouting> ();
+  backhaulRouting->SetHub (deployment->GetGateway ());
+  backhaulRouting->AddRsus (deployment->GetRsus ());
+  backhaulRouting->InstallAll ();
+
+  std::function<void (Ptr<Node>)> shutdownWifiNode = [&] (Ptr<Node> exNode) {
+    backhaulRouting->Detach (exNode);
+    exNode->GetObject<MobilityModel> ()->SetPosition (Vector (-500.0, -500.0, 250.0));
+  };
+
+  Ptr<HandoverStats> handoverStats = CreateObject<HandoverStats> ();
+  handoverStats->InstallAll ();
+
+  sumoClient->SumoSetup (setupNewWifiNode, shutdownWifiNode);
+
+  Simulator::Stop (Seconds (simTime));
+  Simulator::Run ();
+  handoverStats->Print (std::cout);
+  Simulator::Destroy ();
+
+  return 0;
+}
@@ -23,6 +23,16 @@
 
 #include "../model/beacon-search-net.h"
 #include "../model/beacon-rsu-net.h"
+#include "../model/handover-stats.h"
+#include "../model/vanet-event-log.h"
+#include "../model/results-sampler.h"
+#include "../model/kpi-aggregator.h"
+#include "../model/vanet-sumo-client.h"
+#include "../model/timing-wheel.h"
+#include "../model/backhaul-routing.h"
+#include "../model/vanet-traffic-app.h"
+#include "../model/vanet-flow-stats.h"
+#include "../model/rsu-deployment-helper.h"
 
 using namespace ns3;
 NS_LOG_COMPONENT_DEFINE ("vanet-example-simple");
@@ -36,17 +46,102 @@ PrintNodeRoutingTable (uint32_t nodePoolId, double timeInSeconds)
                                      routingStream);
 }
 
+// closed loop: a vehicle slows down for a few seconds after each handover
+void
+SlowDownOnHandover (Ptr<VanetSumoClient> sumoClient, Ptr<Node> vehicle, double speed,
+                    uint32_t oldRsuId, uint32_t newRsuId)
+{
+  sumoClient->SlowDown (vehicle, speed, Seconds (3));
+}
+
+// parked vehicles enter the BeaconSearchNet ParkedMode until they leave
+void
+SuspendWhileParked (Ptr<Node> vehicle, bool stopped)
+{
+  for (uint32_t i = 0; i < vehicle->GetNApplications (); i++)
+    {
+      Ptr<BeaconSearchNet> app = DynamicCast<BeaconSearchNet> (vehicle->GetApplication (i));
+      if (app)
+        app->SetParked (stopped);
+    }
+}
+
 int
 main (int argc, char *argv[])
 {
   /*** 0. Logging Options ***/
   bool verbose = true;
+  bool enableEventLog = false;
+  bool enableResults = false;
+  bool enableKpi = false;
+  std::string loadState;
+  std::string saveState;
+  double saveStateTime = 300;
+  double handoverSpeed = 0;
+  bool timingWheel = false;
+  std::string parkedMode = "Active";
+  bool backhaulRoutes = false;
+  bool forwarding = false;
+  bool makeBeforeBreak = false;
+  bool multiChannel = false;
+  std::string strategy = "Beacon";
+  bool loadAware = false;
+  std::string traffic = "None";
+  std::string trafficMode = "Cbr";
+  std::string uplinkRate = "64kbps";
+  std::string downlinkRate = "64kbps";
 
   CommandLine cmd;
+  cmd.AddValue ("verbose", "Enable NS_LOG output", verbose);
+  cmd.AddValue ("eventLog", "Write a binary event log (see vanet-event-log-decode)",
+                enableEventLog);
+  cmd.AddValue ("results", "Sample every vehicle into contrib/vanetsim/results/vehicles.vcol",
+                enableResults);
+  cmd.AddValue ("kpi", "Write a mergeable KPI summary to contrib/vanetsim/results/kpi-summary.txt",
+                enableKpi);
+  cmd.AddValue ("loadState", "Start SUMO from a state saved by a warm-up run", loadState);
+  cmd.AddValue ("saveState", "Save the SUMO state at saveStateTime into this file", saveState);
+  cmd.AddValue ("saveStateTime", "SUMO time (s) of the saved state", saveStateTime);
+  cmd.AddValue ("handoverSpeed", "Slow CAR1 down to this speed (m/s) after a handover (0: off)",
+                handoverSpeed);
+  cmd.AddValue ("timingWheel", "Drive the beacon and handover timers from a shared timing wheel",
+                timingWheel);
+  cmd.AddValue ("backhaulRoutes", "Move host routes to the vehicles along the RSU paths",
+                backhaulRoutes);
+  cmd.AddValue ("forwarding",
+                "Old RSU buffers and forwards the downlink of a departing vehicle "
+                "(with backhaulRoutes)",
+                forwarding);
+  cmd.AddValue ("makeBeforeBreak", "Pre-acquire the next lease before leaving the serving RSU",
+                makeBeforeBreak);
+  cmd.AddValue ("strategy", "Handover strategy: Beacon or Predictive (kinematics)", strategy);
+  cmd.AddValue ("loadAware", "Weigh the RSU load advertised in the beacons", loadAware);
+  cmd.AddValue ("traffic", "Vehicle to SRV1 traffic: None, Udp or Tcp (enables backhaulRoutes)",
+                traffic);
+  cmd.AddValue ("trafficMode", "Uplink at uplinkRate (Cbr) or as fast as possible (Bulk)",
+                trafficMode);
+  cmd.AddValue ("uplinkRate", "Uplink rate per vehicle in Cbr mode", uplinkRate);
+  cmd.AddValue ("downlinkRate", "UDP downlink rate per vehicle (0bps: none)", downlinkRate);
+  cmd.AddValue ("multiChannel", "Hellos and DHCP on the CCH, data on per-RSU service channels",
+                multiChannel);
+  cmd.AddValue ("parkedMode", "Vehicles at a stop: Active, Sleep, Reduced or Passive", parkedMode);
   cmd.Parse (argc, argv);
+  if (traffic != "None" && !backhaulRoutes)
+    {
+      // without host routes the vehicles have no default route and SRV1 no way back
+      std::cout << "--traffic needs the backhaul routes, enabling --backhaulRoutes" << std::endl;
+      backhaulRoutes = true;
+    }
+  Config::SetDefault ("ns3::BeaconSearchNet::ParkedMode", StringValue (parkedMode));
+  Config::SetDefault ("ns3::BeaconSearchNet::Strategy", StringValue (strategy));
+  Config::SetDefault ("ns3::BeaconSearchNet::LoadAware", BooleanValue (loadAware));
+  Config::SetDefault ("ns3::BeaconSearchNet::MakeBeforeBreak", BooleanValue (makeBeforeBreak));
+  Config::SetDefault ("ns3::BackhaulRouting::Forwarding", BooleanValue (forwarding));
+  Config::SetDefault ("ns3::BeaconRsuNet::TimingWheel", BooleanValue (timingWheel));
+  Config::SetDefault ("ns3::BeaconSearchNet::TimingWheel", BooleanValue (timingWheel));
   if (verbose)
     {
-      LogComponentEnable ("TraciClient", LOG_LEVEL_INFO);
+      LogComponentEnable ("vanet-sumo-client", LOG_LEVEL_INFO);
       ///LogComponentEnable ("TrafficControlApplication", LOG_LEVEL_INFO);
       LogComponentEnable ("vanet-example-simple", LOG_LEVEL_INFO);
 
@@ -115,6 +210,11 @@ main (int argc, char *argv[])
   NetDeviceContainer wifiDevicesArea5 = wifi80211p.Install (wifiPhy, wifi80211pMac, RSU5);
   NetDeviceContainer wifiDevicesVehicles =
       wifi80211p.Install (wifiPhy, wifi80211pMac, nodesVehicles);
+  // second radio on the CCH, after the data radio so that interface 1 stays the data one
+  NodeContainer rsus (NodeContainer (RSU1, RSU2), NodeContainer (RSU3, RSU4), NodeContainer (RSU5));
+  if (multiChannel)
+    RsuDeploymentHelper::InstallControlRadio (wifi80211p, wifiPhy, wifi80211pMac,
+                                              NodeContainer (rsus, nodesVehicles));
 
   NetDeviceContainer p2pDevices1 = p2p.Install (NodeContainer (RSU1, RSU2));
   NetDeviceContainer p2pDevices2 = p2p.Install (NodeContainer (RSU1, RSU3));
@@ -163,9 +263,17 @@ main (int argc, char *argv[])
   Ipv4Address ipAddr;
   Ptr<Ipv4StaticRouting> Ipv4stat;
 
-  ipv4 = RSU2->GetObject<Ipv4> ();
-  Ipv4stat = helper.GetStaticRouting (ipv4);
-  Ipv4stat->SetDefaultRoute ("189.10.10.1", 1);
+  // RSU2-5 and the server reach everything through the hub RSU1
+  Ptr<NetDevice> uplinks[] = {p2pDevices1.Get (1), p2pDevices2.Get (1), p2pDevices3.Get (1),
+                              p2pDevices4.Get (1), p2pDevices5.Get (1)};
+  const char *hubAddresses[] = {"189.10.10.1", "189.10.10.5", "189.10.10.9", "189.10.10.13",
+                                "189.10.10.17"};
+  for (size_t i = 0; i < 5; i++)
+    {
+      ipv4 = uplinks[i]->GetNode ()->GetObject<Ipv4> ();
+      Ipv4stat = helper.GetStaticRouting (ipv4);
+      Ipv4stat->SetDefaultRoute (hubAddresses[i], ipv4->GetInterfaceForDevice (uplinks[i]));
+    }
 
   /*** 7. Setup Mobility and position node pool ***/
   MobilityHelper mobility;
@@ -189,9 +297,11 @@ main (int argc, char *argv[])
   nodeCounter++;
   SRV1->GetObject<MobilityModel> ()->SetPosition (Vector (200, 100, 0));
   nodeCounter++;
+  if (multiChannel)
+    RsuDeploymentHelper::SpreadServiceChannels (rsus);
 
   /*** 8. Setup Traci and start SUMO ***/
-  Ptr<TraciClient> sumoClient = CreateObject<TraciClient> ();
+  Ptr<VanetSumoClient> sumoClient = CreateObject<VanetSumoClient> ();
   sumoClient->SetAttribute ("SumoConfigPath",
                             StringValue ("contrib/vanetsim/traces/grid-map/sim.sumocfg"));
   sumoClient->SetAttribute ("SumoBinaryPath",
@@ -207,6 +317,16 @@ main (int argc, char *argv[])
   sumoClient->SetAttribute ("SumoSeed", IntegerValue (10));
   sumoClient->SetAttribute ("SumoAdditionalCmdOptions", StringValue ("--verbose true"));
   sumoClient->SetAttribute ("SumoWaitForSocket", TimeValue (Seconds (1.0)));
+  // warm start: ns-3 time 0 is the snapshot time, the apps still start 5 s later
+  sumoClient->SetAttribute ("LoadStateFile", StringValue (loadState));
+  sumoClient->SetAttribute ("SaveStateFile", StringValue (saveState));
+  sumoClient->SetAttribute ("SaveStateTime", TimeValue (Seconds (saveStateTime)));
+  if (parkedMode != "Active")
+    {
+      sumoClient->SetAttribute ("TrackStops", BooleanValue (true));
+      sumoClient->TraceConnectWithoutContext ("VehicleStopped",
+                                              MakeCallback (&SuspendWhileParked));
+    }
 
   // callback function for node creation
   std::function<Ptr<Node> ()> setupNewWifiNode = [&] () -> Ptr<Node> {
@@ -225,8 +345,14 @@ main (int argc, char *argv[])
     return includedNode;
   };
 
+  // routes back to the vehicles, updated on the old and new path at each handover
+  Ptr<BackhaulRouting> backhaulRouting = CreateObject<BackhaulRouting> ();
+
   // callback function for node shutdown
-  std::function<void (Ptr<Node>)> shutdownWifiNode = [] (Ptr<Node> exNode) {
+  std::function<void (Ptr<Node>)> shutdownWifiNode = [backhaulRouting] (Ptr<Node> exNode) {
+    // the host routes and the forwarding of a departed vehicle go away with it
+    backhaulRouting->Detach (exNode);
+
     // stop all applications
     ///Ptr<VehicleSpeedControl> vehicleSpeedControl = exNode->GetApplication(0)->GetObject<VehicleSpeedControl>();
     ///if(vehicleSpeedControl)
@@ -237,6 +363,12 @@ main (int argc, char *argv[])
     mob->SetPosition (Vector (-100.0 + (rand () % 25), 320.0 + (rand () % 25),
                               250.0)); // rand() for visualization purposes
 
+    // stop the benchmark traffic until the node gets an address again
+    for (uint32_t i = 0; i < exNode->GetNApplications (); i++)
+      if (Ptr<VanetTrafficClient> client =
+              DynamicCast<VanetTrafficClient> (exNode->GetApplication (i)))
+        client->Detach ();
+
     // NOTE: further actions could be required for a save shut down!
   };
 
@@ -248,6 +380,9 @@ main (int argc, char *argv[])
       appBeaconSearchNet[i]->SetStopTime (Seconds (500));
     }
   CAR1->AddApplication (appBeaconSearchNet[0]);
+  if (handoverSpeed > 0)
+    appBeaconSearchNet[0]->TraceConnectWithoutContext (
+        "Handover", MakeBoundCallback (&SlowDownOnHandover, sumoClient, CAR1, handoverSpeed));
 
   Ptr<BeaconRsuNet> appBeaconRsuNet[5];
   for (size_t i = 0; i < 5; i++)
@@ -262,6 +397,53 @@ main (int argc, char *argv[])
   RSU4->AddApplication (appBeaconRsuNet[3]);
   RSU5->AddApplication (appBeaconRsuNet[4]);
 
+  if (backhaulRoutes)
+    {
+      backhaulRouting->SetHub (RSU1);
+      backhaulRouting->AddRsus (rsus);
+      backhaulRouting->InstallAll ();
+    }
+
+  // vehicle to server traffic over the backhaul, the model's goodput benchmark
+  Ptr<VanetFlowStats> flowStats = CreateObject<VanetFlowStats> ();
+  if (traffic != "None")
+    {
+      Ptr<VanetTrafficServer> server = CreateObject<VanetTrafficServer> ();
+      server->SetAttribute ("DownlinkRate", DataRateValue (DataRate (downlinkRate)));
+      server->SetStartTime (Seconds (1));
+      server->SetStopTime (Seconds (500));
+      SRV1->AddApplication (server);
+
+      Ptr<VanetTrafficClient> client = CreateObject<VanetTrafficClient> ();
+      client->SetAttribute ("Remote", Ipv4AddressValue ("189.10.10.18"));
+      client->SetAttribute ("Protocol", StringValue (traffic));
+      client->SetAttribute ("Mode", StringValue (trafficMode));
+      client->SetAttribute ("DataRate", DataRateValue (DataRate (uplinkRate)));
+      client->SetStartTime (Seconds (5));
+      client->SetStopTime (Seconds (500));
+      CAR1->AddApplication (client);
+      flowStats->InstallAll ();
+    }
+
+  // handover delays per RSU pair
+  Ptr<HandoverStats> handoverStats = CreateObject<HandoverStats> ();
+  handoverStats->InstallAll ();
+
+  // cheap structured tracing instead of LOG_LEVEL_ALL
+  Ptr<VanetEventLog> eventLog = CreateObject<VanetEventLog> ();
+  if (enableEventLog)
+    eventLog->InstallAll ();
+
+  // per-vehicle, per-second columnar results
+  Ptr<ResultsSampler> resultsSampler = CreateObject<ResultsSampler> ();
+  if (enableResults)
+    resultsSampler->InstallAll ();
+
+  // percentiles without storing raw traces
+  Ptr<KpiAggregator> kpi = CreateObject<KpiAggregator> ();
+  if (enableKpi)
+    kpi->InstallAll ();
+
   // start traci client with given function pointers
   sumoClient->SumoSetup (setupNewWifiNode, shutdownWifiNode);
   PrintNodeRoutingTable (0, 10.0);
@@ -272,6 +454,44 @@ main (int argc, char *argv[])
   Simulator::Stop (simulationTime);
 
   Simulator::Run ();
+  handoverStats->Print (std::cout);
+  if (enableKpi)
+    kpi->PrintReport (std::cout);
+  if (traffic != "None")
+    flowStats->Print (std::cout);
+  if (backhaulRoutes)
+    {
+      UintegerValue attachments, updates;
+      backhaulRouting->GetAttribute ("Attachments", attachments);
+      backhaulRouting->GetAttribute ("RouteUpdates", updates);
+      std::cout << "backhaul: " << attachments.Get () << " attachments, " << updates.Get ()
+                << " host route updates" << std::endl;
+      if (forwarding)
+        {
+          uint64_t buffered = 0, redirected = 0, drops = 0;
+          for (uint32_t i = 0; i < rsus.GetN (); i++)
+            {
+              UintegerValue value;
+              Ptr<VanetHostRouting> routing = VanetHostRouting::Get (rsus.Get (i));
+              routing->GetAttribute ("Buffered", value);
+              buffered += value.Get ();
+              routing->GetAttribute ("Redirected", value);
+              redirected += value.Get ();
+              routing->GetAttribute ("BufferDrops", value);
+              drops += value.Get ();
+            }
+          std::cout << "forwarding: " << buffered << " buffered, " << redirected
+                    << " redirected, " << drops << " dropped" << std::endl;
+        }
+    }
+  if (timingWheel)
+    {
+      UintegerValue fired, wakes;
+      TimingWheel::GetDefault ()->GetAttribute ("Fired", fired);
+      TimingWheel::GetDefault ()->GetAttribute ("Wakes", wakes);
+      std::cout << "timing wheel: " << fired.Get () << " timers fired in " << wakes.Get ()
+                << " events" << std::endl;
+    }
   Simulator::Destroy ();
 
   return 0;
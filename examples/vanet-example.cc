@@ -8,6 +8,13 @@
 #include "ns3/traci-module.h"
 #include "ns3/netanim-module.h"
 
+#include "../model/vanet-pcap-capture.h"
+#include "../model/vanet-anim-exporter.h"
+#include "../model/vanet-progress.h"
+#include "../model/vanet-memory-report.h"
+#include "../model/channel-heatmap.h"
+#include "../model/vanet-sumo-client.h"
+
 #include <functional>
 #include <stdlib.h>
 #include <stdio.h>
@@ -54,8 +61,7 @@ checkDisableNodes ()
       // communication range, but this is just for better visualization mode
       if ((ns3::Time) ns3::Simulator::Now ().GetSeconds () - it->second > 1)
         {
-          Ptr<ConstantPositionMobilityModel> mob =
-              exNode->GetObject<ConstantPositionMobilityModel> ();
+          Ptr<MobilityModel> mob = exNode->GetObject<MobilityModel> ();
           mob->SetPosition (Vector ((double) exNode->GetId (), -4000 - (rand () % 25), -5000.0));
           nodesDisable2Move.erase (it);
         }
@@ -90,6 +96,21 @@ main (int argc, char *argv[])
   uint32_t interestInterval = 1000;
   uint32_t simTime = 600;
   bool enablePcap = false;
+  double pcapRadius = 0;
+  uint32_t pcapSnapLen = 128;
+  bool enableAnim = false;
+  uint32_t animMaxNodes = 500;
+  uint32_t animPacketSampling = 100;
+  double progressInterval = 10;
+  bool enableMemoryReport = false;
+  bool enableHeatmap = false;
+  double heatmapCellSize = 20;
+  bool sumoPipelined = false;
+  std::string sumoBackend = "TraCI";
+  bool sumoAdaptive = false;
+  std::string sumoLoadState;
+  std::string sumoSaveState;
+  double sumoSaveStateTime = 300;
   bool enableLog = true;
   bool enableSumoGui = false;
 
@@ -104,6 +125,29 @@ main (int argc, char *argv[])
   cmd.AddValue ("i", "Interest interval (milliseconds)", interestInterval);
   cmd.AddValue ("s", "Simulation time (seconds)", simTime);
   cmd.AddValue ("pcap", "Enable PCAP", enablePcap);
+  cmd.AddValue ("pcap-radius", "Only capture frames sent within this distance of the RSU (0: all)",
+                pcapRadius);
+  cmd.AddValue ("pcap-snaplen", "Bytes kept per captured frame", pcapSnapLen);
+  cmd.AddValue ("anim", "Write a decimated NetAnim trace", enableAnim);
+  cmd.AddValue ("anim-nodes", "Maximum number of animated nodes", animMaxNodes);
+  cmd.AddValue ("anim-packets", "Animate 1 of every N frames (0: no packets)", animPacketSampling);
+  cmd.AddValue ("progress", "Wall-clock seconds between progress lines (0: off)",
+                progressInterval);
+  cmd.AddValue ("memory", "Write a memory breakdown every minute and at the end",
+                enableMemoryReport);
+  cmd.AddValue ("heatmap", "Write a per-area channel utilization heatmap", enableHeatmap);
+  cmd.AddValue ("heatmap-cell", "Heatmap cell size (m)", heatmapCellSize);
+  cmd.AddValue ("sumo-pipeline", "Step SUMO one interval ahead on a helper thread",
+                sumoPipelined);
+  cmd.AddValue ("sumo-backend", "TraCI (socket) or libsumo (in-process)", sumoBackend);
+  cmd.AddValue ("sumo-adaptive",
+                "Widen the SUMO sync interval while vehicles are predictable (dead reckoning)",
+                sumoAdaptive);
+  cmd.AddValue ("sumo-load-state", "Start SUMO from a state saved by a warm-up run",
+                sumoLoadState);
+  cmd.AddValue ("sumo-save-state", "Save the SUMO state at sumo-save-time into this file",
+                sumoSaveState);
+  cmd.AddValue ("sumo-save-time", "SUMO time (s) of the saved state", sumoSaveStateTime);
   cmd.AddValue ("log", "Enable Log", enableLog);
   cmd.AddValue ("sumo-gui", "Enable SUMO with graphical user interface", enableSumoGui);
   cmd.Parse (argc, argv);
@@ -138,7 +182,7 @@ main (int argc, char *argv[])
       //componentsLogLevelAll.push_back ("WifiPhy");
 
       std::vector<std::string> componentsLogLevelError;
-      componentsLogLevelError.push_back ("TraciClient");
+      componentsLogLevelError.push_back ("vanet-sumo-client");
 
       for (auto const &c : componentsLogLevelAll)
         {
@@ -219,10 +263,12 @@ main (int argc, char *argv[])
   positionAlloc->SetZ (-5000.0);
   positionAlloc->SetRho (25.0);
   mobility.SetPositionAllocator (positionAlloc);
-  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  // positions are extrapolated from the SUMO velocity between adaptive syncs
+  mobility.SetMobilityModel (sumoAdaptive ? "ns3::ConstantVelocityMobilityModel"
+                                          : "ns3::ConstantPositionMobilityModel");
   mobility.Install (nodePool);
   /*** setup Traci and start SUMO ***/
-  Ptr<TraciClient> sumoClient = CreateObject<TraciClient> ();
+  Ptr<VanetSumoClient> sumoClient = CreateObject<VanetSumoClient> ();
   sumoClient->SetAttribute (
       "SumoConfigPath", StringValue ("contrib/ndn4ivc/traces/" SUMO_SCENARIO_NAME "/sim.sumocfg"));
   sumoClient->SetAttribute ("SumoBinaryPath",
@@ -238,6 +284,20 @@ main (int argc, char *argv[])
   sumoClient->SetAttribute ("SumoSeed", IntegerValue (10));
   sumoClient->SetAttribute ("SumoAdditionalCmdOptions", StringValue ("--verbose true"));
   sumoClient->SetAttribute ("SumoWaitForSocket", TimeValue (Seconds (1.0)));
+  sumoClient->SetAttribute ("Pipelined", BooleanValue (sumoPipelined));
+  sumoClient->SetAttribute ("Backend", StringValue (sumoBackend));
+  sumoClient->SetAttribute ("AdaptiveSynch", BooleanValue (sumoAdaptive));
+  sumoClient->SetAttribute ("LoadStateFile", StringValue (sumoLoadState));
+  sumoClient->SetAttribute ("SaveStateFile", StringValue (sumoSaveState));
+  sumoClient->SetAttribute ("SaveStateTime", TimeValue (Seconds (sumoSaveStateTime)));
+
+  Ptr<VanetProgress> progress = CreateObject<VanetProgress> ();
+  if (progressInterval > 0)
+    {
+      progress->SetAttribute ("WallInterval", TimeValue (Seconds (progressInterval)));
+      progress->SetSumoClient (sumoClient);
+      progress->Start ();
+    }
 
   /** Define the callback function for dynamic node creation from 
    *  Simulation of Urban MObility - SUMO simulator (https://sumo.dlr.de)
@@ -256,6 +316,7 @@ main (int argc, char *argv[])
                                         << "] has initialized and the app installed!");
     Ptr<Node> includedNode = nodePool.Get (nodeCounter);
     nodeCounter++;
+    progress->NotifyVehicleAdded ();
     ///Ptr<ns3::ndn::ConsumerCbr> tmsConsumerApp = CreateObject<ns3::ndn::ConsumerCbr> ();
     ///tmsConsumerApp->SetAttribute ("Frequency", StringValue ("1"));
 
@@ -277,6 +338,7 @@ main (int argc, char *argv[])
   std::function<void (Ptr<Node>)> shutdownSumoVehicle = [&] (Ptr<Node> exNode) {
     NS_LOG_INFO ("Ns3SumoSetup: node [" << exNode->GetId ()
                                         << "] will be finished and disconnected!");
+    progress->NotifyVehicleRemoved ();
 
    /// Ptr<ns3::ndn::ConsumerCbr> tmsConsumerApp =
    ///     DynamicCast<ns3::ndn::ConsumerCbr> (exNode->GetApplication (0));
@@ -320,12 +382,48 @@ main (int argc, char *argv[])
   // MaxPitEntryLifetime: Maximum amount of time for which a router is willing to maintain a PIT entry
   //Config::Set ("/NodeList/*/$ns3::ndn::Pit/MaxPitEntryLifetime", TimeValue (Seconds (5)));
 
+  Ptr<VanetPcapCapture> pcapCapture = CreateObject<VanetPcapCapture> ();
+  if (enablePcap)
+    {
+      pcapCapture->SetAttribute ("SnapLen", UintegerValue (pcapSnapLen));
+      if (pcapRadius > 0)
+        pcapCapture->AddRsuArea (nodePool.Get (0), pcapRadius);
+      pcapCapture->Install (nodePool);
+    }
+
+  Ptr<VanetAnimExporter> animExporter = CreateObject<VanetAnimExporter> ();
+  if (enableAnim)
+    {
+      animExporter->SetAttribute ("MaxNodes", UintegerValue (animMaxNodes));
+      animExporter->SetAttribute ("PacketSampling", UintegerValue (animPacketSampling));
+      animExporter->SetNodeDescription (nodePool.Get (0), "RSU", 0, 0, 255);
+      animExporter->Start ();
+    }
+
+  Ptr<ChannelHeatmap> heatmap = CreateObject<ChannelHeatmap> ();
+  if (enableHeatmap)
+    {
+      heatmap->SetAttribute ("CellSize", DoubleValue (heatmapCellSize));
+      heatmap->Install (nodePool);
+    }
+
+  Ptr<VanetMemoryReport> memoryReport = CreateObject<VanetMemoryReport> ();
+  if (enableMemoryReport)
+    memoryReport->Start ();
+
   Simulator::Schedule (Seconds (1), &checkDisableNodes);
 
   sumoClient->SumoSetup (setupNewSumoVehicle, shutdownSumoVehicle);
   std::cout << YELLOW_CODE << BOLD_CODE << "Simulation is running: " END_CODE << std::endl;
   Simulator::Stop (Seconds (simTime));
   Simulator::Run ();
+  if (enableMemoryReport)
+    memoryReport->WriteReport ();
   std::cout << RED_CODE << BOLD_CODE << "Post simulation: " END_CODE << std::endl;
+  UintegerValue syncs;
+  sumoClient->GetAttribute ("Synchronizations", syncs);
+  std::cout << "SUMO synchronizations: " << syncs.Get ()
+            << ", max dead-reckoning error: " << sumoClient->GetMaxPositionError () << " m"
+            << std::endl;
   return 0;
 };
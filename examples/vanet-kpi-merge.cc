@@ -0,0 +1,51 @@
+/*
+ * Merges the KPI summaries written by ns3::KpiAggregator in several runs
+ * (e.g. a sweep over seeds) and prints the combined percentiles.
+ *
+ * ./waf --run "vanet-kpi-merge --files=run1.txt,run2.txt --output=merged.txt"
+ */
+#include "ns3/core-module.h"
+
+#include "../model/kpi-aggregator.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  std::string files ("");
+  std::string output ("");
+
+  CommandLine cmd;
+  cmd.AddValue ("files", "Comma separated KPI summaries", files);
+  cmd.AddValue ("output", "Write the merged summary to this file", output);
+  cmd.Parse (argc, argv);
+
+  Ptr<KpiAggregator> kpi = CreateObject<KpiAggregator> ();
+  std::istringstream list (files);
+  std::string file;
+  uint32_t nRuns = 0;
+  while (std::getline (list, file, ','))
+    {
+      if (!kpi->Load (file))
+        {
+          std::cerr << "Can't merge " << file << std::endl;
+          return 1;
+        }
+      nRuns++;
+    }
+
+  std::cout << "Merged " << nRuns << " runs" << std::endl;
+  kpi->PrintReport (std::cout);
+
+  if (!output.empty ())
+    {
+      std::ofstream os (output.c_str ());
+      kpi->Write (os);
+    }
+  return 0;
+}
@@ -0,0 +1,149 @@
+#include "ns3/log.h"
+#include "async-file-writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("async-file-writer");
+
+AsyncFileWriter::AsyncFileWriter ()
+    : m_bufferSize (0), m_maxPending (0), m_maxFiles (0), m_open (false), m_stop (false), m_file (0)
+{
+}
+
+AsyncFileWriter::~AsyncFileWriter ()
+{
+  Close ();
+}
+
+void
+AsyncFileWriter::Open (std::string fileName, uint32_t bufferSize, uint32_t maxPending,
+                       uint32_t maxFiles)
+{
+  NS_ABORT_MSG_IF (m_open, "AsyncFileWriter is already open");
+
+  m_bufferSize = bufferSize;
+  m_maxPending = std::max (maxPending, 1u);
+  m_maxFiles = maxFiles;
+  m_buffer.reserve (m_bufferSize);
+  m_stop = false;
+
+  // open in the caller so a bad path fails right away
+  OpenFile (fileName);
+  m_open = true;
+  m_thread = std::thread (&AsyncFileWriter::Run, this);
+}
+
+bool
+AsyncFileWriter::IsOpen () const
+{
+  return m_open;
+}
+
+void
+AsyncFileWriter::OpenFile (const std::string &fileName)
+{
+  if (m_file)
+    std::fclose (m_file);
+
+  m_file = std::fopen (fileName.c_str (), "wb");
+  if (!m_file)
+    NS_FATAL_ERROR ("Can't open " << fileName);
+
+  m_files.push_back (fileName);
+  while (m_maxFiles && m_files.size () > m_maxFiles)
+    {
+      std::remove (m_files.front ().c_str ());
+      m_files.pop_front ();
+    }
+}
+
+void
+AsyncFileWriter::Append (const void *data, size_t size)
+{
+  m_buffer.append ((const char *) data, size);
+  if (m_buffer.size () >= m_bufferSize)
+    Flush ();
+}
+
+void
+AsyncFileWriter::Push (Job &job)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  m_cv.wait (lock, [this] { return m_jobs.size () < m_maxPending; });
+  m_jobs.push_back (Job ());
+  m_jobs.back ().data.swap (job.data);
+  m_jobs.back ().rotateTo.swap (job.rotateTo);
+  m_cv.notify_all ();
+}
+
+void
+AsyncFileWriter::Flush ()
+{
+  if (!m_open || m_buffer.empty ())
+    return;
+
+  Job job;
+  job.data.swap (m_buffer);
+  Push (job);
+  m_buffer.reserve (m_bufferSize);
+}
+
+void
+AsyncFileWriter::Rotate (std::string fileName)
+{
+  if (!m_open)
+    return;
+
+  Flush ();
+  Job job;
+  job.rotateTo = fileName;
+  Push (job);
+}
+
+void
+AsyncFileWriter::Run ()
+{
+  while (true)
+    {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_cv.wait (lock, [this] { return m_stop || !m_jobs.empty (); });
+        if (m_jobs.empty ())
+          break; // stopped and drained
+        job.data.swap (m_jobs.front ().data);
+        job.rotateTo.swap (m_jobs.front ().rotateTo);
+        m_jobs.pop_front ();
+        m_cv.notify_all ();
+      }
+
+      if (!job.rotateTo.empty ())
+        OpenFile (job.rotateTo);
+      if (!job.data.empty ())
+        std::fwrite (job.data.data (), 1, job.data.size (), m_file);
+    }
+}
+
+void
+AsyncFileWriter::Close ()
+{
+  if (!m_open)
+    return;
+
+  Flush ();
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all ();
+  m_thread.join ();
+
+  if (m_file)
+    std::fclose (m_file);
+  m_file = 0;
+  m_open = false;
+}
+
+} // namespace ns3
@@ -0,0 +1,74 @@
+#ifndef ASYNC_FILE_WRITER_H
+#define ASYNC_FILE_WRITER_H
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace ns3 {
+
+/**
+ * Appends data to a file from a helper thread.
+ *
+ * The simulation thread fills a buffer with Append; full buffers are handed
+ * to the writer thread, which does the fwrite. At most MaxPending buffers
+ * wait for the disk, after that Append blocks so memory stays bounded.
+ * Rotate switches to a new file once the data queued before it is written;
+ * with a file limit the oldest rotated file is removed.
+ */
+class AsyncFileWriter
+{
+public:
+  AsyncFileWriter ();
+  ~AsyncFileWriter ();
+
+  /**
+   * \param fileName first output file
+   * \param bufferSize bytes collected before a buffer is handed to the writer thread
+   * \param maxPending buffers allowed to wait for the disk
+   * \param maxFiles files kept when rotating (0: keep all)
+   */
+  void Open (std::string fileName, uint32_t bufferSize = 1 << 20, uint32_t maxPending = 8,
+             uint32_t maxFiles = 0);
+  bool IsOpen () const;
+
+  void Append (const void *data, size_t size);
+  /** Hand the current buffer to the writer thread */
+  void Flush ();
+  /** Continue in a new file */
+  void Rotate (std::string fileName);
+  /** Write everything and stop the writer thread */
+  void Close ();
+
+private:
+  struct Job
+  {
+    std::string data;
+    std::string rotateTo; /**< not empty: open this file before writing data */
+  };
+
+  void Push (Job &job);
+  void Run ();
+  void OpenFile (const std::string &fileName);
+
+  std::string m_buffer; /**< Filled by the simulation thread */
+  uint32_t m_bufferSize;
+  uint32_t m_maxPending;
+  uint32_t m_maxFiles;
+  bool m_open;
+
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<Job> m_jobs; /**< Buffers waiting for the writer thread */
+  bool m_stop;
+
+  /* writer thread only */
+  std::FILE *m_file;
+  std::deque<std::string> m_files; /**< Files written, oldest first */
+};
+} // namespace ns3
+#endif
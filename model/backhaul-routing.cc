@@ -0,0 +1,283 @@
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/node-list.h"
+#include "ns3/wifi-net-device.h"
+#include "backhaul-routing.h"
+
+#include <cstdlib>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("backhaul-routing");
+NS_OBJECT_ENSURE_REGISTERED (BackhaulRouting);
+
+TypeId
+BackhaulRouting::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::BackhaulRouting")
+          .SetParent<Object> ()
+          .AddConstructor<BackhaulRouting> ()
+          .AddAttribute ("Forwarding", "Buffer and forward the packets of a departing vehicle",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&BackhaulRouting::m_forwarding),
+                         MakeBooleanChecker ())
+          .AddAttribute ("BufferSize", "Packets held per departing vehicle", UintegerValue (64),
+                         MakeUintegerAccessor (&BackhaulRouting::m_bufferSize),
+                         MakeUintegerChecker<uint32_t> ())
+          .AddAttribute ("BufferTimeout", "Drop the held packets if no new address by then",
+                         TimeValue (Seconds (2)),
+                         MakeTimeAccessor (&BackhaulRouting::m_bufferTimeout),
+                         MakeTimeChecker ())
+          .AddAttribute ("ForwardTime", "Redirect the old address this long after a handover",
+                         TimeValue (Seconds (2)),
+                         MakeTimeAccessor (&BackhaulRouting::m_forwardTime),
+                         MakeTimeChecker ())
+          .AddAttribute ("Attachments", "Vehicle addresses routed through a new RSU",
+                         TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&BackhaulRouting::m_attachments),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("RouteUpdates", "Host routes added or removed", TypeId::ATTR_GET,
+                         UintegerValue (0), MakeUintegerAccessor (&BackhaulRouting::m_routeUpdates),
+                         MakeUintegerChecker<uint64_t> ());
+  return tid;
+}
+
+TypeId
+BackhaulRouting::GetInstanceTypeId () const
+{
+  return BackhaulRouting::GetTypeId ();
+}
+
+BackhaulRouting::BackhaulRouting ()
+    : m_forwarding (false), m_bufferSize (64), m_attachments (0), m_routeUpdates (0)
+{
+}
+
+BackhaulRouting::~BackhaulRouting ()
+{
+}
+
+void
+BackhaulRouting::SetHub (Ptr<Node> hub)
+{
+  m_hub = hub;
+}
+
+static int32_t
+GetWifiInterface (Ptr<Node> node)
+{
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  for (uint32_t i = 0; i < node->GetNDevices (); i++)
+    if (DynamicCast<WifiNetDevice> (node->GetDevice (i)))
+      return ipv4->GetInterfaceForDevice (node->GetDevice (i));
+  return -1;
+}
+
+void
+BackhaulRouting::AddRsu (Ptr<Node> rsu)
+{
+  NS_ABORT_MSG_IF (!m_hub, "BackhaulRouting needs a hub before the RSUs");
+  int32_t wifi = GetWifiInterface (rsu);
+  NS_ABORT_MSG_IF (wifi < 0, "RSU " << rsu->GetId () << " has no Wi-Fi interface");
+
+  std::vector<Hop> path;
+  Hop own;
+  own.routing = VanetHostRouting::Get (rsu);
+  own.gateway = Ipv4Address::GetAny ();
+  own.interface = wifi;
+  path.push_back (own);
+
+  // climb the default routes; each upstream node routes back through the link we came from
+  Ipv4StaticRoutingHelper helper;
+  Ptr<Node> node = rsu;
+  while (node != m_hub)
+    {
+      NS_ABORT_MSG_IF (path.size () > 64, "No path from RSU " << rsu->GetId () << " to the hub");
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      Ipv4RoutingTableEntry def = helper.GetStaticRouting (ipv4)->GetDefaultRoute ();
+      NS_ABORT_MSG_IF (def.GetGateway () == Ipv4Address::GetAny (),
+                       "Node " << node->GetId () << " has no default route towards the hub");
+
+      Ptr<Node> up;
+      int32_t upInterface = -1;
+      for (NodeList::Iterator n = NodeList::Begin (); n != NodeList::End () && upInterface < 0; ++n)
+        {
+          Ptr<Ipv4> candidate = (*n)->GetObject<Ipv4> ();
+          if (candidate && (upInterface = candidate->GetInterfaceForAddress (def.GetGateway ())) >= 0)
+            up = *n;
+        }
+      NS_ABORT_MSG_IF (!up, "No node owns " << def.GetGateway ());
+
+      Hop hop;
+      hop.routing = VanetHostRouting::Get (up);
+      hop.gateway = ipv4->GetAddress (def.GetInterface (), 0).GetLocal ();
+      hop.interface = upInterface;
+      path.push_back (hop);
+      node = up;
+    }
+  NS_LOG_INFO ("RSU " << rsu->GetId () << ": " << path.size () << " hops to the hub");
+  m_paths[rsu->GetId ()] = path;
+}
+
+void
+BackhaulRouting::AddRsus (NodeContainer rsus)
+{
+  for (uint32_t i = 0; i < rsus.GetN (); i++)
+    AddRsu (rsus.Get (i));
+}
+
+void
+BackhaulRouting::Attach (Ptr<Node> vehicle, Ipv4Address address, uint32_t rsuId)
+{
+  auto path = m_paths.find (rsuId);
+  if (path == m_paths.end ())
+    {
+      NS_LOG_WARN ("RSU " << rsuId << " is not part of the backhaul");
+      return;
+    }
+
+  bool redirect = false;
+  Attachment old;
+  auto it = m_attached.find (vehicle->GetId ());
+  if (it != m_attached.end ())
+    {
+      if (it->second.address == address && it->second.rsuId == rsuId)
+        return;
+      if (m_forwarding && it->second.address != address)
+        {
+          redirect = true;
+          old = it->second;
+          m_attached.erase (it);
+        }
+      else
+        Detach (vehicle);
+    }
+
+  for (const auto &hop : path->second)
+    hop.routing->AddHostRoute (address, hop.gateway, hop.interface);
+  m_routeUpdates += path->second.size ();
+  m_attachments++;
+  m_attached[vehicle->GetId ()] = {address, rsuId};
+  SetVehicleDefaultRoute (vehicle, NodeList::GetNode (rsuId));
+
+  if (redirect)
+    {
+      // after the new path exists: Redirect sends the held packets right away, and an old
+      // RSU without a default route (the hub) can only reach the new address through it
+      m_paths[old.rsuId].front ().routing->Redirect (old.address, address, m_forwardTime);
+      // keep the old path until the packets in flight on it are redirected
+      Simulator::Schedule (m_forwardTime, &BackhaulRouting::RemoveOldRoutes, this,
+                           vehicle->GetId (), old);
+    }
+  NS_LOG_INFO ("Vehicle " << vehicle->GetId () << " " << address << " via RSU " << rsuId);
+}
+
+void
+BackhaulRouting::Detach (Ptr<Node> vehicle)
+{
+  auto it = m_attached.find (vehicle->GetId ());
+  if (it == m_attached.end ())
+    return;
+  RemoveRoutes (it->second);
+  m_attached.erase (it);
+}
+
+void
+BackhaulRouting::RemoveRoutes (const Attachment &attachment)
+{
+  const std::vector<Hop> &path = m_paths[attachment.rsuId];
+  path.front ().routing->ClearRedirect (attachment.address);
+  for (const auto &hop : path)
+    if (hop.routing->RemoveHostRoute (attachment.address))
+      m_routeUpdates++;
+}
+
+void
+BackhaulRouting::RemoveOldRoutes (uint32_t vehicleId, Attachment old)
+{
+  auto it = m_attached.find (vehicleId);
+  if (it != m_attached.end () && it->second.address == old.address)
+    return;
+  RemoveRoutes (old);
+}
+
+void
+BackhaulRouting::NotifyRequest (std::string context, uint32_t vehicleId, Ipv4Address rsuAddr)
+{
+  if (!m_forwarding)
+    return;
+  auto it = m_attached.find (vehicleId);
+  if (it == m_attached.end () || it->second.rsuId == (uint32_t) std::atoi (context.c_str ()))
+    return;
+
+  // the pre-acquisition of a make before break handover keeps the vehicle on its RSU
+  Ptr<Node> vehicle = NodeList::GetNode (vehicleId);
+  for (uint32_t i = 0; i < vehicle->GetNApplications (); i++)
+    {
+      Ptr<BeaconSearchNet> app = DynamicCast<BeaconSearchNet> (vehicle->GetApplication (i));
+      if (app && !app->IsHandoverPending ())
+        return;
+    }
+  NS_LOG_INFO ("Vehicle " << vehicleId << " leaving RSU " << it->second.rsuId << ": buffering "
+                          << it->second.address);
+  m_paths[it->second.rsuId].front ().routing->Buffer (it->second.address, m_bufferSize,
+                                                      m_bufferTimeout);
+}
+
+void
+BackhaulRouting::SetVehicleDefaultRoute (Ptr<Node> vehicle, Ptr<Node> rsu)
+{
+  int32_t wifi = GetWifiInterface (vehicle);
+  if (wifi < 0)
+    return;
+  const Hop &own = m_paths[rsu->GetId ()].front ();
+  Ipv4Address rsuAddress = rsu->GetObject<Ipv4> ()->GetAddress (own.interface, 0).GetLocal ();
+
+  // a vehicle has a handful of routes: replace the old default one
+  Ipv4StaticRoutingHelper helper;
+  Ptr<Ipv4StaticRouting> routing = helper.GetStaticRouting (vehicle->GetObject<Ipv4> ());
+  for (uint32_t i = routing->GetNRoutes (); i-- > 0;)
+    if (routing->GetRoute (i).IsDefault ())
+      routing->RemoveRoute (i);
+  routing->SetDefaultRoute (rsuAddress, wifi);
+}
+
+void
+BackhaulRouting::NotifyOffer (std::string context, uint32_t rsuId, Ipv4Address address)
+{
+  Attach (NodeList::GetNode (std::atoi (context.c_str ())), address, rsuId);
+}
+
+void
+BackhaulRouting::Install (Ptr<BeaconSearchNet> app)
+{
+  app->TraceConnect ("DhcpOfferRx", std::to_string (app->GetNode ()->GetId ()),
+                     MakeCallback (&BackhaulRouting::NotifyOffer, this));
+}
+
+void
+BackhaulRouting::Install (Ptr<BeaconRsuNet> app)
+{
+  app->TraceConnect ("DhcpRequestRx", std::to_string (app->GetNode ()->GetId ()),
+                     MakeCallback (&BackhaulRouting::NotifyRequest, this));
+}
+
+void
+BackhaulRouting::InstallAll ()
+{
+  for (NodeList::Iterator n = NodeList::Begin (); n != NodeList::End (); ++n)
+    for (uint32_t i = 0; i < (*n)->GetNApplications (); i++)
+      {
+        Ptr<Application> app = (*n)->GetApplication (i);
+        if (Ptr<BeaconSearchNet> search = DynamicCast<BeaconSearchNet> (app))
+          Install (search);
+        else if (Ptr<BeaconRsuNet> rsu = DynamicCast<BeaconRsuNet> (app))
+          Install (rsu);
+      }
+}
+
+} // namespace ns3
@@ -0,0 +1,99 @@
+#ifndef BACKHAUL_ROUTING_H
+#define BACKHAUL_ROUTING_H
+#include "ns3/object.h"
+#include "ns3/node-container.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "beacon-rsu-net.h"
+#include "beacon-search-net.h"
+#include "vanet-host-routing.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Keeps the backhaul routes to vehicles up to date across handovers.
+ *
+ * The path of an RSU is found once, by following the static default
+ * routes from the RSU up to the hub. When a vehicle takes an address from
+ * an RSU (the DhcpOfferRx trace of its BeaconSearchNet), host routes to
+ * that address are added on every node of the RSU's path, and the routes
+ * to its previous address are removed from the previous path. A handover
+ * costs O(path length) hash table updates instead of a routing rebuild.
+ * The vehicle's default route is moved to the new RSU as well.
+ *
+ * With Forwarding, the old RSU bridges the handover: when the vehicle's
+ * DHCP request reaches another RSU during a break before make handover,
+ * the old RSU holds the packets for the old address (at most BufferSize,
+ * for BufferTimeout). Once the new address is known, the held packets and
+ * those still arriving for the old address during ForwardTime are
+ * re-addressed and sent over the backhaul to the new RSU; the routes to
+ * the old address are removed after ForwardTime.
+ */
+class BackhaulRouting : public ns3::Object
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  BackhaulRouting ();
+  ~BackhaulRouting ();
+
+  /** Node where the RSU paths end, e.g. the gateway to the servers */
+  void SetHub (Ptr<Node> hub);
+  /** Find the path of an RSU; its static default routes must lead to the hub */
+  void AddRsu (Ptr<Node> rsu);
+  void AddRsus (NodeContainer rsus);
+
+  /** Route a vehicle address through an RSU, dropping its previous routes */
+  void Attach (Ptr<Node> vehicle, Ipv4Address address, uint32_t rsuId);
+  /** Remove the routes of a vehicle, e.g. when it leaves the simulation */
+  void Detach (Ptr<Node> vehicle);
+
+  /** Follow the address offers of one vehicle app */
+  void Install (Ptr<BeaconSearchNet> app);
+  /** Watch the DHCP requests of one RSU app for departing vehicles */
+  void Install (Ptr<BeaconRsuNet> app);
+  /** Follow every BeaconSearchNet and BeaconRsuNet installed so far */
+  void InstallAll ();
+
+private:
+  /** Route installed on one node of an RSU path */
+  struct Hop
+  {
+    Ptr<VanetHostRouting> routing;
+    Ipv4Address gateway; /**< 0.0.0.0 on the RSU itself: the vehicle is on link */
+    uint32_t interface;
+  };
+
+  struct Attachment
+  {
+    Ipv4Address address;
+    uint32_t rsuId;
+  };
+
+  /** DhcpOfferRx of a vehicle app, the context is the vehicle node id */
+  void NotifyOffer (std::string context, uint32_t rsuId, Ipv4Address address);
+  /** DhcpRequestRx of an RSU app, the context is the RSU node id */
+  void NotifyRequest (std::string context, uint32_t vehicleId, Ipv4Address rsuAddr);
+  void RemoveRoutes (const Attachment &attachment);
+  /** Scheduled end of the forwarding, unless the vehicle got the address back */
+  void RemoveOldRoutes (uint32_t vehicleId, Attachment old);
+  void SetVehicleDefaultRoute (Ptr<Node> vehicle, Ptr<Node> rsu);
+
+  Ptr<Node> m_hub;
+  std::map<uint32_t, std::vector<Hop>> m_paths; /**< RSU node id -> hops, RSU first */
+  std::map<uint32_t, Attachment> m_attached; /**< Vehicle node id -> current attachment */
+
+  bool m_forwarding; /**< Bridge handovers through the old RSU */
+  uint32_t m_bufferSize; /**< Packets held per departing vehicle */
+  Time m_bufferTimeout; /**< Drop the held packets if no new address by then */
+  Time m_forwardTime; /**< Redirect the old address this long after the new one */
+
+  uint64_t m_attachments; /**< Attach calls that changed a route */
+  uint64_t m_routeUpdates; /**< Host routes added or removed */
+};
+} // namespace ns3
+#endif
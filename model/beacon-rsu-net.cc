@@ -5,6 +5,12 @@
 #include "custom-data-tag.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/internet-module.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
+#include "ns3/wifi-mac-queue.h"
+#include "ns3/wifi-phy-state-helper.h"
+#include "timing-wheel.h"
 
 #include <bitset>
 #include <bits/stdc++.h>
@@ -26,9 +32,38 @@ BeaconRsuNet::GetTypeId ()
           .AddConstructor<BeaconRsuNet> ()
           .AddAttribute ("Interval", "Broadcast Interval", TimeValue (MilliSeconds (1000)),
                          MakeTimeAccessor (&BeaconRsuNet::m_broadcast_time), MakeTimeChecker ())
+          .AddAttribute ("TimingWheel", "Drive the periodic timer from the shared TimingWheel",
+                         BooleanValue (false), MakeBooleanAccessor (&BeaconRsuNet::m_timingWheel),
+                         MakeBooleanChecker ())
           .AddAttribute ("Pktsize", "Packet Size", IntegerValue (1000),
                          MakeIntegerAccessor (&BeaconRsuNet::m_packetSize),
-                         MakeIntegerChecker<uint32_t> ());
+                         MakeIntegerChecker<uint32_t> ())
+          .AddAttribute ("BeaconsSent", "Number of hello messages sent", TypeId::ATTR_GET,
+                         UintegerValue (0), MakeUintegerAccessor (&BeaconRsuNet::m_beaconsSent),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("DhcpRequestsReceived", "Number of DHCP requests addressed to this RSU",
+                         TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&BeaconRsuNet::m_dhcpRequestsReceived),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("DhcpOffersSent", "Number of DHCP offers sent", TypeId::ATTR_GET,
+                         UintegerValue (0), MakeUintegerAccessor (&BeaconRsuNet::m_dhcpOffersSent),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("DhcpReleasesReceived", "Number of leases given back by the vehicles",
+                         TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&BeaconRsuNet::m_dhcpReleasesReceived),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddTraceSource ("LeasesInUse", "Number of addresses leased from the DHCP pool",
+                           MakeTraceSourceAccessor (&BeaconRsuNet::m_leasesInUse),
+                           "ns3::TracedValueCallback::Uint32")
+          .AddTraceSource ("BeaconTx", "A hello message has been sent",
+                           MakeTraceSourceAccessor (&BeaconRsuNet::m_beaconTxTrace),
+                           "ns3::Packet::TracedCallback")
+          .AddTraceSource ("DhcpRequestRx", "A DHCP request addressed to this RSU was received",
+                           MakeTraceSourceAccessor (&BeaconRsuNet::m_dhcpRequestRxTrace),
+                           "ns3::BeaconRsuNet::DhcpTracedCallback")
+          .AddTraceSource ("DhcpOfferTx", "A DHCP offer has been sent",
+                           MakeTraceSourceAccessor (&BeaconRsuNet::m_dhcpOfferTxTrace),
+                           "ns3::BeaconRsuNet::DhcpTracedCallback");
   return tid;
 }
 
@@ -39,6 +74,13 @@ BeaconRsuNet::GetInstanceTypeId () const
 }
 
 BeaconRsuNet::BeaconRsuNet ()
+    : m_timingWheel (false),
+      m_broadcastTimer (0),
+      m_beaconsSent (0),
+      m_dhcpRequestsReceived (0),
+      m_dhcpOffersSent (0),
+      m_dhcpReleasesReceived (0),
+      m_leasesInUse (0)
 {
 }
 
@@ -58,30 +100,54 @@ BeaconRsuNet::StartApplication ()
       Ptr<NetDevice> dev = n->GetDevice (i);
       //NS_LOG_INFO ("dev->GetInstanceTypeId ().GetName () = " << dev->GetInstanceTypeId ().GetName ());
 
+      if (dev->GetInstanceTypeId () == WifiNetDevice::GetTypeId () && m_wifiDevice)
+        {
+          // multi-channel: the second radio, on the CCH
+          m_controlDevice = DynamicCast<WifiNetDevice> (dev);
+          break;
+        }
       if (dev->GetInstanceTypeId () == WifiNetDevice::GetTypeId ())
         {
           m_wifiDevice = DynamicCast<WifiNetDevice> (dev);
-          //ReceivePacket will be called when a packet is received
-          dev->SetReceiveCallback (MakeCallback (&BeaconRsuNet::ReceivePacket, this));
-
-          /*
-            If you want promiscous receive callback, connect to this trace. 
-            For every packet received, both functions ReceivePacket & PromiscRx will be called. with PromicRx being called first!
-            */
           Ptr<WifiPhy> phy = m_wifiDevice->GetPhy (); //default, there's only one PHY
-          phy->TraceConnectWithoutContext ("MonitorSnifferRx",
-                                           MakeCallback (&BeaconRsuNet::PromiscRx, this));
-          break;
+
+          // load of the service channel, advertised in the hello messages
+          PointerValue ptr;
+          phy->GetAttribute ("State", ptr);
+          ptr.Get<WifiPhyStateHelper> ()->TraceConnectWithoutContext (
+              "State", MakeCallback (&BeaconRsuNet::PhyState, this));
+          if (m_wifiDevice->GetMac ()->GetAttributeFailSafe ("Txop", ptr))
+            m_txop = ptr.Get<Txop> ();
+          m_lastBeacon = Now ();
         }
     }
   if (m_wifiDevice)
     {
+      if (!m_controlDevice)
+        m_controlDevice = m_wifiDevice;
+      //ReceivePacket will be called when a control message is received; a handler, not the
+      //device receive callback, which belongs to the node and feeds IPv4 and ARP
+      GetNode ()->RegisterProtocolHandler (MakeCallback (&BeaconRsuNet::ReceivePacket, this),
+                                           0xFE, m_controlDevice);
+
+      /*
+        If you want promiscous receive callback, connect to this trace. 
+        For every packet received, both functions ReceivePacket & PromiscRx will be called. with PromicRx being called first!
+        */
+      m_controlDevice->GetPhy ()->TraceConnectWithoutContext (
+          "MonitorSnifferRx", MakeCallback (&BeaconRsuNet::PromiscRx, this));
+
       //Let's create a bit of randomness with the first broadcast packet time to avoid collision
       Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
       Time random_offset = MicroSeconds (rand->GetValue (50, 200));
 
-      Simulator::Schedule (m_broadcast_time + random_offset, &BeaconRsuNet::BroadcastInformation,
-                           this);
+      if (m_timingWheel)
+        m_broadcastTimer = TimingWheel::GetDefault ()->Schedule (
+            m_broadcast_time + random_offset, m_broadcast_time,
+            MakeCallback (&BeaconRsuNet::BroadcastInformation, this));
+      else
+        m_broadcastEvent = Simulator::Schedule (m_broadcast_time + random_offset,
+                                                &BeaconRsuNet::BroadcastInformation, this);
     }
   else
     {
@@ -108,21 +174,67 @@ BeaconRsuNet::BroadcastInformation ()
   //timestamp is set in the default constructor of the CustomDataTag class as Simulator::Now()
   tag.SetIpAddr (ipAddr.Get ()); //RSU ip address
   tag.SetMask (iaddr.GetMask ().GetPrefixLength ()); //RSU
+  tag.SetServiceChannel (GetServiceChannel ());
+  tag.SetLeases (m_leasesInUse);
+  if (Now () > m_lastBeacon)
+    tag.SetChannelBusy (m_busyTime.GetSeconds () / (Now () - m_lastBeacon).GetSeconds ());
+  if (m_txop)
+    tag.SetQueueLength (m_txop->GetWifiMacQueue ()->GetNPackets ());
+  m_busyTime = Seconds (0);
+  m_lastBeacon = Now ();
   tag.PrepareHeaderHelloMessage ();
 
   //attach the tag to the packet
   packet->AddPacketTag (tag);
-  m_wifiDevice->Send (packet, Mac48Address::GetBroadcast (), 0xFE);
+  m_controlDevice->Send (packet, Mac48Address::GetBroadcast (), 0xFE);
+  m_beaconsSent++;
+  m_beaconTxTrace (packet);
   //Schedule next broadcast event
-  Simulator::Schedule (m_broadcast_time, &BeaconRsuNet::BroadcastInformation, this);
+  if (!m_timingWheel)
+    m_broadcastEvent =
+        Simulator::Schedule (m_broadcast_time, &BeaconRsuNet::BroadcastInformation, this);
 }
 
-bool
+void
+BeaconRsuNet::StopApplication ()
+{
+  NS_LOG_FUNCTION (this);
+  CancelBroadcast ();
+}
+
+void
+BeaconRsuNet::DoDispose ()
+{
+  CancelBroadcast ();
+  Application::DoDispose ();
+}
+
+void
+BeaconRsuNet::CancelBroadcast ()
+{
+  m_broadcastEvent.Cancel ();
+  if (m_broadcastTimer)
+    TimingWheel::GetDefault ()->Cancel (m_broadcastTimer);
+  m_broadcastTimer = 0;
+}
+
+void
+BeaconRsuNet::PhyState (Time start, Time duration, WifiPhyState state)
+{
+  if (state != WifiPhyState::TX && state != WifiPhyState::RX && state != WifiPhyState::CCA_BUSY)
+    return;
+  // only the part since the last beacon
+  Time end = start + duration;
+  if (end > m_lastBeacon)
+    m_busyTime += end - std::max (start, m_lastBeacon);
+}
+
+void
 BeaconRsuNet::ReceivePacket (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
-                             const Address &sender)
+                             const Address &sender, const Address &receiver,
+                             NetDevice::PacketType packetType)
 {
   NS_LOG_FUNCTION (device << packet << protocol << sender);
-  return true;
 }
 
 void
@@ -142,6 +254,9 @@ BeaconRsuNet::PromiscRx (Ptr<const Packet> packet, uint16_t channelFreq, WifiTxV
           if (GetNode ()->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ().Get () ==
               tag.GetIpAddr ())
             {
+              m_dhcpRequestsReceived++;
+              m_dhcpRequestRxTrace (tag.GetNodeId (), Ipv4Address (tag.GetIpAddr ()));
+
               Ipv4Address IpFree;
               Ptr<Packet> response = Create<Packet> (m_packetSize);
               CustomDataTag tagResponse;
@@ -153,6 +268,7 @@ BeaconRsuNet::PromiscRx (Ptr<const Packet> packet, uint16_t channelFreq, WifiTxV
               tagResponse.SetIpAddr (IpFree.Get ());
               tagResponse.SetMask (
                   GetNode ()->GetObject<Ipv4> ()->GetAddress (1, 0).GetMask ().GetPrefixLength ());
+              tagResponse.SetServiceChannel (GetServiceChannel ());
 
                             /*
               NS_LOG_INFO (RED_CODE << ">>>>> hdr.GetAddr2: " << hdr.GetAddr2 () << END_CODE);
@@ -167,10 +283,24 @@ BeaconRsuNet::PromiscRx (Ptr<const Packet> packet, uint16_t channelFreq, WifiTxV
                 {
                   //Let's see if this packet is intended to this node
                   Mac48Address destination = hdr.GetAddr2 ();
-                  m_wifiDevice->Send (response, destination, 0xFE);
+                  m_controlDevice->Send (response, destination, 0xFE);
+                  m_dhcpOffersSent++;
+                  m_dhcpOfferTxTrace (tag.GetNodeId (), IpFree);
                 }
             }
         }
+      else if (tag.isDhcpRelease ())
+        {
+          // broadcast: only the RSU owning the subnet of the address frees it
+          Ipv4InterfaceAddress iaddr = GetNode ()->GetObject<Ipv4> ()->GetAddress (1, 0);
+          Ipv4Address released (tag.GetIpAddr ());
+          if (iaddr.GetMask ().IsMatch (iaddr.GetLocal (), released) &&
+              m_ipAddrUsed.erase (released.Get ()))
+            {
+              m_dhcpReleasesReceived++;
+              m_leasesInUse = m_ipAddrUsed.size ();
+            }
+        }
     }
 }
 
@@ -193,7 +323,23 @@ BeaconRsuNet::DhcpService ()
   } while (m_ipAddrUsed.find (ipAddr.Get ()) != m_ipAddrUsed.end ());
 
   m_ipAddrUsed.emplace (ipAddr.Get (), 0);
+  m_leasesInUse = m_ipAddrUsed.size ();
   return (uint32_t) searchIpFree.to_ulong ();
 }
 
+uint64_t
+BeaconRsuNet::GetMemoryUsage () const
+{
+  // red-black tree node: color, parent, left and right links before the value
+  return m_ipAddrUsed.size () * (4 * sizeof (void *) + sizeof (DhcpMap::value_type));
+}
+
+uint8_t
+BeaconRsuNet::GetServiceChannel () const
+{
+  if (!m_controlDevice || m_controlDevice == m_wifiDevice)
+    return 0;
+  return m_wifiDevice->GetPhy ()->GetChannelNumber ();
+}
+
 } // namespace ns3
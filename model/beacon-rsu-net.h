@@ -3,6 +3,12 @@
 #include "ns3/application.h"
 #include "ns3/wave-net-device.h"
 #include "ns3/wifi-phy.h"
+#include "ns3/wifi-phy-state.h"
+#include "ns3/txop.h"
+#include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
+#include "ns3/ipv4-address.h"
+#include "timing-wheel.h"
 #include <map>
 #include <ns3/simulator.h>
 
@@ -25,23 +31,64 @@ public:
   void PromiscRx (Ptr<const Packet> packet, uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu,
                   SignalNoiseDbm sn);
 
-  bool ReceivePacket (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
-                      const Address &sender);
+  /** Protocol handler for the 0xFE control messages, next to IPv4 and ARP on the device */
+  void ReceivePacket (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                      const Address &sender, const Address &receiver,
+                      NetDevice::PacketType packetType);
 
   uint32_t DhcpService ();
 
+  uint64_t GetMemoryUsage () const; /**< Bytes held by the DHCP lease map */
+
+  /** Channel advertised for DHCP leases and data (0: single radio, everything on one channel) */
+  uint8_t GetServiceChannel () const;
+
+  /**
+   * TracedCallback signature for DHCP requests and offers.
+   *
+   * \param [in] vehicleId Node id of the vehicle.
+   * \param [in] addr Offered address (or the RSU address for requests).
+   */
+  typedef void (*DhcpTracedCallback) (uint32_t vehicleId, Ipv4Address addr);
+
+protected:
+  virtual void DoDispose (void);
+
 private:
   typedef std::map<uint32_t, uint32_t> DhcpMap;
 
   /** \brief This is an inherited function. Code that executes once the application starts */
   void StartApplication ();
+  void StopApplication ();
+  /** Stop the hello messages, on the wheel or on the simulator */
+  void CancelBroadcast ();
+  /** Accumulate the time the channel is sensed busy, for the load in the beacons */
+  void PhyState (Time start, Time duration, WifiPhyState state);
 
   Time m_broadcast_time; /**< How often do you broadcast messages */
+  bool m_timingWheel; /**< Periodic timer driven by the shared TimingWheel */
+  EventId m_broadcastEvent; /**< Next hello message */
+  TimingWheel::TimerId m_broadcastTimer; /**< Hello timer on the wheel (0 if none) */
   uint32_t m_packetSize; /**< Packet size in bytes */
   uint32_t m_nodeId; /**< Node's Id */
 
-  Ptr<WifiNetDevice> m_wifiDevice; /**< wifi device */
+  Ptr<WifiNetDevice> m_wifiDevice; /**< wifi device, IP and data on the service channel */
+  /** Hellos and DHCP: a second wifi device on the CCH if any, else m_wifiDevice */
+  Ptr<WifiNetDevice> m_controlDevice;
+  Ptr<Txop> m_txop; /**< Channel access of the wifi device, for the queue length */
+  Time m_busyTime; /**< Channel busy (tx, rx, cca) since the last beacon */
+  Time m_lastBeacon; /**< Start of the busy ratio measurement */
   DhcpMap m_ipAddrUsed; /** Dhcp IP control*/
+
+  uint64_t m_beaconsSent; /**< Number of hello messages sent */
+  uint64_t m_dhcpRequestsReceived; /**< Number of DHCP requests addressed to this RSU */
+  uint64_t m_dhcpOffersSent; /**< Number of DHCP offers sent */
+  uint64_t m_dhcpReleasesReceived; /**< Number of leases given back by the vehicles */
+  TracedValue<uint32_t> m_leasesInUse; /**< Lease pool occupancy */
+
+  TracedCallback<Ptr<const Packet>> m_beaconTxTrace; /**< Hello message sent */
+  TracedCallback<uint32_t, Ipv4Address> m_dhcpRequestRxTrace; /**< DHCP request received */
+  TracedCallback<uint32_t, Ipv4Address> m_dhcpOfferTxTrace; /**< DHCP offer sent */
 };
 } // namespace ns3
 #endif
\ No newline at end of file
@@ -6,6 +6,11 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/internet-module.h"
 #include "ns3/udp-echo-client.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/double.h"
+#include "timing-wheel.h"
 
 #include <bitset>
 #include <bits/stdc++.h>
@@ -27,9 +32,137 @@ BeaconSearchNet::GetTypeId ()
           .AddConstructor<BeaconSearchNet> ()
           .AddAttribute ("Interval", "Broadcast Interval", TimeValue (MilliSeconds (1000)),
                          MakeTimeAccessor (&BeaconSearchNet::m_broadcast_time), MakeTimeChecker ())
+          .AddAttribute ("TimingWheel", "Drive the periodic timer from the shared TimingWheel",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&BeaconSearchNet::m_timingWheel),
+                         MakeBooleanChecker ())
           .AddAttribute ("Pktsize", "Packet Size", IntegerValue (1000),
                          MakeIntegerAccessor (&BeaconSearchNet::m_packetSize),
-                         MakeIntegerChecker<uint32_t> ());
+                         MakeIntegerChecker<uint32_t> ())
+          .AddAttribute ("ParkedMode", "Activity while the vehicle is stopped or parked",
+                         EnumValue (BeaconSearchNet::PARKED_ACTIVE),
+                         MakeEnumAccessor (&BeaconSearchNet::m_parkedMode),
+                         MakeEnumChecker (BeaconSearchNet::PARKED_ACTIVE, "Active",
+                                          BeaconSearchNet::PARKED_SLEEP, "Sleep",
+                                          BeaconSearchNet::PARKED_REDUCED, "Reduced",
+                                          BeaconSearchNet::PARKED_PASSIVE, "Passive"))
+          .AddAttribute ("ParkedInterval", "Handover check interval of a parked vehicle (Reduced)",
+                         TimeValue (Seconds (1)),
+                         MakeTimeAccessor (&BeaconSearchNet::m_parkedInterval), MakeTimeChecker ())
+          .AddAttribute ("PingPongWindow",
+                         "A handover back to the previous RSU within this time is a ping-pong",
+                         TimeValue (Seconds (5)),
+                         MakeTimeAccessor (&BeaconSearchNet::m_pingPongWindow), MakeTimeChecker ())
+          .AddAttribute ("Strategy", "How the next RSU is picked",
+                         EnumValue (BeaconSearchNet::STRATEGY_BEACON),
+                         MakeEnumAccessor (&BeaconSearchNet::m_strategy),
+                         MakeEnumChecker (BeaconSearchNet::STRATEGY_BEACON, "Beacon",
+                                          BeaconSearchNet::STRATEGY_PREDICTIVE, "Predictive"))
+          .AddAttribute ("RsuRange", "Coverage radius assumed around an RSU position (Predictive)",
+                         DoubleValue (100), MakeDoubleAccessor (&BeaconSearchNet::m_rsuRange),
+                         MakeDoubleChecker<double> (1))
+          .AddAttribute ("PredictionHorizon",
+                         "Hand over once the vehicle leaves the serving RSU within this time "
+                         "(Predictive)",
+                         TimeValue (Seconds (2)),
+                         MakeTimeAccessor (&BeaconSearchNet::m_predictionHorizon),
+                         MakeTimeChecker ())
+          .AddAttribute ("MinDwell",
+                         "Skip candidates the vehicle leaves sooner, unless the serving RSU "
+                         "is lost (Predictive)",
+                         TimeValue (Seconds (5)), MakeTimeAccessor (&BeaconSearchNet::m_minDwell),
+                         MakeTimeChecker ())
+          .AddAttribute ("MakeBeforeBreak",
+                         "Pre-acquire a lease from a candidate RSU while still attached to the "
+                         "serving one, and switch to it without waiting for an offer",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&BeaconSearchNet::m_makeBeforeBreak),
+                         MakeBooleanChecker ())
+          .AddAttribute ("PrepareMargin",
+                         "Pre-acquire a lease once a candidate is within this margin (dB) of the "
+                         "serving RSU (MakeBeforeBreak)",
+                         DoubleValue (3), MakeDoubleAccessor (&BeaconSearchNet::m_prepareMargin),
+                         MakeDoubleChecker<double> ())
+          .AddAttribute ("HandoverMargin",
+                         "Switch to the pre-acquired lease once the candidate is this much (dB) "
+                         "stronger than the serving RSU (MakeBeforeBreak)",
+                         DoubleValue (3), MakeDoubleAccessor (&BeaconSearchNet::m_handoverMargin),
+                         MakeDoubleChecker<double> ())
+          .AddAttribute ("LoadAware",
+                         "Weigh the load advertised in the RSU beacons when picking the next RSU",
+                         BooleanValue (false), MakeBooleanAccessor (&BeaconSearchNet::m_loadAware),
+                         MakeBooleanChecker ())
+          .AddAttribute ("LoadWeight",
+                         "Penalty (dB) of an RSU with a fully busy channel or a full queue "
+                         "(LoadAware)",
+                         DoubleValue (10), MakeDoubleAccessor (&BeaconSearchNet::m_loadWeight),
+                         MakeDoubleChecker<double> (0))
+          .AddAttribute ("LeaseWeight", "Penalty (dB) per active lease of an RSU (LoadAware)",
+                         DoubleValue (0), MakeDoubleAccessor (&BeaconSearchNet::m_leaseWeight),
+                         MakeDoubleChecker<double> (0))
+          .AddAttribute ("QueueScale", "Queue length (packets) counted as a full queue (LoadAware)",
+                         DoubleValue (100), MakeDoubleAccessor (&BeaconSearchNet::m_queueScale),
+                         MakeDoubleChecker<double> (1))
+          .AddAttribute ("LoadSmoothing",
+                         "Weight of a new beacon in the moving average of the load penalty; lower "
+                         "values damp the herd moving between RSUs (LoadAware)",
+                         DoubleValue (0.2), MakeDoubleAccessor (&BeaconSearchNet::m_loadSmoothing),
+                         MakeDoubleChecker<double> (0, 1))
+          .AddAttribute ("BeaconsReceived", "Number of hello messages received", TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&BeaconSearchNet::m_beaconsReceived),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("DhcpRequestsSent", "Number of DHCP requests sent", TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&BeaconSearchNet::m_dhcpRequestsSent),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("DhcpRetries", "Number of DHCP requests repeated without an offer",
+                         TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&BeaconSearchNet::m_dhcpRetries),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("DhcpOffersReceived", "Number of DHCP offers received", TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&BeaconSearchNet::m_dhcpOffersReceived),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("Handovers", "Number of RSU changes", TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&BeaconSearchNet::m_handovers),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("PingPongs", "Number of handovers back to the previous RSU",
+                         TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&BeaconSearchNet::m_pingPongs),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("PreparedLeases", "Number of leases acquired before the break",
+                         TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&BeaconSearchNet::m_preparedLeases),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("DhcpReleasesSent", "Number of pre-acquired leases given back unused",
+                         TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&BeaconSearchNet::m_dhcpReleasesSent),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("LeasesLeaked",
+                         "Prepared leases dropped out of range of their RSU, so not released",
+                         TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&BeaconSearchNet::m_leasesLeaked),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddTraceSource ("BeaconRx", "A hello message has been received",
+                           MakeTraceSourceAccessor (&BeaconSearchNet::m_beaconRxTrace),
+                           "ns3::BeaconSearchNet::BeaconTracedCallback")
+          .AddTraceSource ("DhcpRequestTx", "A DHCP request has been sent",
+                           MakeTraceSourceAccessor (&BeaconSearchNet::m_dhcpRequestTxTrace),
+                           "ns3::BeaconSearchNet::DhcpRequestTracedCallback")
+          .AddTraceSource ("DhcpOfferRx",
+                           "A DHCP offer has been received; a pre-acquired one when it is used",
+                           MakeTraceSourceAccessor (&BeaconSearchNet::m_dhcpOfferRxTrace),
+                           "ns3::BeaconSearchNet::DhcpOfferTracedCallback")
+          .AddTraceSource ("Handover", "The node is now connected to another RSU",
+                           MakeTraceSourceAccessor (&BeaconSearchNet::m_handoverTrace),
+                           "ns3::BeaconSearchNet::HandoverTracedCallback")
+          .AddTraceSource ("PingPong", "The node has returned to the previous RSU",
+                           MakeTraceSourceAccessor (&BeaconSearchNet::m_pingPongTrace),
+                           "ns3::BeaconSearchNet::HandoverTracedCallback")
+          .AddTraceSource ("HandoverTimeline", "Timestamps of a completed handover",
+                           MakeTraceSourceAccessor (&BeaconSearchNet::m_handoverTimelineTrace),
+                           "ns3::BeaconSearchNet::HandoverTimelineTracedCallback");
   return tid;
 }
 
@@ -40,7 +173,39 @@ BeaconSearchNet::GetInstanceTypeId () const
 }
 
 BeaconSearchNet::BeaconSearchNet ()
+    : m_timingWheel (false),
+      m_checkTimer (0),
+      m_running (false),
+      m_parkedMode (PARKED_ACTIVE),
+      m_parked (false),
+      m_rsuConnected (9999),
+      m_strategy (STRATEGY_BEACON),
+      m_rsuRange (100),
+      m_positionTime (Seconds (-1)),
+      m_rsuPrevious (9999),
+      m_dhcpPending (0),
+      m_servingSignal (std::numeric_limits<double>::quiet_NaN ()),
+      m_makeBeforeBreak (false),
+      m_prepareMargin (3),
+      m_handoverMargin (3),
+      m_preparePending (0),
+      m_prepareRsuId (9999),
+      m_loadAware (false),
+      m_loadWeight (10),
+      m_leaseWeight (0),
+      m_queueScale (100),
+      m_loadSmoothing (0.2),
+      m_beaconsReceived (0),
+      m_dhcpRequestsSent (0),
+      m_dhcpRetries (0),
+      m_dhcpOffersReceived (0),
+      m_handovers (0),
+      m_pingPongs (0),
+      m_preparedLeases (0),
+      m_dhcpReleasesSent (0),
+      m_leasesLeaked (0)
 {
+  m_prepared.rsuId = 9999;
 }
 
 BeaconSearchNet::~BeaconSearchNet ()
@@ -59,31 +224,43 @@ BeaconSearchNet::StartApplication ()
       Ptr<NetDevice> dev = n->GetDevice (i);
       //NS_LOG_INFO ("" << dev->GetInstanceTypeId ().GetName ());
 
+      if (dev->GetInstanceTypeId () == WifiNetDevice::GetTypeId () && m_wifiDevice)
+        {
+          // multi-channel: the second radio, on the CCH
+          m_controlDevice = DynamicCast<WifiNetDevice> (dev);
+          break;
+        }
       if (dev->GetInstanceTypeId () == WifiNetDevice::GetTypeId ())
         {
           m_wifiDevice = DynamicCast<WifiNetDevice> (dev);
           m_rsuConnected = 9999; // out - disconnected
-          //ReceivePacket will be called when a packet is received
-          dev->SetReceiveCallback (MakeCallback (&BeaconSearchNet::ReceivePacket, this));
-
-          /*
-            If you want promiscous receive callback, connect to this trace. 
-            For every packet received, both functions ReceivePacket & PromiscRx will be called. with PromicRx being called first!
-            */
-          Ptr<WifiPhy> phy = m_wifiDevice->GetPhy (); //default, there's only one PHY
-          phy->TraceConnectWithoutContext ("MonitorSnifferRx",
-                                           MakeCallback (&BeaconSearchNet::PromiscRx, this));
-          break;
         }
     }
   if (m_wifiDevice)
     {
+      if (!m_controlDevice)
+        m_controlDevice = m_wifiDevice;
+      //ReceivePacket will be called when a control message is received; a handler, not the
+      //device receive callback, which belongs to the node and feeds IPv4 and ARP
+      GetNode ()->RegisterProtocolHandler (MakeCallback (&BeaconSearchNet::ReceivePacket, this),
+                                           0xFE, m_controlDevice);
+
+      /*
+        If you want promiscous receive callback, connect to this trace. 
+        For every packet received, both functions ReceivePacket & PromiscRx will be called. with PromicRx being called first!
+        */
+      m_controlDevice->GetPhy ()->TraceConnectWithoutContext (
+          "MonitorSnifferRx", MakeCallback (&BeaconSearchNet::PromiscRx, this));
+
       //Let's create a bit of randomness with the first broadcast packet time to avoid collision
       Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
       Time random_offset = MicroSeconds (rand->GetValue (50, 200));
 
-      Simulator::Schedule (m_broadcast_time + random_offset, &BeaconSearchNet::CheckHandoverProcess,
-                           this);
+      m_running = true;
+      if (m_parked)
+        UpdateActivity ();
+      else
+        ScheduleCheck (m_broadcast_time + random_offset, m_broadcast_time);
     }
   else
     {
@@ -91,35 +268,358 @@ BeaconSearchNet::StartApplication ()
     }
 }
 
+void
+BeaconSearchNet::StopApplication ()
+{
+  NS_LOG_FUNCTION (this);
+  m_running = false;
+  CancelCheck ();
+}
+
+void
+BeaconSearchNet::DoDispose ()
+{
+  m_running = false;
+  CancelCheck ();
+  Application::DoDispose ();
+}
+
 void
 BeaconSearchNet::CheckHandoverProcess ()
 {
   NS_LOG_FUNCTION (this);
 
-  uint32_t ipRSUHandover = HandoverStrategy ();
+  uint32_t ipRSUHandover = 0;
+  if (m_strategy == STRATEGY_PREDICTIVE)
+    UpdateKinematics ();
+  if (!m_makeBeforeBreak || !PrepareHandover ())
+    ipRSUHandover = HandoverStrategy ();
 
   if (ipRSUHandover) // if 0 >> handover is not necessary
     {
-      Ptr<Packet> packet = Create<Packet> (m_packetSize);
-      CustomDataTag tag;
-
-      tag.SetNodeId (GetNode ()->GetId ());
-      tag.SetPosition (GetNode ()->GetObject<MobilityModel> ()->GetPosition ());
-      //timestamp is set in the default constructor of the CustomDataTag class as Simulator::Now()
-      tag.SetIpAddr (ipRSUHandover); //RSU ip address responsible to manager the handover
-      tag.PrepareHeaderDhcpMessage ();
-
-      //attach the tag to the packet
-      packet->AddPacketTag (tag);
-      m_wifiDevice->Send (packet, Mac48Address::GetBroadcast (), 0xFE);
+      if (!m_dhcpPending) // first request of this handover
+        {
+          m_timeline.oldRsuId = m_rsuConnected;
+          m_timeline.lastServingBeacon = m_lastServingBeacon;
+          m_timeline.detection = Now ();
+          m_timeline.dhcpRequest = Now ();
+          m_timeline.dhcpRequests = 0;
+        }
+      m_timeline.dhcpRequests++;
+
+      bool retry = (m_dhcpPending == ipRSUHandover);
+      m_dhcpPending = ipRSUHandover;
+      m_preparePending = 0;
+      SendDhcpRequest (ipRSUHandover, retry);
     }
   //Schedule next handover event
-  Simulator::Schedule (m_broadcast_time, &BeaconSearchNet::CheckHandoverProcess, this);
+  if (!m_timingWheel)
+    m_checkEvent =
+        Simulator::Schedule (m_checkInterval, &BeaconSearchNet::CheckHandoverProcess, this);
+}
+
+void
+BeaconSearchNet::SendDhcpRequest (uint32_t rsuIp, bool retry)
+{
+  Ptr<Packet> packet = Create<Packet> (m_packetSize);
+  CustomDataTag tag;
+
+  tag.SetNodeId (GetNode ()->GetId ());
+  tag.SetPosition (GetNode ()->GetObject<MobilityModel> ()->GetPosition ());
+  //timestamp is set in the default constructor of the CustomDataTag class as Simulator::Now()
+  tag.SetIpAddr (rsuIp); //RSU ip address responsible to manager the handover
+  tag.PrepareHeaderDhcpMessage ();
+
+  //attach the tag to the packet
+  packet->AddPacketTag (tag);
+  m_controlDevice->Send (packet, Mac48Address::GetBroadcast (), 0xFE);
+
+  m_dhcpRequestsSent++;
+  if (retry)
+    m_dhcpRetries++;
+  m_dhcpRequestTxTrace (Ipv4Address (rsuIp), retry);
+}
+
+void
+BeaconSearchNet::SendDhcpRelease (uint32_t addr)
+{
+  Ptr<Packet> packet = Create<Packet> (m_packetSize);
+  CustomDataTag tag;
+
+  tag.SetNodeId (GetNode ()->GetId ());
+  tag.SetPosition (GetNode ()->GetObject<MobilityModel> ()->GetPosition ());
+  tag.SetIpAddr (addr); // the RSU owning the subnet frees it
+  tag.PrepareHeaderDhcpRelease ();
+
+  packet->AddPacketTag (tag);
+  m_controlDevice->Send (packet, Mac48Address::GetBroadcast (), 0xFE);
+  m_dhcpReleasesSent++;
+}
+
+void
+BeaconSearchNet::DropPrepared ()
+{
+  if (m_prepared.rsuId == 9999)
+    return;
+  // the release is an unacknowledged broadcast: only worth sending while the RSU is heard
+  BEACONRECEIVED beacon;
+  if (LatestBeacon (m_prepared.rsuId, beacon))
+    SendDhcpRelease (m_prepared.ipAddr);
+  else
+    m_leasesLeaked++;
+  m_prepared.rsuId = 9999;
+}
+
+bool
+BeaconSearchNet::PrepareHandover ()
+{
+  if (m_rsuConnected == 9999 || m_dhcpPending)
+    return false; // first attachment, or a break before make handover under way
+  if (TrySwitch ())
+    return true;
+  if (Now () - m_lastServingBeacon >= 2 * m_broadcast_time)
+    return false; // serving RSU lost before a lease was ready
+
+  BEACONRECEIVED candidate;
+  if (m_prepared.rsuId != 9999 || !BestCandidate (candidate) ||
+      !(Score (candidate) >= m_servingSignal - LoadPenalty (m_rsuConnected) - m_prepareMargin))
+    return true;
+
+  // no timeline stamps: the signaling is over before the break
+  bool retry = (m_preparePending == candidate.ipAddr);
+  m_preparePending = candidate.ipAddr;
+  m_prepareRsuId = candidate.rsuId;
+  NS_LOG_INFO ("vehicle-id=" << GetNode ()->GetId () << " pre-acquires a lease from RSU-id="
+                             << candidate.rsuId);
+  SendDhcpRequest (candidate.ipAddr, retry);
+  return true;
+}
+
+bool
+BeaconSearchNet::TrySwitch ()
+{
+  if (m_prepared.rsuId == 9999)
+    return false;
+
+  BEACONRECEIVED candidate;
+  if (!LatestBeacon (m_prepared.rsuId, candidate))
+    {
+      NS_LOG_INFO ("vehicle-id=" << GetNode ()->GetId () << " drops the lease of RSU-id="
+                                 << m_prepared.rsuId);
+      DropPrepared (); // candidate out of range
+      return false;
+    }
+  // one missed beacon is enough, the lease is already there
+  bool servingLost = Now () - m_lastServingBeacon > m_broadcast_time;
+  if (!servingLost &&
+      !(Score (candidate) >= m_servingSignal - LoadPenalty (m_rsuConnected) + m_handoverMargin))
+    return false;
+
+  // the lease is ready: detection, request and offer all happen at the switch
+  m_timeline.oldRsuId = m_rsuConnected;
+  m_timeline.lastServingBeacon = m_lastServingBeacon;
+  m_timeline.detection = Now ();
+  m_timeline.dhcpRequest = Now ();
+  m_timeline.dhcpOffer = Now ();
+  m_timeline.dhcpRequests = 0;
+  BEACONRECEIVED lease = m_prepared;
+  m_prepared.rsuId = 9999;
+  SwitchTo (lease.rsuId, Ipv4Address (lease.ipAddr), lease.mask, lease.serviceChannel, true);
+  return true;
+}
+
+bool
+BeaconSearchNet::LatestBeacon (uint32_t rsuId, BEACONRECEIVED &beacon) const
+{
+  Time window = 2 * m_broadcast_time;
+  for (auto it = beaconsReceived.rbegin ();
+       it != beaconsReceived.rend () && Now () - it->timestamp < window; ++it)
+    if (it->rsuId == rsuId)
+      {
+        beacon = *it;
+        return true;
+      }
+  return false;
+}
+
+bool
+BeaconSearchNet::BestCandidate (BEACONRECEIVED &beacon) const
+{
+  Time window = 2 * m_broadcast_time;
+  std::vector<uint32_t> seen; // latest beacon of each RSU only
+  bool found = false;
+  for (auto it = beaconsReceived.rbegin ();
+       it != beaconsReceived.rend () && Now () - it->timestamp < window; ++it)
+    {
+      if (it->rsuId == m_rsuConnected ||
+          std::find (seen.begin (), seen.end (), it->rsuId) != seen.end ())
+        continue;
+      seen.push_back (it->rsuId);
+      if (m_strategy == STRATEGY_PREDICTIVE)
+        {
+          Time dwell = TimeToExit (it->position);
+          if (dwell < m_minDwell || (found && dwell <= TimeToExit (beacon.position)))
+            continue;
+        }
+      else if (found && Score (*it) <= Score (beacon))
+        continue;
+      beacon = *it;
+      found = true;
+    }
+  return found;
+}
+
+double
+BeaconSearchNet::LoadPenalty (uint32_t rsuId) const
+{
+  if (!m_loadAware)
+    return 0;
+  auto it = m_loadPenalty.find (rsuId);
+  return it == m_loadPenalty.end () ? 0 : it->second;
+}
+
+double
+BeaconSearchNet::Score (const BEACONRECEIVED &beacon) const
+{
+  return beacon.signal - LoadPenalty (beacon.rsuId);
+}
+
+void
+BeaconSearchNet::UpdateKinematics ()
+{
+  if (Now () == m_positionTime)
+    return;
+  Ptr<MobilityModel> mobility = GetNode ()->GetObject<MobilityModel> ();
+  Vector position = mobility->GetPosition ();
+  m_velocity = mobility->GetVelocity ();
+  if (m_velocity.x == 0 && m_velocity.y == 0 && m_positionTime.IsPositive ())
+    {
+      // positions set by VanetSumoClient on a ConstantPositionMobilityModel
+      double dt = (Now () - m_positionTime).GetSeconds ();
+      m_velocity = Vector ((position.x - m_position.x) / dt, (position.y - m_position.y) / dt, 0);
+      if (m_velocity.GetLength () > 100)
+        m_velocity = Vector (0, 0, 0); // node taken from or returned to the pool
+    }
+  m_position = position;
+  m_positionTime = Now ();
+}
+
+Time
+BeaconSearchNet::TimeToExit (const Vector &rsuPosition) const
+{
+  // largest t with |position + velocity t - rsuPosition| = RsuRange, in the ground plane
+  double dx = m_position.x - rsuPosition.x;
+  double dy = m_position.y - rsuPosition.y;
+  double a = m_velocity.x * m_velocity.x + m_velocity.y * m_velocity.y;
+  double b = 2 * (dx * m_velocity.x + dy * m_velocity.y);
+  double c = dx * dx + dy * dy - m_rsuRange * m_rsuRange;
+  if (a < 1e-6)
+    return c < 0 ? Time::Max () : Seconds (0); // standing still
+  double disc = b * b - 4 * a * c;
+  if (disc < 0)
+    return Seconds (0);
+  return Seconds (std::max (0.0, (-b + std::sqrt (disc)) / (2 * a)));
+}
+
+uint32_t
+BeaconSearchNet::PredictiveStrategy ()
+{
+  BEACONRECEIVED serving, candidate;
+  bool servingFresh = LatestBeacon (m_rsuConnected, serving);
+  if (servingFresh && TimeToExit (serving.position) > m_predictionHorizon)
+    return 0; // staying in the serving RSU for a while
+
+  if (BestCandidate (candidate))
+    {
+      if (servingFresh && TimeToExit (candidate.position) <= TimeToExit (serving.position))
+        return 0;
+      NS_LOG_INFO ("vehicle-id=" << GetNode ()->GetId () << " predicts "
+                                 << TimeToExit (candidate.position).GetSeconds ()
+                                 << " s in RSU-id=" << candidate.rsuId);
+      return candidate.ipAddr;
+    }
+  if (servingFresh)
+    return 0;
+
+  // serving RSU lost and no candidate worth MinDwell: take the one left last
+  Time window = 2 * m_broadcast_time;
+  Time best = Seconds (-1);
+  uint32_t ipRSUHandover = 0;
+  for (auto it = beaconsReceived.rbegin ();
+       it != beaconsReceived.rend () && Now () - it->timestamp < window; ++it)
+    if (TimeToExit (it->position) > best)
+      {
+        best = TimeToExit (it->position);
+        ipRSUHandover = it->ipAddr;
+      }
+  return ipRSUHandover;
+}
+
+void
+BeaconSearchNet::ScheduleCheck (Time delay, Time interval)
+{
+  CancelCheck ();
+  m_checkInterval = interval;
+  if (m_timingWheel)
+    m_checkTimer = TimingWheel::GetDefault ()->Schedule (
+        delay, interval, MakeCallback (&BeaconSearchNet::CheckHandoverProcess, this));
+  else
+    m_checkEvent = Simulator::Schedule (delay, &BeaconSearchNet::CheckHandoverProcess, this);
+}
+
+void
+BeaconSearchNet::CancelCheck ()
+{
+  m_checkEvent.Cancel ();
+  if (m_checkTimer)
+    TimingWheel::GetDefault ()->Cancel (m_checkTimer);
+  m_checkTimer = 0;
+}
+
+void
+BeaconSearchNet::SetParked (bool parked)
+{
+  NS_LOG_FUNCTION (this << parked);
+  if (parked == m_parked)
+    return;
+  m_parked = parked;
+  if (m_parkedMode != PARKED_ACTIVE && m_running)
+    UpdateActivity ();
 }
 
 bool
+BeaconSearchNet::IsParked () const
+{
+  return m_parked;
+}
+
+void
+BeaconSearchNet::UpdateActivity ()
+{
+  bool low = m_parked && m_parkedMode != PARKED_ACTIVE;
+  if (m_parkedMode == PARKED_SLEEP)
+    for (Ptr<WifiNetDevice> dev : {m_wifiDevice, m_controlDevice})
+      {
+        Ptr<WifiPhy> phy = dev->GetPhy ();
+        if (low && !phy->IsStateSleep ())
+          phy->SetSleepMode ();
+        else if (!low && phy->IsStateSleep ())
+          phy->ResumeFromSleep ();
+      }
+
+  if (!low)
+    ScheduleCheck (m_broadcast_time, m_broadcast_time);
+  else if (m_parkedMode == PARKED_REDUCED)
+    ScheduleCheck (m_parkedInterval, m_parkedInterval);
+  else
+    CancelCheck (); // sleeping or only listening: no handover while parked
+  NS_LOG_INFO ("Vehicle " << GetNode ()->GetId () << (low ? " suspended" : " resumed"));
+}
+
+void
 BeaconSearchNet::ReceivePacket (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
-                                const Address &sender)
+                                const Address &sender, const Address &receiver,
+                                NetDevice::PacketType packetType)
 {
   NS_LOG_FUNCTION (device << packet << protocol << sender);
 
@@ -127,44 +627,91 @@ BeaconSearchNet::ReceivePacket (Ptr<NetDevice> device, Ptr<const Packet> packet,
   CustomDataTag tag;
   if (packet->PeekPacketTag (tag) && tag.isDhcpMessage ())
     {
-      Ipv4Address newIpAddr;
-      newIpAddr.Set (tag.GetIpAddr ());
-
-      //NS_LOG_INFO ("Teste var1: " << tag.GetNodeId ());
-      //NS_LOG_INFO ("Teste var2 : " << std::bitset<32> (newIpAddr.Get ()));
+      m_dhcpOffersReceived++;
+      if (m_preparePending && tag.GetNodeId () == m_prepareRsuId && !m_dhcpPending)
+        {
+          // make before break: keep the lease until the switch
+          m_prepared.rsuId = tag.GetNodeId ();
+          m_prepared.ipAddr = tag.GetIpAddr ();
+          m_prepared.mask = tag.GetMask ();
+          m_prepared.serviceChannel = tag.GetServiceChannel ();
+          m_prepared.timestamp = Now ();
+          m_preparePending = 0;
+          m_preparedLeases++;
+          NS_LOG_INFO ("vehicle-id=" << GetNode ()->GetId () << " holds "
+                                     << Ipv4Address (m_prepared.ipAddr) << " from RSU-id="
+                                     << m_prepared.rsuId);
+          return;
+        }
+      if (!m_dhcpPending)
+        {
+          // late offer to a repeated request or a superseded pre-acquisition: switching to
+          // it would bypass the HandoverMargin, and its RSU has just been heard
+          SendDhcpRelease (tag.GetIpAddr ());
+          return;
+        }
 
-      Ptr<Ipv4> ipv4 = GetNode ()->GetObject<Ipv4> (); // Get Ipv4 instance of the node
-      int32_t interface = ipv4->GetInterfaceForDevice (device);
-      std::string convertMask = "/" + std::to_string (tag.GetMask ());
+      m_timeline.dhcpOffer = Now ();
+      m_dhcpPending = 0;
+      m_preparePending = 0;
+      DropPrepared ();
+      SwitchTo (tag.GetNodeId (), Ipv4Address (tag.GetIpAddr ()), tag.GetMask (),
+                tag.GetServiceChannel (), true);
+    }
+}
 
-      Ipv4InterfaceAddress ipv4Addr =
-          Ipv4InterfaceAddress (Ipv4Address (newIpAddr), Ipv4Mask (convertMask.c_str ()));
+void
+BeaconSearchNet::SwitchTo (uint32_t rsuId, Ipv4Address newIpAddr, uint32_t mask, uint8_t channel,
+                           bool requested)
+{
+  m_dhcpOfferRxTrace (rsuId, newIpAddr);
 
-      Ipv4StaticRoutingHelper helper;
-      Ptr<Ipv4StaticRouting> Ipv4stat;
+  // the control radio stays on the CCH for the hellos of the other RSUs
+  if (channel && m_controlDevice != m_wifiDevice)
+    m_wifiDevice->GetPhy ()->SetChannelNumber (channel);
 
-      Ipv4stat = helper.GetStaticRouting (ipv4);
-      //Ipv4stat->UpdateSortedArray ();
+  Ptr<Ipv4> ipv4 = GetNode ()->GetObject<Ipv4> (); // Get Ipv4 instance of the node
+  int32_t interface = ipv4->GetInterfaceForDevice (m_wifiDevice);
+  std::string convertMask = "/" + std::to_string (mask);
 
-      //changing ip address
-      ipv4->RemoveAddress (interface, 0);
+  Ipv4InterfaceAddress ipv4Addr =
+      Ipv4InterfaceAddress (Ipv4Address (newIpAddr), Ipv4Mask (convertMask.c_str ()));
 
-      ipv4->AddAddress (interface, ipv4Addr);
-      ipv4->SetMetric (interface, 1);
-      //ipv4->SetUp (interface);
-      m_rsuConnected = tag.GetNodeId ();
+  //changing ip address
+  ipv4->RemoveAddress (interface, 0);
 
-      ipv4 = GetNode ()->GetObject<Ipv4> ();
-      Ipv4stat = helper.GetStaticRouting (ipv4);
-      //Ipv4stat->RemoveRoute (1);
+  ipv4->AddAddress (interface, ipv4Addr);
+  ipv4->SetMetric (interface, 1);
+  //ipv4->SetUp (interface);
+  if (m_rsuConnected != 9999 && m_rsuConnected != rsuId)
+    {
+      m_handovers++;
+      m_handoverTrace (m_rsuConnected, rsuId);
+      if (rsuId == m_rsuPrevious && Now () - m_lastHandover < m_pingPongWindow)
+        {
+          m_pingPongs++;
+          m_pingPongTrace (m_rsuConnected, rsuId);
+        }
+      m_rsuPrevious = m_rsuConnected;
+      m_lastHandover = Now ();
 
-      NS_LOG_INFO (GREEN_CODE << "vehicle-id=" << GetNode ()->GetId ()
-                              << " is now connected to RSU-id=" << m_rsuConnected << END_CODE);
-      NS_LOG_INFO (GREEN_CODE << "vehicle-id=" << GetNode ()->GetId ()
-                              << " has new ipv4 address: " << newIpAddr << " ("
-                              << std::bitset<32> (newIpAddr.Get ()) << ")" << END_CODE);
+      if (requested)
+        {
+          m_timeline.vehicleId = GetNode ()->GetId ();
+          m_timeline.newRsuId = rsuId;
+          m_timeline.addressSwap = Now ();
+          m_handoverTimelineTrace (m_timeline);
+        }
     }
-  return true;
+  m_rsuConnected = rsuId;
+  m_lastServingBeacon = Now ();
+  m_servingSignal = std::numeric_limits<double>::quiet_NaN ();
+
+  NS_LOG_INFO (GREEN_CODE << "vehicle-id=" << GetNode ()->GetId ()
+                          << " is now connected to RSU-id=" << m_rsuConnected << END_CODE);
+  NS_LOG_INFO (GREEN_CODE << "vehicle-id=" << GetNode ()->GetId ()
+                          << " has new ipv4 address: " << newIpAddr << " ("
+                          << std::bitset<32> (newIpAddr.Get ()) << ")" << END_CODE);
 }
 
 void
@@ -188,17 +735,69 @@ BeaconSearchNet::PromiscRx (Ptr<const Packet> packet, uint16_t channelFreq, Wifi
 
         beaconRecvTemp.signal = sn.signal;
         beaconRecvTemp.noise = sn.noise;
+        beaconRecvTemp.position = tag.GetPosition ();
+        beaconRecvTemp.serviceChannel = tag.GetServiceChannel ();
         // store the beacon received
         beaconsReceived.emplace_back (beaconRecvTemp);
+        m_beaconsReceived++;
+        if (beaconRecvTemp.rsuId == m_rsuConnected)
+          {
+            m_lastServingBeacon = beaconRecvTemp.timestamp;
+            m_servingSignal = sn.signal;
+          }
+        if (m_loadAware)
+          {
+            double load = std::max (tag.GetChannelBusy (),
+                                    std::min (1.0, tag.GetQueueLength () / m_queueScale));
+            double sample = m_loadWeight * load + m_leaseWeight * tag.GetLeases ();
+            auto it = m_loadPenalty.find (beaconRecvTemp.rsuId);
+            if (it == m_loadPenalty.end ())
+              m_loadPenalty[beaconRecvTemp.rsuId] = sample;
+            else
+              it->second += m_loadSmoothing * (sample - it->second);
+          }
+        m_beaconRxTrace (beaconRecvTemp.rsuId, sn.signal, sn.noise);
+        // make before break: switch on the candidate's beacon instead of the next check
+        if (m_makeBeforeBreak && beaconRecvTemp.rsuId == m_prepared.rsuId &&
+            !(m_parked && m_parkedMode != PARKED_ACTIVE))
+          TrySwitch ();
       }
   }
 }
 
+uint32_t
+BeaconSearchNet::GetRsuConnected () const
+{
+  return m_rsuConnected;
+}
+
+double
+BeaconSearchNet::GetServingSignal () const
+{
+  return m_servingSignal;
+}
+
+bool
+BeaconSearchNet::IsHandoverPending () const
+{
+  return m_dhcpPending != 0;
+}
+
+uint64_t
+BeaconSearchNet::GetMemoryUsage () const
+{
+  return beaconsReceived.capacity () * sizeof (BEACONRECEIVED) +
+         m_loadPenalty.size () * (4 * sizeof (void *) + sizeof (std::pair<uint32_t, double>));
+}
+
 //** Customize your RSU handover strategy here */
 u_int32_t
 BeaconSearchNet::HandoverStrategy ()
 {
   //NS_LOG_INFO (RED_CODE << "m_rsuConnected=" << m_rsuConnected << END_CODE);
+  if (m_strategy == STRATEGY_PREDICTIVE)
+    return PredictiveStrategy ();
+
   Time max_interval = 2 * m_broadcast_time; // ms
   uint32_t ipRSUHandover = 0;
   bool isHandoverNecessary = true;
@@ -213,6 +812,10 @@ BeaconSearchNet::HandoverStrategy ()
         }
     }
 
+  BEACONRECEIVED candidate;
+  if (isHandoverNecessary && m_loadAware)
+    return BestCandidate (candidate) ? candidate.ipAddr : 0; // strongest once the load is weighed
+
   if (isHandoverNecessary)
     for (size_t i = 0; i < beaconsReceived.size (); i++)
       if (Now ().GetMilliSeconds () - beaconsReceived.at (i).timestamp.GetMilliSeconds () <
@@ -3,7 +3,11 @@
 #include "ns3/application.h"
 #include "ns3/wave-net-device.h"
 #include "ns3/wifi-phy.h"
+#include "ns3/traced-callback.h"
+#include "ns3/ipv4-address.h"
 #include "custom-data-tag.h"
+#include "timing-wheel.h"
+#include <map>
 #include <vector>
 
 namespace ns3 {
@@ -19,9 +23,39 @@ class BeaconSearchNet : public ns3::Application
     ns3::Time timestamp;
     double signal;
     double noise;
+    Vector position; /**< RSU position carried by the beacon */
+    uint8_t serviceChannel; /**< SCH advertised by the RSU (0: single channel) */
   };
 
 public:
+  /** Activity of a stopped or parked vehicle */
+  enum ParkedMode {
+    PARKED_ACTIVE, /**< Unchanged */
+    PARKED_SLEEP, /**< PHY asleep, no handover checks */
+    PARKED_REDUCED, /**< Handover checks every ParkedInterval */
+    PARKED_PASSIVE /**< Beacons still received, no handover checks */
+  };
+
+  /** How HandoverStrategy picks the RSU */
+  enum Strategy {
+    STRATEGY_BEACON, /**< First RSU heard once the serving one is stale */
+    STRATEGY_PREDICTIVE /**< RSU the vehicle stays in longest, before leaving the serving one */
+  };
+
+  /** Timestamps of one handover, from the last beacon of the serving RSU to the address swap */
+  struct HandoverTimeline
+  {
+    uint32_t vehicleId;
+    uint32_t oldRsuId;
+    uint32_t newRsuId;
+    Time lastServingBeacon; /**< Last hello message received from the old RSU */
+    Time detection; /**< HandoverStrategy declared the old RSU stale */
+    Time dhcpRequest; /**< First DHCP request sent (the switch for a pre-acquired lease) */
+    Time dhcpOffer; /**< DHCP offer received (the switch for a pre-acquired lease) */
+    Time addressSwap; /**< New address configured by ReceivePacket */
+    uint32_t dhcpRequests; /**< Requests sent until the offer arrived (0: pre-acquired) */
+  };
+
   static TypeId GetTypeId (void);
   virtual TypeId GetInstanceTypeId (void) const;
 
@@ -34,22 +68,158 @@ public:
 
   uint32_t HandoverStrategy (); /**< Handover Strategy */
 
+  uint32_t GetRsuConnected () const; /**< RSU id the node is connected to (9999 if none) */
+  double GetServingSignal () const; /**< Signal (dBm) of the last beacon from the serving RSU */
+  bool IsHandoverPending () const; /**< DHCP request of a break before make handover unanswered */
+  uint64_t GetMemoryUsage () const; /**< Bytes held by the received beacon table */
+
+  /** Enter or leave the ParkedMode, e.g. from VanetSumoClient VehicleStopped; wakes on departure */
+  void SetParked (bool parked);
+  bool IsParked () const;
+
   void PromiscRx (Ptr<const Packet> packet, uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu,
                   SignalNoiseDbm sn);
 
-  bool ReceivePacket (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
-                      const Address &sender);
+  /** Protocol handler for the 0xFE control messages, next to IPv4 and ARP on the device */
+  void ReceivePacket (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                      const Address &sender, const Address &receiver,
+                      NetDevice::PacketType packetType);
+
+  /**
+   * TracedCallback signature for received hello messages.
+   *
+   * \param [in] rsuId Node id of the RSU.
+   * \param [in] signal Signal power (dBm).
+   * \param [in] noise Noise power (dBm).
+   */
+  typedef void (*BeaconTracedCallback) (uint32_t rsuId, double signal, double noise);
+
+  /**
+   * TracedCallback signature for DHCP requests.
+   *
+   * \param [in] rsuAddr Address of the RSU managing the handover.
+   * \param [in] retry True if a request to this RSU is still unanswered.
+   */
+  typedef void (*DhcpRequestTracedCallback) (Ipv4Address rsuAddr, bool retry);
+
+  /**
+   * TracedCallback signature for DHCP offers.
+   *
+   * \param [in] rsuId Node id of the RSU.
+   * \param [in] addr Offered address.
+   */
+  typedef void (*DhcpOfferTracedCallback) (uint32_t rsuId, Ipv4Address addr);
+
+  /**
+   * TracedCallback signature for handovers and ping-pongs.
+   *
+   * \param [in] oldRsuId Node id of the previous RSU.
+   * \param [in] newRsuId Node id of the new RSU.
+   */
+  typedef void (*HandoverTracedCallback) (uint32_t oldRsuId, uint32_t newRsuId);
+
+  /**
+   * TracedCallback signature for handover timelines.
+   *
+   * \param [in] timeline Timestamps of the completed handover.
+   */
+  typedef void (*HandoverTimelineTracedCallback) (const HandoverTimeline &timeline);
+
+protected:
+  virtual void DoDispose (void);
 
 private:
   /** \brief This is an inherited function. Code that executes once the application starts */
   void StartApplication ();
+  void StopApplication ();
+  void SendDhcpRequest (uint32_t rsuIp, bool retry);
+  /** Give an unused lease back to the RSU that offered it */
+  void SendDhcpRelease (uint32_t addr);
+  /** Forget the pre-acquired lease; released if its RSU is still heard, else leaked */
+  void DropPrepared ();
+  /** Pre-acquire a lease or switch to it; false to fall back to HandoverStrategy */
+  bool PrepareHandover ();
+  /** Switch to the pre-acquired lease if the threshold is crossed */
+  bool TrySwitch ();
+  /** Take the lease of an RSU, tuning the service radio to its SCH (channel 0: keep it) */
+  void SwitchTo (uint32_t rsuId, Ipv4Address addr, uint32_t mask, uint8_t channel,
+                 bool requested);
+  bool LatestBeacon (uint32_t rsuId, BEACONRECEIVED &beacon) const;
+  /** Strongest recent RSU other than the serving one */
+  bool BestCandidate (BEACONRECEIVED &beacon) const;
+  /** Smoothed penalty (dB) for the load advertised by an RSU (0 unless LoadAware) */
+  double LoadPenalty (uint32_t rsuId) const;
+  double Score (const BEACONRECEIVED &beacon) const; /**< Signal minus the load penalty */
+  uint32_t PredictiveStrategy ();
+  /** Velocity from the mobility model, or from the position change since the last check */
+  void UpdateKinematics ();
+  /** Time until the vehicle leaves the RsuRange around an RSU position */
+  Time TimeToExit (const Vector &rsuPosition) const;
+  void ScheduleCheck (Time delay, Time interval);
+  void CancelCheck ();
+  void UpdateActivity ();
 
   Time m_broadcast_time; /**< How often do you broadcast messages */
+  bool m_timingWheel; /**< Periodic timer driven by the shared TimingWheel */
+  EventId m_checkEvent; /**< Next handover check */
+  TimingWheel::TimerId m_checkTimer; /**< Handover check timer on the wheel (0 if none) */
+  bool m_running; /**< Between StartApplication and StopApplication */
+  Time m_checkInterval; /**< Current handover check interval */
+  ParkedMode m_parkedMode; /**< Activity while parked */
+  Time m_parkedInterval; /**< Handover check interval while parked (Reduced) */
+  bool m_parked; /**< Vehicle stopped or parked */
   uint32_t m_packetSize; /**< Packet size in bytes */
   uint32_t m_nodeId; /**< Node's Id */
   uint32_t m_rsuConnected; /**< Stores which RSU the node is connected to */
 
-  Ptr<WifiNetDevice> m_wifiDevice; /**< wifi device */
+  Strategy m_strategy; /**< Handover strategy */
+  double m_rsuRange; /**< Coverage radius assumed around each RSU (m) */
+  Time m_predictionHorizon; /**< Hand over when leaving the serving RSU within this time */
+  Time m_minDwell; /**< Shortest stay in a candidate worth a handover */
+  Vector m_position; /**< Position at the last kinematics update */
+  Vector m_velocity; /**< Estimated velocity (m/s) */
+  Time m_positionTime; /**< Time of the last kinematics update (-1 s if none) */
+
+  Ptr<WifiNetDevice> m_wifiDevice; /**< wifi device, IP and data on the service channel */
+  /** Hellos and DHCP: a second wifi device on the CCH if any, else m_wifiDevice */
+  Ptr<WifiNetDevice> m_controlDevice;
+
+  Time m_pingPongWindow; /**< Max time to return to the previous RSU to count a ping-pong */
+  uint32_t m_rsuPrevious; /**< RSU the node was connected to before the last handover */
+  Time m_lastHandover; /**< Time of the last handover */
+  uint32_t m_dhcpPending; /**< RSU ip address of the unanswered DHCP request (0 if none) */
+  Time m_lastServingBeacon; /**< Last hello message received from the serving RSU */
+  double m_servingSignal; /**< Signal of the last hello message from the serving RSU */
+  HandoverTimeline m_timeline; /**< Handover in progress */
+  bool m_makeBeforeBreak; /**< Pre-acquire the next lease while still attached */
+  double m_prepareMargin; /**< Candidate within this margin (dB) of the serving RSU: pre-acquire */
+  double m_handoverMargin; /**< Candidate this much (dB) above the serving RSU: switch */
+  uint32_t m_preparePending; /**< RSU ip address of the unanswered pre-acquisition (0 if none) */
+  uint32_t m_prepareRsuId; /**< Node id of the RSU asked for the pre-acquisition */
+  BEACONRECEIVED m_prepared; /**< Lease waiting for the switch (rsuId 9999 if none) */
+  bool m_loadAware; /**< Weigh the load advertised in the beacons */
+  double m_loadWeight; /**< Penalty (dB) of a fully busy channel or full queue */
+  double m_leaseWeight; /**< Penalty (dB) per active lease */
+  double m_queueScale; /**< Queue length (packets) counted as full */
+  double m_loadSmoothing; /**< Weight of a new sample in the load penalty average */
+  std::map<uint32_t, double> m_loadPenalty; /**< RSU node id -> smoothed load penalty (dB) */
+
+  uint64_t m_beaconsReceived; /**< Number of hello messages received */
+  uint64_t m_dhcpRequestsSent; /**< Number of DHCP requests sent */
+  uint64_t m_dhcpRetries; /**< Number of DHCP requests repeated without an offer */
+  uint64_t m_dhcpOffersReceived; /**< Number of DHCP offers received */
+  uint64_t m_handovers; /**< Number of RSU changes */
+  uint64_t m_pingPongs; /**< Number of handovers back to the previous RSU */
+  uint64_t m_preparedLeases; /**< Number of leases acquired before the break */
+  uint64_t m_dhcpReleasesSent; /**< Number of pre-acquired leases given back unused */
+  uint64_t m_leasesLeaked; /**< Prepared leases dropped out of range of their RSU, not released */
+
+  TracedCallback<uint32_t, double, double> m_beaconRxTrace; /**< Hello message received */
+  TracedCallback<Ipv4Address, bool> m_dhcpRequestTxTrace; /**< DHCP request sent */
+  TracedCallback<uint32_t, Ipv4Address> m_dhcpOfferRxTrace; /**< DHCP offer received */
+  TracedCallback<uint32_t, uint32_t> m_handoverTrace; /**< RSU changed */
+  TracedCallback<uint32_t, uint32_t> m_pingPongTrace; /**< Handover back to the previous RSU */
+  TracedCallback<const HandoverTimeline &> m_handoverTimelineTrace; /**< Handover completed */
 };
 } // namespace ns3
 #endif
\ No newline at end of file
@@ -0,0 +1,264 @@
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-phy-state-helper.h"
+#include "channel-heatmap.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("channel-heatmap");
+NS_OBJECT_ENSURE_REGISTERED (ChannelHeatmap);
+
+TypeId
+ChannelHeatmap::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::ChannelHeatmap")
+          .SetParent<Object> ()
+          .AddConstructor<ChannelHeatmap> ()
+          .AddAttribute ("CellSize", "Side of a heatmap cell (m)", DoubleValue (20),
+                         MakeDoubleAccessor (&ChannelHeatmap::m_cellSize),
+                         MakeDoubleChecker<double> (1))
+          .AddAttribute ("Window", "Time window of one heatmap", TimeValue (Seconds (1)),
+                         MakeTimeAccessor (&ChannelHeatmap::m_window), MakeTimeChecker ())
+          .AddAttribute ("MinBound", "Lower corner of the map", VectorValue (Vector (0, 0, 0)),
+                         MakeVectorAccessor (&ChannelHeatmap::m_minBound), MakeVectorChecker ())
+          .AddAttribute ("MaxBound", "Upper corner of the map",
+                         VectorValue (Vector (200, 200, 0)),
+                         MakeVectorAccessor (&ChannelHeatmap::m_maxBound), MakeVectorChecker ())
+          .AddAttribute ("FileName", "Columnar heatmap file",
+                         StringValue ("contrib/vanetsim/results/channel-heatmap.vcol"),
+                         MakeStringAccessor (&ChannelHeatmap::m_fileName), MakeStringChecker ());
+  return tid;
+}
+
+TypeId
+ChannelHeatmap::GetInstanceTypeId () const
+{
+  return ChannelHeatmap::GetTypeId ();
+}
+
+ChannelHeatmap::ChannelHeatmap () : m_columns (0), m_rows (0), m_current (0)
+{
+}
+
+ChannelHeatmap::~ChannelHeatmap ()
+{
+}
+
+void
+ChannelHeatmap::DoDispose ()
+{
+  m_windowEvent.Cancel ();
+  m_nodes.clear ();
+  m_writer = 0;
+  Object::DoDispose ();
+}
+
+void
+ChannelHeatmap::InstallAll ()
+{
+  NodeContainer nodes;
+  for (NodeList::Iterator n = NodeList::Begin (); n != NodeList::End (); n++)
+    nodes.Add (*n);
+  Install (nodes);
+}
+
+void
+ChannelHeatmap::Install (NodeContainer nodes)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_writer)
+    Open ();
+
+  for (NodeContainer::Iterator n = nodes.Begin (); n != nodes.End (); n++)
+    for (uint32_t d = 0; d < (*n)->GetNDevices (); d++)
+      {
+        Ptr<WifiNetDevice> dev = DynamicCast<WifiNetDevice> ((*n)->GetDevice (d));
+        if (!dev)
+          continue;
+
+        uint32_t index = m_nodes.size ();
+        m_nodes.push_back ((*n)->GetObject<MobilityModel> ());
+
+        Ptr<WifiPhy> phy = dev->GetPhy ();
+        PointerValue state;
+        phy->GetAttribute ("State", state);
+        state.Get<WifiPhyStateHelper> ()->TraceConnectWithoutContext (
+            "State", MakeBoundCallback (&ChannelHeatmap::PhyState, this, index));
+        state.Get<WifiPhyStateHelper> ()->TraceConnectWithoutContext (
+            "RxError", MakeBoundCallback (&ChannelHeatmap::RxError, this, index));
+        phy->TraceConnectWithoutContext ("PhyTxDrop",
+                                         MakeBoundCallback (&ChannelHeatmap::TxDrop, this, index));
+        dev->GetMac ()->TraceConnectWithoutContext (
+            "MacTxDrop", MakeBoundCallback (&ChannelHeatmap::TxDrop, this, index));
+        break;
+      }
+}
+
+void
+ChannelHeatmap::Open ()
+{
+  m_columns = std::max (1.0, std::ceil ((m_maxBound.x - m_minBound.x) / m_cellSize));
+  m_rows = std::max (1.0, std::ceil ((m_maxBound.y - m_minBound.y) / m_cellSize));
+  for (auto &cells : m_cells)
+    cells.assign (m_columns * m_rows, Cell ());
+  m_current = Simulator::Now ().GetTimeStep () / m_window.GetTimeStep ();
+
+  // registered before the writer's own Close, so the last window is written first
+  Simulator::ScheduleDestroy (&ChannelHeatmap::Finish, this);
+
+  m_writer = CreateObject<ResultsWriter> ();
+  m_writer->SetAttribute ("FileName", StringValue (m_fileName));
+  m_colTime = m_writer->AddColumn ("time_s", ResultsWriter::FIXED, 0.001);
+  m_colX = m_writer->AddColumn ("x_m", ResultsWriter::FIXED, 0.1);
+  m_colY = m_writer->AddColumn ("y_m", ResultsWriter::FIXED, 0.1);
+  m_colNodes = m_writer->AddColumn ("nodes", ResultsWriter::INT64);
+  m_colTx = m_writer->AddColumn ("tx_ms", ResultsWriter::FIXED, 0.01);
+  m_colRx = m_writer->AddColumn ("rx_ms", ResultsWriter::FIXED, 0.01);
+  m_colCca = m_writer->AddColumn ("cca_busy_ms", ResultsWriter::FIXED, 0.01);
+  m_colBusy = m_writer->AddColumn ("busy_ratio", ResultsWriter::FIXED, 0.0001);
+  m_colRxErrors = m_writer->AddColumn ("rx_errors", ResultsWriter::INT64);
+  m_colDrops = m_writer->AddColumn ("drops", ResultsWriter::INT64);
+  m_writer->Open ();
+
+  m_windowEvent = Simulator::Schedule (GetWindowStart (m_current + 1) - Simulator::Now (),
+                                       &ChannelHeatmap::EndWindow, this);
+}
+
+int32_t
+ChannelHeatmap::GetCell (uint32_t index) const
+{
+  Vector pos = m_nodes[index]->GetPosition ();
+  if (pos.x < m_minBound.x || pos.y < m_minBound.y || pos.x >= m_maxBound.x ||
+      pos.y >= m_maxBound.y)
+    return -1;
+  uint32_t column = (pos.x - m_minBound.x) / m_cellSize;
+  uint32_t row = (pos.y - m_minBound.y) / m_cellSize;
+  return row * m_columns + column;
+}
+
+Time
+ChannelHeatmap::GetWindowStart (int64_t window) const
+{
+  return TimeStep (m_window.GetTimeStep () * window);
+}
+
+std::vector<ChannelHeatmap::Cell> &
+ChannelHeatmap::GetCells (int64_t window)
+{
+  return m_cells[window & 1];
+}
+
+void
+ChannelHeatmap::PhyState (ChannelHeatmap *heatmap, uint32_t index, Time start, Time duration,
+                          WifiPhyState state)
+{
+  if (state != WifiPhyState::TX && state != WifiPhyState::RX && state != WifiPhyState::CCA_BUSY)
+    return;
+  int32_t cell = heatmap->GetCell (index);
+  if (cell < 0)
+    return;
+
+  // split the period between the current and the previous window
+  Time windowStart = heatmap->GetWindowStart (heatmap->m_current);
+  Time end = start + duration;
+  Time parts[2] = {end - std::max (start, windowStart),
+                   std::max (Time (0), std::min (end, windowStart) -
+                                           std::max (start, windowStart - heatmap->m_window))};
+  for (int i = 0; i < 2; i++)
+    {
+      if (!parts[i].IsStrictlyPositive ())
+        continue;
+      Cell &c = heatmap->GetCells (heatmap->m_current - i)[cell];
+      if (state == WifiPhyState::TX)
+        c.txTime += parts[i].GetSeconds ();
+      else if (state == WifiPhyState::RX)
+        c.rxTime += parts[i].GetSeconds ();
+      else
+        c.ccaTime += parts[i].GetSeconds ();
+    }
+}
+
+void
+ChannelHeatmap::RxError (ChannelHeatmap *heatmap, uint32_t index, Ptr<const Packet> packet,
+                         double snr)
+{
+  int32_t cell = heatmap->GetCell (index);
+  if (cell >= 0)
+    heatmap->GetCells (heatmap->m_current)[cell].rxErrors++;
+}
+
+void
+ChannelHeatmap::TxDrop (ChannelHeatmap *heatmap, uint32_t index, Ptr<const Packet> packet)
+{
+  int32_t cell = heatmap->GetCell (index);
+  if (cell >= 0)
+    heatmap->GetCells (heatmap->m_current)[cell].drops++;
+}
+
+void
+ChannelHeatmap::EndWindow ()
+{
+  std::vector<Cell> &cells = GetCells (m_current);
+  for (uint32_t i = 0; i < m_nodes.size (); i++)
+    {
+      int32_t cell = GetCell (i);
+      if (cell >= 0)
+        cells[cell].nodes++;
+    }
+
+  // the previous window can no longer receive busy time
+  if (m_current > 0)
+    Flush (m_current - 1);
+
+  m_current++;
+  m_windowEvent = Simulator::Schedule (m_window, &ChannelHeatmap::EndWindow, this);
+}
+
+void
+ChannelHeatmap::Flush (int64_t window)
+{
+  std::vector<Cell> &cells = GetCells (window);
+  double time = GetWindowStart (window).GetSeconds ();
+  double length = m_window.GetSeconds ();
+
+  for (uint32_t i = 0; i < cells.size (); i++)
+    {
+      Cell &c = cells[i];
+      double busy = c.txTime + c.rxTime + c.ccaTime;
+      if (c.nodes || busy > 0 || c.rxErrors || c.drops)
+        {
+          m_writer->SetDouble (m_colTime, time);
+          m_writer->SetDouble (m_colX, m_minBound.x + (i % m_columns + 0.5) * m_cellSize);
+          m_writer->SetDouble (m_colY, m_minBound.y + (i / m_columns + 0.5) * m_cellSize);
+          m_writer->SetInt (m_colNodes, c.nodes);
+          m_writer->SetDouble (m_colTx, c.txTime * 1000);
+          m_writer->SetDouble (m_colRx, c.rxTime * 1000);
+          m_writer->SetDouble (m_colCca, c.ccaTime * 1000);
+          m_writer->SetDouble (m_colBusy, busy / (std::max (c.nodes, 1u) * length));
+          m_writer->SetInt (m_colRxErrors, c.rxErrors);
+          m_writer->SetInt (m_colDrops, c.drops);
+          m_writer->EndRow ();
+        }
+      c = Cell ();
+    }
+}
+
+void
+ChannelHeatmap::Finish ()
+{
+  // the current window is incomplete and was never sampled for nodes
+  if (m_writer && m_current > 0)
+    Flush (m_current - 1);
+}
+
+} // namespace ns3
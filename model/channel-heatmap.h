@@ -0,0 +1,100 @@
+#ifndef CHANNEL_HEATMAP_H
+#define CHANNEL_HEATMAP_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/node-container.h"
+#include "ns3/mobility-model.h"
+#include "ns3/vector.h"
+#include "ns3/wifi-phy-state.h"
+#include "results-writer.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Spatial heatmap of 802.11p channel utilization.
+ *
+ * The map between MinBound and MaxBound is cut in square cells of CellSize
+ * meters. For every Window, each cell accumulates the PHY TX, RX and
+ * CCA-busy time (WifiPhyStateHelper State trace), the failed receptions
+ * (RxError, mostly collisions) and the dropped frames (PhyTxDrop,
+ * MacTxDrop) of the nodes standing in it, plus the number of nodes found in
+ * it at the end of the window.
+ *
+ * Busy periods are split between the window they end in and the previous
+ * one, so windows are written one window late. Only the cells with nodes or
+ * activity are written, as rows of a ResultsWriter file:
+ * time_s, x_m, y_m (cell center), nodes, tx_ms, rx_ms, cca_busy_ms,
+ * busy_ratio (busy time / (nodes x window)), rx_errors, drops.
+ */
+class ChannelHeatmap : public ns3::Object
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  ChannelHeatmap ();
+  ~ChannelHeatmap ();
+
+  /** Start binning the Wi-Fi devices of the nodes, from now */
+  void Install (NodeContainer nodes);
+  /** Install on every node of the NodeList */
+  void InstallAll ();
+
+private:
+  struct Cell
+  {
+    double txTime; /**< seconds */
+    double rxTime; /**< seconds */
+    double ccaTime; /**< seconds */
+    uint32_t rxErrors;
+    uint32_t drops;
+    uint32_t nodes;
+  };
+
+  virtual void DoDispose (void);
+
+  void Open ();
+  void EndWindow ();
+  void Flush (int64_t window);
+  void Finish ();
+
+  /** Cell index of the node, or -1 outside the map */
+  int32_t GetCell (uint32_t index) const;
+  Time GetWindowStart (int64_t window) const;
+  std::vector<Cell> &GetCells (int64_t window);
+
+  static void PhyState (ChannelHeatmap *heatmap, uint32_t index, Time start, Time duration,
+                        WifiPhyState state);
+  static void RxError (ChannelHeatmap *heatmap, uint32_t index, Ptr<const Packet> packet,
+                       double snr);
+  static void TxDrop (ChannelHeatmap *heatmap, uint32_t index, Ptr<const Packet> packet);
+
+  double m_cellSize; /**< Cell side (m) */
+  Time m_window; /**< Time window of one heatmap */
+  Vector m_minBound; /**< Lower corner of the map */
+  Vector m_maxBound; /**< Upper corner of the map */
+  std::string m_fileName; /**< Output file */
+
+  uint32_t m_columns; /**< Cells along x */
+  uint32_t m_rows; /**< Cells along y */
+  std::vector<Ptr<MobilityModel>> m_nodes; /**< Mobility of the installed nodes */
+  std::vector<Cell> m_cells[2]; /**< Accumulators of the current and previous windows */
+  int64_t m_current; /**< Index of the current window */
+  EventId m_windowEvent; /**< End of the current window */
+
+  Ptr<ResultsWriter> m_writer; /**< Heatmap rows */
+  uint32_t m_colTime;
+  uint32_t m_colX;
+  uint32_t m_colY;
+  uint32_t m_colNodes;
+  uint32_t m_colTx;
+  uint32_t m_colRx;
+  uint32_t m_colCca;
+  uint32_t m_colBusy;
+  uint32_t m_colRxErrors;
+  uint32_t m_colDrops;
+};
+} // namespace ns3
+#endif
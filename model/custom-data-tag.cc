@@ -7,6 +7,8 @@
 #include "custom-data-tag.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include <algorithm>
+#include <cmath>
 
 namespace ns3 {
 
@@ -18,12 +20,20 @@ CustomDataTag::CustomDataTag ()
   m_timestamp = Simulator::Now ();
   m_nodeId = -1;
   m_ipAddr = 0;
+  m_leases = 0;
+  m_channelBusy = 0;
+  m_queueLength = 0;
+  m_serviceChannel = 0;
 }
 CustomDataTag::CustomDataTag (uint32_t node_id)
 {
   m_timestamp = Simulator::Now ();
   m_nodeId = node_id;
   m_ipAddr = 0;
+  m_leases = 0;
+  m_channelBusy = 0;
+  m_queueLength = 0;
+  m_serviceChannel = 0;
 }
 
 CustomDataTag::~CustomDataTag ()
@@ -47,13 +57,16 @@ CustomDataTag::GetInstanceTypeId (void) const
 /** The size required for the data contained within tag is:
  *   	size needed for a ns3::Vector for position +
  * 		size needed for a ns3::Time for timestamp + 
- * 		size needed for a uint32_t for node id
+ * 		size needed for a uint32_t for node id +
+ * 		size needed for the RSU load (leases, busy ratio, queue length) +
+ * 		size needed for the service channel
  */
 uint32_t
 CustomDataTag::GetSerializedSize (void) const
 {
   return sizeof (Vector) + sizeof (ns3::Time) + sizeof (uint32_t) + sizeof (uint8_t) +
-         sizeof (uint32_t) + sizeof (uint32_t);
+         sizeof (uint32_t) + sizeof (uint32_t) + sizeof (uint16_t) + sizeof (uint8_t) +
+         sizeof (uint16_t) + sizeof (uint8_t);
 }
 /**
  * The order of how you do Serialize() should match the order of Deserialize()
@@ -76,6 +89,11 @@ CustomDataTag::Serialize (TagBuffer i) const
   i.WriteU32 (m_ipAddr);
   //
   i.WriteU32 (m_mask);
+  //Then the RSU load
+  i.WriteU16 (m_leases);
+  i.WriteU8 (m_channelBusy);
+  i.WriteU16 (m_queueLength);
+  i.WriteU8 (m_serviceChannel);
 }
 /** This function reads data from a buffer and store it in class's instance variables.
  */
@@ -98,6 +116,11 @@ CustomDataTag::Deserialize (TagBuffer i)
   m_ipAddr = i.ReadU32 ();
   //Extract
   m_mask = i.ReadU32 ();
+  //Extract the RSU load
+  m_leases = i.ReadU16 ();
+  m_channelBusy = i.ReadU8 ();
+  m_queueLength = i.ReadU16 ();
+  m_serviceChannel = i.ReadU8 ();
 }
 /**
  * This function can be used with ASCII traces if enabled. 
@@ -170,6 +193,54 @@ CustomDataTag::GetMask ()
   return m_mask;
 }
 
+uint16_t
+CustomDataTag::GetLeases ()
+{
+  return m_leases;
+}
+
+double
+CustomDataTag::GetChannelBusy ()
+{
+  return m_channelBusy / 255.0;
+}
+
+uint16_t
+CustomDataTag::GetQueueLength ()
+{
+  return m_queueLength;
+}
+
+uint8_t
+CustomDataTag::GetServiceChannel ()
+{
+  return m_serviceChannel;
+}
+
+void
+CustomDataTag::SetLeases (uint32_t leases)
+{
+  m_leases = std::min<uint32_t> (leases, 0xffff);
+}
+
+void
+CustomDataTag::SetChannelBusy (double ratio)
+{
+  m_channelBusy = std::round (std::min (1.0, std::max (0.0, ratio)) * 255);
+}
+
+void
+CustomDataTag::SetQueueLength (uint32_t packets)
+{
+  m_queueLength = std::min<uint32_t> (packets, 0xffff);
+}
+
+void
+CustomDataTag::SetServiceChannel (uint8_t channel)
+{
+  m_serviceChannel = channel;
+}
+
 void
 CustomDataTag::PrepareHeaderHelloMessage ()
 {
@@ -182,6 +253,12 @@ CustomDataTag::PrepareHeaderDhcpMessage ()
   m_msgType = 0x02;
 }
 
+void
+CustomDataTag::PrepareHeaderDhcpRelease ()
+{
+  m_msgType = 0x03;
+}
+
 bool
 CustomDataTag::isHelloMessage ()
 {
@@ -194,4 +271,10 @@ CustomDataTag::isDhcpMessage ()
   return (m_msgType == 0x02) ? true : false;
 }
 
+bool
+CustomDataTag::isDhcpRelease ()
+{
+  return m_msgType == 0x03;
+}
+
 } /* namespace ns3 */
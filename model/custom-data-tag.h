@@ -29,12 +29,20 @@ public:
   Time GetTimestamp ();
   uint32_t GetIpAddr ();
   uint32_t GetMask ();
+  uint16_t GetLeases ();
+  double GetChannelBusy ();
+  uint16_t GetQueueLength ();
+  uint8_t GetServiceChannel ();
 
   void SetPosition (Vector pos);
   void SetNodeId (uint32_t node_id);
   void SetTimestamp (Time t);
   void SetIpAddr (uint32_t ipAddr);
   void SetMask (uint32_t mask);
+  void SetLeases (uint32_t leases);
+  void SetChannelBusy (double ratio);
+  void SetQueueLength (uint32_t packets);
+  void SetServiceChannel (uint8_t channel);
 
   void PrepareHeaderHelloMessage ();
   bool isHelloMessage ();
@@ -42,6 +50,10 @@ public:
   void PrepareHeaderDhcpMessage ();
   bool isDhcpMessage ();
 
+  /** Lease given back to its RSU, the address in the IP field */
+  void PrepareHeaderDhcpRelease ();
+  bool isDhcpRelease ();
+
   CustomDataTag ();
   CustomDataTag (uint32_t node_id);
   virtual ~CustomDataTag ();
@@ -53,6 +65,13 @@ private:
   uint32_t m_ipAddr;
   uint32_t m_mask;
 
+  /** Load of the sending RSU, in hello messages */
+  uint16_t m_leases;
+  uint8_t m_channelBusy; /**< Busy ratio of the channel in 1/255 */
+  uint16_t m_queueLength;
+  /** SCH of the RSU's service radio, in hellos and offers (0: single channel) */
+  uint8_t m_serviceChannel;
+
   /** Current position */
   Vector m_currentPosition;
   /** Timestamp this tag was created */
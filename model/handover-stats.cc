@@ -0,0 +1,152 @@
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/callback.h"
+#include "handover-stats.h"
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("handover-stats");
+NS_OBJECT_ENSURE_REGISTERED (HandoverStats);
+
+Time HandoverStats::s_binWidth = MilliSeconds (100);
+uint32_t HandoverStats::s_nBins = 101;
+
+HandoverStats::Distribution::Distribution ()
+    : count (0),
+      sum (0),
+      sumSquares (0),
+      min (std::numeric_limits<double>::max ()),
+      max (0),
+      bins (s_nBins, 0)
+{
+}
+
+void
+HandoverStats::Distribution::Add (double ms)
+{
+  count++;
+  sum += ms;
+  sumSquares += ms * ms;
+  min = std::min (min, ms);
+  max = std::max (max, ms);
+
+  uint32_t bin = (ms < 0) ? 0 : (uint32_t) (ms / s_binWidth.GetMilliSeconds ());
+  bins.at (std::min (bin, s_nBins - 1))++;
+}
+
+double
+HandoverStats::Distribution::Mean () const
+{
+  return count ? sum / count : 0;
+}
+
+double
+HandoverStats::Distribution::StdDev () const
+{
+  if (count < 2)
+    return 0;
+  double mean = Mean ();
+  return std::sqrt (std::max (0.0, sumSquares / count - mean * mean));
+}
+
+TypeId
+HandoverStats::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::HandoverStats").SetParent<Object> ().AddConstructor<HandoverStats> ();
+  return tid;
+}
+
+TypeId
+HandoverStats::GetInstanceTypeId () const
+{
+  return HandoverStats::GetTypeId ();
+}
+
+HandoverStats::HandoverStats ()
+{
+}
+
+HandoverStats::~HandoverStats ()
+{
+}
+
+void
+HandoverStats::DoDispose ()
+{
+  if (m_timelineFile.is_open ())
+    m_timelineFile.close ();
+  Object::DoDispose ();
+}
+
+void
+HandoverStats::Install (Ptr<BeaconSearchNet> app)
+{
+  app->TraceConnectWithoutContext ("HandoverTimeline",
+                                   MakeCallback (&HandoverStats::NotifyHandoverTimeline, this));
+}
+
+void
+HandoverStats::InstallAll ()
+{
+  Config::ConnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::BeaconSearchNet/HandoverTimeline",
+                                 MakeCallback (&HandoverStats::NotifyHandoverTimeline, this));
+}
+
+void
+HandoverStats::EnableTimelineFile (std::string filename)
+{
+  m_timelineFile.open (filename.c_str (), std::ofstream::out | std::ofstream::trunc);
+  if (!m_timelineFile.is_open ())
+    NS_FATAL_ERROR ("Can't open handover timeline file " << filename);
+  m_timelineFile << "vehicle,old_rsu,new_rsu,last_beacon_s,detection_s,dhcp_request_s,"
+                    "dhcp_offer_s,address_swap_s,dhcp_requests"
+                 << std::endl;
+}
+
+void
+HandoverStats::NotifyHandoverTimeline (const BeaconSearchNet::HandoverTimeline &timeline)
+{
+  PairStats &stats = m_pairs[RsuPair (timeline.oldRsuId, timeline.newRsuId)];
+
+  stats.detection.Add ((timeline.detection - timeline.lastServingBeacon).GetSeconds () * 1000);
+  stats.signaling.Add ((timeline.addressSwap - timeline.dhcpRequest).GetSeconds () * 1000);
+  stats.interruption.Add ((timeline.addressSwap - timeline.lastServingBeacon).GetSeconds () *
+                          1000);
+
+  if (m_timelineFile.is_open ())
+    m_timelineFile << timeline.vehicleId << "," << timeline.oldRsuId << "," << timeline.newRsuId
+                   << "," << timeline.lastServingBeacon.GetSeconds () << ","
+                   << timeline.detection.GetSeconds () << ","
+                   << timeline.dhcpRequest.GetSeconds () << ","
+                   << timeline.dhcpOffer.GetSeconds () << ","
+                   << timeline.addressSwap.GetSeconds () << "," << timeline.dhcpRequests << "\n";
+}
+
+const std::map<HandoverStats::RsuPair, HandoverStats::PairStats> &
+HandoverStats::GetPairStats () const
+{
+  return m_pairs;
+}
+
+void
+HandoverStats::Print (std::ostream &os) const
+{
+  os << std::fixed << std::setprecision (1);
+  os << "old-rsu new-rsu count | detection ms (mean/sd/min/max) | signaling ms | interruption ms"
+     << std::endl;
+  for (auto const &p : m_pairs)
+    {
+      os << std::setw (7) << p.first.first << " " << std::setw (7) << p.first.second << " "
+         << std::setw (5) << p.second.interruption.count;
+      for (const Distribution *d :
+           {&p.second.detection, &p.second.signaling, &p.second.interruption})
+        os << " | " << d->Mean () << "/" << d->StdDev () << "/" << d->min << "/" << d->max;
+      os << std::endl;
+    }
+}
+
+} // namespace ns3
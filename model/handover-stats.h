@@ -0,0 +1,79 @@
+#ifndef HANDOVER_STATS_H
+#define HANDOVER_STATS_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "beacon-search-net.h"
+#include <map>
+#include <vector>
+#include <fstream>
+
+namespace ns3 {
+
+/**
+ * Collects the HandoverTimeline records of BeaconSearchNet apps and aggregates
+ * detection delay, signaling delay and total interruption per (old, new) RSU pair.
+ *
+ *  detection delay    = detection - lastServingBeacon
+ *  signaling delay    = addressSwap - dhcpRequest (0 with a pre-acquired lease)
+ *  total interruption = addressSwap - lastServingBeacon
+ */
+class HandoverStats : public ns3::Object
+{
+public:
+  /** Fixed-width histogram plus running moments of a delay (in milliseconds) */
+  struct Distribution
+  {
+    Distribution ();
+    void Add (double ms);
+    double Mean () const;
+    double StdDev () const;
+
+    uint64_t count;
+    double sum;
+    double sumSquares;
+    double min;
+    double max;
+    std::vector<uint32_t> bins; /**< last bin counts overflow */
+  };
+
+  struct PairStats
+  {
+    Distribution detection;
+    Distribution signaling;
+    Distribution interruption;
+  };
+
+  typedef std::pair<uint32_t, uint32_t> RsuPair; /**< (old RSU id, new RSU id) */
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  HandoverStats ();
+  ~HandoverStats ();
+
+  /** Connect to the HandoverTimeline trace of one vehicle app */
+  void Install (Ptr<BeaconSearchNet> app);
+  /** Connect to every BeaconSearchNet installed so far */
+  void InstallAll ();
+
+  /** Write every timeline record to a CSV file as it arrives */
+  void EnableTimelineFile (std::string filename);
+
+  void NotifyHandoverTimeline (const BeaconSearchNet::HandoverTimeline &timeline);
+
+  const std::map<RsuPair, PairStats> &GetPairStats () const;
+
+  /** Print the distribution of each RSU pair */
+  void Print (std::ostream &os) const;
+
+private:
+  virtual void DoDispose (void);
+
+  static Time s_binWidth; /**< Histogram bin width */
+  static uint32_t s_nBins; /**< Histogram bins (including overflow) */
+
+  std::map<RsuPair, PairStats> m_pairs; /**< Aggregated delays per RSU pair */
+  std::ofstream m_timelineFile; /**< Optional per-handover records */
+};
+} // namespace ns3
+#endif
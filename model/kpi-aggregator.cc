@@ -0,0 +1,307 @@
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+#include "ns3/callback.h"
+#include "ns3/internet-module.h"
+#include "kpi-aggregator.h"
+#include "beacon-rsu-net.h"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("kpi-aggregator");
+NS_OBJECT_ENSURE_REGISTERED (KpiAggregator);
+
+KpiAggregator::RsuCounters::RsuCounters () : requestsTx (0), requestsRx (0), offersTx (0), offersRx (0)
+{
+}
+
+double
+KpiAggregator::RsuCounters::GetDhcpSuccessRate () const
+{
+  uint64_t sent = requestsTx + offersTx;
+  return sent ? (double) (requestsRx + offersRx) / sent : 0;
+}
+
+TypeId
+KpiAggregator::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::KpiAggregator")
+          .SetParent<Object> ()
+          .AddConstructor<KpiAggregator> ()
+          .AddAttribute ("FileName", "Summary written at Simulator::Destroy (empty: none)",
+                         StringValue ("contrib/vanetsim/results/kpi-summary.txt"),
+                         MakeStringAccessor (&KpiAggregator::m_fileName), MakeStringChecker ())
+          .AddAttribute ("RelativeAccuracy", "Relative error of the reported percentiles",
+                         DoubleValue (0.01), MakeDoubleAccessor (&KpiAggregator::m_accuracy),
+                         MakeDoubleChecker<double> (0.0001, 0.5));
+  return tid;
+}
+
+TypeId
+KpiAggregator::GetInstanceTypeId () const
+{
+  return KpiAggregator::GetTypeId ();
+}
+
+KpiAggregator::KpiAggregator ()
+    : m_interruption (0),
+      m_detection (0),
+      m_signaling (0),
+      m_beaconInterArrival (0),
+      m_beaconJitter (0),
+      m_dhcpRtt (0)
+{
+}
+
+KpiAggregator::~KpiAggregator ()
+{
+}
+
+void
+KpiAggregator::DoDispose ()
+{
+  m_arrivals.clear ();
+  m_dhcpSent.clear ();
+  Object::DoDispose ();
+}
+
+void
+KpiAggregator::InstallAll ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_sketches.clear ();
+  m_interruption = &m_sketches["handover_interruption_ms"];
+  m_detection = &m_sketches["handover_detection_ms"];
+  m_signaling = &m_sketches["handover_signaling_ms"];
+  m_beaconInterArrival = &m_sketches["beacon_interarrival_ms"];
+  m_beaconJitter = &m_sketches["beacon_jitter_ms"];
+  m_dhcpRtt = &m_sketches["dhcp_rtt_ms"];
+  for (auto &s : m_sketches)
+    s.second = QuantileSketch (m_accuracy);
+
+  for (NodeList::Iterator n = NodeList::Begin (); n != NodeList::End (); n++)
+    {
+      uint32_t nodeId = (*n)->GetId ();
+      for (uint32_t i = 0; i < (*n)->GetNApplications (); i++)
+        {
+          Ptr<Application> app = (*n)->GetApplication (i);
+          if (DynamicCast<BeaconRsuNet> (app))
+            {
+              m_rsuByAddr[(*n)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ().Get ()] = nodeId;
+              m_rsus[nodeId];
+              app->TraceConnectWithoutContext (
+                  "DhcpRequestRx", MakeBoundCallback (&KpiAggregator::DhcpRequestRx, this, nodeId));
+              app->TraceConnectWithoutContext (
+                  "DhcpOfferTx", MakeBoundCallback (&KpiAggregator::DhcpOfferTx, this, nodeId));
+            }
+          else if (DynamicCast<BeaconSearchNet> (app))
+            {
+              app->TraceConnectWithoutContext (
+                  "BeaconRx", MakeBoundCallback (&KpiAggregator::BeaconRx, this, nodeId));
+              app->TraceConnectWithoutContext (
+                  "DhcpRequestTx", MakeBoundCallback (&KpiAggregator::DhcpRequestTx, this, nodeId));
+              app->TraceConnectWithoutContext (
+                  "DhcpOfferRx", MakeBoundCallback (&KpiAggregator::DhcpOfferRx, this, nodeId));
+              app->TraceConnectWithoutContext (
+                  "HandoverTimeline",
+                  MakeCallback (&KpiAggregator::NotifyHandoverTimeline, this));
+            }
+        }
+    }
+
+  if (!m_fileName.empty ())
+    Simulator::ScheduleDestroy (&KpiAggregator::WriteSummary, this);
+}
+
+void
+KpiAggregator::NotifyHandoverTimeline (const BeaconSearchNet::HandoverTimeline &timeline)
+{
+  m_detection->Add ((timeline.detection - timeline.lastServingBeacon).GetSeconds () * 1000);
+  m_signaling->Add ((timeline.addressSwap - timeline.dhcpRequest).GetSeconds () * 1000);
+  m_interruption->Add ((timeline.addressSwap - timeline.lastServingBeacon).GetSeconds () * 1000);
+}
+
+void
+KpiAggregator::BeaconRx (KpiAggregator *kpi, uint32_t nodeId, uint32_t rsuId, double signal,
+                         double noise)
+{
+  Time now = Simulator::Now ();
+  auto it = kpi->m_arrivals.find (std::make_pair (nodeId, rsuId));
+  if (it == kpi->m_arrivals.end ())
+    {
+      BeaconArrival arrival;
+      arrival.last = now;
+      arrival.lastDelta = Time (0);
+      kpi->m_arrivals.emplace (std::make_pair (nodeId, rsuId), arrival);
+      return;
+    }
+
+  Time delta = now - it->second.last;
+  kpi->m_beaconInterArrival->Add (delta.GetSeconds () * 1000);
+  if (!it->second.lastDelta.IsZero ())
+    kpi->m_beaconJitter->Add (Abs (delta - it->second.lastDelta).GetSeconds () * 1000);
+  it->second.last = now;
+  it->second.lastDelta = delta;
+}
+
+void
+KpiAggregator::DhcpRequestTx (KpiAggregator *kpi, uint32_t nodeId, Ipv4Address rsuAddr,
+                              bool retry)
+{
+  // a retry belongs to the same attempt, the round trip runs from its first request
+  if (!retry || kpi->m_dhcpSent.find (nodeId) == kpi->m_dhcpSent.end ())
+    kpi->m_dhcpSent[nodeId] = Simulator::Now ();
+  auto rsu = kpi->m_rsuByAddr.find (rsuAddr.Get ());
+  if (rsu != kpi->m_rsuByAddr.end ())
+    kpi->m_rsus[rsu->second].requestsTx++;
+}
+
+void
+KpiAggregator::DhcpOfferRx (KpiAggregator *kpi, uint32_t nodeId, uint32_t rsuId,
+                            Ipv4Address addr)
+{
+  auto sent = kpi->m_dhcpSent.find (nodeId);
+  if (sent != kpi->m_dhcpSent.end ())
+    {
+      kpi->m_dhcpRtt->Add ((Simulator::Now () - sent->second).GetSeconds () * 1000);
+      kpi->m_dhcpSent.erase (sent);
+    }
+  kpi->m_rsus[rsuId].offersRx++;
+}
+
+void
+KpiAggregator::DhcpRequestRx (KpiAggregator *kpi, uint32_t rsuId, uint32_t vehicleId,
+                              Ipv4Address addr)
+{
+  kpi->m_rsus[rsuId].requestsRx++;
+}
+
+void
+KpiAggregator::DhcpOfferTx (KpiAggregator *kpi, uint32_t rsuId, uint32_t vehicleId,
+                            Ipv4Address addr)
+{
+  kpi->m_rsus[rsuId].offersTx++;
+}
+
+void
+KpiAggregator::WriteSummary ()
+{
+  std::ofstream os (m_fileName.c_str (), std::ofstream::out | std::ofstream::trunc);
+  if (!os.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open KPI summary file " << m_fileName);
+      return;
+    }
+  Write (os);
+}
+
+void
+KpiAggregator::Write (std::ostream &os) const
+{
+  os << "# vanetsim kpi summary v1" << std::endl;
+  for (auto const &s : m_sketches)
+    {
+      os << "sketch " << s.first << " ";
+      s.second.Serialize (os);
+      os << std::endl;
+    }
+  for (auto const &r : m_rsus)
+    os << "rsu " << r.first << " " << r.second.requestsTx << " " << r.second.requestsRx << " "
+       << r.second.offersTx << " " << r.second.offersRx << std::endl;
+}
+
+bool
+KpiAggregator::Load (std::string fileName)
+{
+  std::ifstream is (fileName.c_str ());
+  if (!is.is_open ())
+    return false;
+
+  // read the whole file first, so a rejected file leaves the totals unchanged
+  std::vector<std::pair<std::string, QuantileSketch>> sketches;
+  std::vector<std::pair<uint32_t, RsuCounters>> rsus;
+  std::string line;
+  while (std::getline (is, line))
+    {
+      std::istringstream ls (line);
+      std::string kind, name;
+      if (!(ls >> kind) || kind[0] == '#')
+        continue;
+
+      if (kind == "sketch")
+        {
+          QuantileSketch sketch;
+          if (!(ls >> name) || !sketch.Deserialize (ls))
+            return false;
+          // buckets of different widths do not line up
+          if (std::fabs (sketch.GetRelativeAccuracy () - m_accuracy) > 1e-12)
+            {
+              NS_LOG_ERROR (fileName << ": sketch " << name << " has accuracy "
+                                     << sketch.GetRelativeAccuracy () << ", expected "
+                                     << m_accuracy);
+              return false;
+            }
+          sketches.emplace_back (name, sketch);
+        }
+      else if (kind == "rsu")
+        {
+          uint32_t id;
+          RsuCounters c;
+          if (!(ls >> id >> c.requestsTx >> c.requestsRx >> c.offersTx >> c.offersRx))
+            return false;
+          rsus.emplace_back (id, c);
+        }
+      else
+        return false;
+    }
+
+  for (auto const &s : sketches)
+    {
+      auto it = m_sketches.find (s.first);
+      if (it == m_sketches.end ())
+        m_sketches.emplace (s.first, s.second);
+      else
+        it->second.Merge (s.second);
+    }
+  for (auto const &r : rsus)
+    {
+      RsuCounters &total = m_rsus[r.first];
+      total.requestsTx += r.second.requestsTx;
+      total.requestsRx += r.second.requestsRx;
+      total.offersTx += r.second.offersTx;
+      total.offersRx += r.second.offersRx;
+    }
+  return true;
+}
+
+void
+KpiAggregator::PrintReport (std::ostream &os) const
+{
+  os << std::fixed << std::setprecision (2);
+  os << std::left << std::setw (26) << "kpi" << std::right << std::setw (10) << "count"
+     << std::setw (10) << "mean" << std::setw (10) << "p50" << std::setw (10) << "p95"
+     << std::setw (10) << "p99" << std::setw (10) << "max" << std::endl;
+  for (auto const &s : m_sketches)
+    os << std::left << std::setw (26) << s.first << std::right << std::setw (10)
+       << s.second.GetCount () << std::setw (10) << s.second.GetMean () << std::setw (10)
+       << s.second.GetQuantile (0.5) << std::setw (10) << s.second.GetQuantile (0.95)
+       << std::setw (10) << s.second.GetQuantile (0.99) << std::setw (10) << s.second.GetMax ()
+       << std::endl;
+
+  os << "rsu   dhcp-req-tx dhcp-req-rx dhcp-offer-tx dhcp-offer-rx dhcp-success" << std::endl;
+  for (auto const &r : m_rsus)
+    os << std::setw (5) << r.first << std::setw (12) << r.second.requestsTx << std::setw (12)
+       << r.second.requestsRx << std::setw (14) << r.second.offersTx << std::setw (14)
+       << r.second.offersRx << std::setw (13) << r.second.GetDhcpSuccessRate () << std::endl;
+}
+
+} // namespace ns3
@@ -0,0 +1,96 @@
+#ifndef KPI_AGGREGATOR_H
+#define KPI_AGGREGATOR_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+#include "beacon-search-net.h"
+#include "quantile-sketch.h"
+#include <map>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * Online KPI aggregation fed by the trace sources of the beacon apps.
+ *
+ * Distributions (handover delays, beacon inter-arrival and jitter, DHCP
+ * round-trip time from the first request of an attempt) are kept in
+ * QuantileSketches and the DHCP messages are counted per RSU, so memory
+ * does not grow with the run length. At Simulator::Destroy one summary is
+ * written to FileName. Summaries of several runs are merged with Load and
+ * printed with PrintReport (see vanet-kpi-merge).
+ */
+class KpiAggregator : public ns3::Object
+{
+public:
+  /** DHCP messages per RSU, for the DHCP success rate */
+  struct RsuCounters
+  {
+    RsuCounters ();
+    uint64_t requestsTx; /**< requests sent by vehicles to this RSU */
+    uint64_t requestsRx; /**< requests received by this RSU */
+    uint64_t offersTx; /**< offers sent by this RSU */
+    uint64_t offersRx; /**< offers from this RSU received by vehicles */
+    /** Fraction of the requests and offers that reached the other side */
+    double GetDhcpSuccessRate () const;
+  };
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  KpiAggregator ();
+  ~KpiAggregator ();
+
+  /** Connect to every BeaconRsuNet and BeaconSearchNet installed so far */
+  void InstallAll ();
+
+  /**
+   * Merge a summary written by another run. Returns false, merging nothing,
+   * on a malformed file or on sketches of another Accuracy.
+   */
+  bool Load (std::string fileName);
+  /** Write the mergeable summary */
+  void Write (std::ostream &os) const;
+  /** Human readable percentiles and DHCP success rates */
+  void PrintReport (std::ostream &os) const;
+
+  void NotifyHandoverTimeline (const BeaconSearchNet::HandoverTimeline &timeline);
+
+private:
+  struct BeaconArrival
+  {
+    Time last;
+    Time lastDelta;
+  };
+
+  virtual void DoDispose (void);
+  void WriteSummary ();
+
+  static void BeaconRx (KpiAggregator *kpi, uint32_t nodeId, uint32_t rsuId, double signal,
+                        double noise);
+  static void DhcpRequestTx (KpiAggregator *kpi, uint32_t nodeId, Ipv4Address rsuAddr,
+                             bool retry);
+  static void DhcpOfferRx (KpiAggregator *kpi, uint32_t nodeId, uint32_t rsuId, Ipv4Address addr);
+  static void DhcpRequestRx (KpiAggregator *kpi, uint32_t rsuId, uint32_t vehicleId,
+                             Ipv4Address addr);
+  static void DhcpOfferTx (KpiAggregator *kpi, uint32_t rsuId, uint32_t vehicleId,
+                           Ipv4Address addr);
+
+  std::string m_fileName; /**< Summary written at Simulator::Destroy (empty: none) */
+  double m_accuracy; /**< Relative accuracy of the sketches */
+
+  std::map<std::string, QuantileSketch> m_sketches; /**< KPI distributions by name */
+  QuantileSketch *m_interruption;
+  QuantileSketch *m_detection;
+  QuantileSketch *m_signaling;
+  QuantileSketch *m_beaconInterArrival;
+  QuantileSketch *m_beaconJitter;
+  QuantileSketch *m_dhcpRtt;
+
+  std::map<uint32_t, RsuCounters> m_rsus; /**< Counters by RSU id */
+  std::map<uint32_t, uint32_t> m_rsuByAddr; /**< RSU id by wireless ip address */
+  std::map<std::pair<uint32_t, uint32_t>, BeaconArrival> m_arrivals; /**< (vehicle, RSU) */
+  std::map<uint32_t, Time> m_dhcpSent; /**< First DHCP request of the attempt by vehicle */
+};
+} // namespace ns3
+#endif
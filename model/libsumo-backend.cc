@@ -0,0 +1,214 @@
+#include "ns3/log.h"
+#include "sumo-backend.h"
+
+// not in sumo-backend.cc: the traci module has its own copy of the libsumo types
+#ifdef VANETSIM_LIBSUMO
+#include <libsumo/libsumo.h>
+#include <memory>
+#endif
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("libsumo-backend");
+
+#ifdef VANETSIM_LIBSUMO
+static const double g_networkRange = 1e7; /**< Context subscription range (m) */
+
+bool
+LibsumoBackend::IsAvailable ()
+{
+  return true;
+}
+
+LibsumoBackend::LibsumoBackend () : m_running (false)
+{
+}
+
+LibsumoBackend::~LibsumoBackend ()
+{
+  Close ();
+}
+
+void
+LibsumoBackend::Start (const std::vector<std::string> &args)
+{
+  // libsumo takes the options without the binary name
+  libsumo::Simulation::load (std::vector<std::string> (args.begin () + 1, args.end ()));
+  m_running = true;
+  NS_LOG_INFO ("libsumo loaded");
+}
+
+void
+LibsumoBackend::Close ()
+{
+  if (!m_running)
+    return;
+  libsumo::Simulation::close ();
+  m_running = false;
+}
+
+void
+LibsumoBackend::SimulationStep (double time)
+{
+  libsumo::Simulation::step (time);
+}
+
+double
+LibsumoBackend::GetTime ()
+{
+  return libsumo::Simulation::getTime ();
+}
+
+void
+LibsumoBackend::Subscribe (bool dynamics, bool stops)
+{
+  std::vector<int> vars = {libsumo::VAR_POSITION3D, libsumo::VAR_SPEED, libsumo::VAR_ANGLE};
+  if (dynamics)
+    {
+      vars.push_back (libsumo::VAR_ACCELERATION);
+      vars.push_back (libsumo::VAR_ROAD_ID);
+    }
+  if (stops)
+    vars.push_back (libsumo::VAR_STOPSTATE);
+
+  // a context around any junction, with a range beyond any network, holds every vehicle
+  std::vector<std::string> junctions = libsumo::Junction::getIDList ();
+  NS_ABORT_MSG_IF (junctions.empty (), "SUMO network without junctions");
+  m_junction = junctions.front ();
+  libsumo::Junction::subscribeContext (m_junction, libsumo::CMD_GET_VEHICLE_VARIABLE,
+                                       g_networkRange, vars);
+  // ids of the step only: a widened interval is stepped one SUMO step at a time
+  libsumo::Simulation::subscribe (
+      {libsumo::VAR_DEPARTED_VEHICLES_IDS, libsumo::VAR_ARRIVED_VEHICLES_IDS});
+}
+
+void
+LibsumoBackend::GetFlows (std::vector<std::string> &departed, std::vector<std::string> &arrived)
+{
+  typedef libsumo::TraCIStringList List;
+  libsumo::TraCIResults r = libsumo::Simulation::getSubscriptionResults ();
+  auto d = std::dynamic_pointer_cast<List> (r[libsumo::VAR_DEPARTED_VEHICLES_IDS]);
+  auto a = std::dynamic_pointer_cast<List> (r[libsumo::VAR_ARRIVED_VEHICLES_IDS]);
+  departed = d ? d->value : std::vector<std::string> ();
+  arrived = a ? a->value : std::vector<std::string> ();
+}
+
+void
+LibsumoBackend::GetVehicles (std::vector<SumoVehicleState> &states)
+{
+  states.clear ();
+  libsumo::SubscriptionResults results =
+      libsumo::Junction::getContextSubscriptionResults (m_junction);
+  for (auto &v : results)
+    {
+      libsumo::TraCIResults &r = v.second;
+      SumoVehicleState state;
+      state.id = v.first;
+      auto pos = std::dynamic_pointer_cast<libsumo::TraCIPosition> (r[libsumo::VAR_POSITION3D]);
+      auto speed = std::dynamic_pointer_cast<libsumo::TraCIDouble> (r[libsumo::VAR_SPEED]);
+      auto angle = std::dynamic_pointer_cast<libsumo::TraCIDouble> (r[libsumo::VAR_ANGLE]);
+      auto accel = std::dynamic_pointer_cast<libsumo::TraCIDouble> (r[libsumo::VAR_ACCELERATION]);
+      auto road = std::dynamic_pointer_cast<libsumo::TraCIString> (r[libsumo::VAR_ROAD_ID]);
+      auto stop = std::dynamic_pointer_cast<libsumo::TraCIInt> (r[libsumo::VAR_STOPSTATE]);
+      if (!pos || !speed || !angle)
+        continue;
+      state.x = pos->x;
+      state.y = pos->y;
+      state.z = pos->z;
+      state.speed = speed->value;
+      state.angle = angle->value;
+      state.acceleration = accel ? accel->value : 0;
+      state.onJunction = road && road->value.compare (0, 1, ":") == 0;
+      state.stopState = stop ? stop->value : 0;
+      states.push_back (state);
+    }
+}
+
+void
+LibsumoBackend::Apply (const SumoCommand &c)
+{
+  switch (c.type)
+    {
+    case SumoCommand::SET_SPEED:
+      libsumo::Vehicle::setSpeed (c.vehicleId, c.value);
+      break;
+    case SumoCommand::SLOW_DOWN:
+      libsumo::Vehicle::slowDown (c.vehicleId, c.value, c.duration);
+      break;
+    case SumoCommand::SET_MAX_SPEED:
+      libsumo::Vehicle::setMaxSpeed (c.vehicleId, c.value);
+      break;
+    case SumoCommand::CHANGE_TARGET:
+      libsumo::Vehicle::changeTarget (c.vehicleId, c.edge);
+      break;
+    case SumoCommand::CHANGE_LANE:
+      libsumo::Vehicle::changeLane (c.vehicleId, c.lane, c.duration);
+      break;
+    case SumoCommand::SET_STOP:
+      libsumo::Vehicle::setStop (c.vehicleId, c.edge, c.value, c.lane, c.duration);
+      break;
+    case SumoCommand::RESUME:
+      libsumo::Vehicle::resume (c.vehicleId);
+      break;
+    }
+}
+
+#else
+// same declarations without libsumo, so every translation unit sees one class
+
+bool
+LibsumoBackend::IsAvailable ()
+{
+  return false;
+}
+
+LibsumoBackend::LibsumoBackend () : m_running (false)
+{
+  NS_FATAL_ERROR ("vanetsim was configured without --with-libsumo");
+}
+
+LibsumoBackend::~LibsumoBackend ()
+{
+}
+
+void
+LibsumoBackend::Start (const std::vector<std::string> &args)
+{
+}
+
+void
+LibsumoBackend::Close ()
+{
+}
+
+void
+LibsumoBackend::SimulationStep (double time)
+{
+}
+
+double
+LibsumoBackend::GetTime ()
+{
+  return 0;
+}
+
+void
+LibsumoBackend::Subscribe (bool dynamics, bool stops)
+{
+}
+
+void
+LibsumoBackend::GetVehicles (std::vector<SumoVehicleState> &states)
+{
+}
+
+void
+LibsumoBackend::GetFlows (std::vector<std::string> &departed, std::vector<std::string> &arrived)
+{
+}
+
+void
+LibsumoBackend::Apply (const SumoCommand &c)
+{
+}
+#endif
+} // namespace ns3
@@ -0,0 +1,223 @@
+#include "quantile-sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3 {
+
+/* Values below this are counted in the zero bucket */
+static const double SKETCH_MIN_VALUE = 1e-9;
+
+QuantileSketch::QuantileSketch (double relativeAccuracy, uint32_t maxBins)
+    : m_accuracy (relativeAccuracy),
+      m_gamma ((1 + relativeAccuracy) / (1 - relativeAccuracy)),
+      m_logGamma (std::log (m_gamma)),
+      m_maxBins (std::max (maxBins, 1u))
+{
+  Clear ();
+}
+
+void
+QuantileSketch::Clear ()
+{
+  m_offset = 0;
+  m_bins.clear ();
+  m_zero = 0;
+  m_count = 0;
+  m_sum = 0;
+  m_min = std::numeric_limits<double>::max ();
+  m_max = -std::numeric_limits<double>::max ();
+}
+
+int32_t
+QuantileSketch::Index (double value) const
+{
+  return (int32_t) std::ceil (std::log (value) / m_logGamma);
+}
+
+double
+QuantileSketch::Value (int32_t index) const
+{
+  // midpoint (in relative terms) of (gamma^(i-1), gamma^i]
+  return 2 * std::pow (m_gamma, index) / (m_gamma + 1);
+}
+
+void
+QuantileSketch::AddToBin (int32_t index, uint64_t n)
+{
+  if (m_bins.empty ())
+    {
+      m_offset = index;
+      m_bins.assign (1, 0);
+    }
+  else if (index < m_offset)
+    {
+      if (m_offset - index + m_bins.size () > m_maxBins)
+        index = m_offset; // collapsed into the lowest kept bucket
+      else
+        {
+          m_bins.insert (m_bins.begin (), m_offset - index, 0);
+          m_offset = index;
+        }
+    }
+  else if (index >= m_offset + (int32_t) m_bins.size ())
+    m_bins.resize (index - m_offset + 1, 0);
+
+  m_bins[index - m_offset] += n;
+  Collapse ();
+}
+
+void
+QuantileSketch::Collapse ()
+{
+  if (m_bins.size () <= m_maxBins)
+    return;
+
+  size_t excess = m_bins.size () - m_maxBins;
+  uint64_t low = 0;
+  for (size_t i = 0; i <= excess; i++)
+    low += m_bins[i];
+  m_bins.erase (m_bins.begin (), m_bins.begin () + excess);
+  m_bins[0] = low;
+  m_offset += excess;
+}
+
+void
+QuantileSketch::Add (double value)
+{
+  if (std::isnan (value))
+    return;
+
+  m_count++;
+  m_sum += value;
+  m_min = std::min (m_min, value);
+  m_max = std::max (m_max, value);
+
+  if (value < SKETCH_MIN_VALUE)
+    m_zero++;
+  else
+    AddToBin (Index (value), 1);
+}
+
+void
+QuantileSketch::Merge (const QuantileSketch &other)
+{
+  if (!other.m_count)
+    return;
+
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+  m_min = std::min (m_min, other.m_min);
+  m_max = std::max (m_max, other.m_max);
+  m_zero += other.m_zero;
+
+  // walk from the top so the lowest buckets are the ones collapsed
+  for (size_t i = other.m_bins.size (); i-- > 0;)
+    if (other.m_bins[i])
+      AddToBin (other.m_offset + (int32_t) i, other.m_bins[i]);
+}
+
+double
+QuantileSketch::GetQuantile (double q) const
+{
+  if (!m_count)
+    return 0;
+
+  double rank = std::min (std::max (q, 0.0), 1.0) * (m_count - 1);
+  uint64_t cumulative = m_zero;
+  if (cumulative > rank)
+    return std::max (m_min, 0.0);
+
+  for (size_t i = 0; i < m_bins.size (); i++)
+    {
+      cumulative += m_bins[i];
+      if (cumulative > rank)
+        return std::min (std::max (Value (m_offset + (int32_t) i), m_min), m_max);
+    }
+  return m_max;
+}
+
+uint64_t
+QuantileSketch::GetCount () const
+{
+  return m_count;
+}
+
+double
+QuantileSketch::GetSum () const
+{
+  return m_sum;
+}
+
+double
+QuantileSketch::GetMean () const
+{
+  return m_count ? m_sum / m_count : 0;
+}
+
+double
+QuantileSketch::GetMin () const
+{
+  return m_count ? m_min : 0;
+}
+
+double
+QuantileSketch::GetMax () const
+{
+  return m_count ? m_max : 0;
+}
+
+double
+QuantileSketch::GetRelativeAccuracy () const
+{
+  return m_accuracy;
+}
+
+void
+QuantileSketch::Serialize (std::ostream &os) const
+{
+  uint32_t nBins = 0;
+  for (uint64_t b : m_bins)
+    nBins += (b != 0);
+
+  os.precision (17);
+  os << m_accuracy << " " << m_count << " " << m_sum << " " << GetMin () << " " << GetMax ()
+     << " " << m_zero << " " << nBins;
+  for (size_t i = 0; i < m_bins.size (); i++)
+    if (m_bins[i])
+      os << " " << m_offset + (int32_t) i << ":" << m_bins[i];
+}
+
+bool
+QuantileSketch::Deserialize (std::istream &is)
+{
+  double accuracy;
+  uint64_t count, zero;
+  double sum, min, max;
+  uint32_t nBins;
+  if (!(is >> accuracy >> count >> sum >> min >> max >> zero >> nBins))
+    return false;
+
+  *this = QuantileSketch (accuracy, m_maxBins);
+  m_count = count;
+  m_sum = sum;
+  m_zero = zero;
+  if (count)
+    {
+      m_min = min;
+      m_max = max;
+    }
+  for (uint32_t i = 0; i < nBins; i++)
+    {
+      int32_t index;
+      char colon;
+      uint64_t n;
+      if (!(is >> index >> colon >> n) || colon != ':')
+        return false;
+      AddToBin (index, n);
+    }
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,60 @@
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Mergeable quantile sketch with bounded memory (logarithmic buckets, as in
+ * DDSketch). Values >= 0 are counted in the bucket ceil (log_gamma (v)),
+ * gamma = (1 + a) / (1 - a), so every quantile is returned with relative
+ * error a. At most MaxBins buckets are kept; beyond that the lowest buckets
+ * are collapsed. Two sketches with the same accuracy merge exactly.
+ */
+class QuantileSketch
+{
+public:
+  QuantileSketch (double relativeAccuracy = 0.01, uint32_t maxBins = 2048);
+
+  void Add (double value);
+  /** other must have the same relative accuracy, or the buckets do not line up */
+  void Merge (const QuantileSketch &other);
+  void Clear ();
+
+  /** q in [0, 1]; 0 if the sketch is empty */
+  double GetQuantile (double q) const;
+  uint64_t GetCount () const;
+  double GetSum () const;
+  double GetMean () const;
+  double GetMin () const;
+  double GetMax () const;
+  double GetRelativeAccuracy () const;
+
+  /** Single-line text form: "accuracy count sum min max zero nBins idx:n ..." */
+  void Serialize (std::ostream &os) const;
+  bool Deserialize (std::istream &is);
+
+private:
+  int32_t Index (double value) const;
+  double Value (int32_t index) const;
+  void AddToBin (int32_t index, uint64_t n);
+  void Collapse ();
+
+  double m_accuracy;
+  double m_gamma;
+  double m_logGamma;
+  uint32_t m_maxBins;
+
+  int32_t m_offset; /**< Index of m_bins[0] */
+  std::vector<uint64_t> m_bins; /**< Dense counts from m_offset */
+  uint64_t m_zero; /**< Values too close to zero for a log bucket */
+  uint64_t m_count;
+  double m_sum;
+  double m_min;
+  double m_max;
+};
+} // namespace ns3
+#endif
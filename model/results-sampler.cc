@@ -0,0 +1,142 @@
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+#include "ns3/mobility-model.h"
+#include "ns3/internet-module.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac-header.h"
+#include "results-sampler.h"
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("results-sampler");
+NS_OBJECT_ENSURE_REGISTERED (ResultsSampler);
+
+TypeId
+ResultsSampler::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::ResultsSampler")
+          .SetParent<Object> ()
+          .AddConstructor<ResultsSampler> ()
+          .AddAttribute ("Interval", "Sampling interval", TimeValue (Seconds (1)),
+                         MakeTimeAccessor (&ResultsSampler::m_interval), MakeTimeChecker ())
+          .AddAttribute ("FileName", "Columnar results file",
+                         StringValue ("contrib/vanetsim/results/vehicles.vcol"),
+                         MakeStringAccessor (&ResultsSampler::m_fileName), MakeStringChecker ());
+  return tid;
+}
+
+TypeId
+ResultsSampler::GetInstanceTypeId () const
+{
+  return ResultsSampler::GetTypeId ();
+}
+
+ResultsSampler::ResultsSampler ()
+{
+}
+
+ResultsSampler::~ResultsSampler ()
+{
+}
+
+void
+ResultsSampler::DoDispose ()
+{
+  m_sampleEvent.Cancel ();
+  m_vehicles.clear ();
+  m_writer = 0;
+  Object::DoDispose ();
+}
+
+Ptr<ResultsWriter>
+ResultsSampler::GetWriter () const
+{
+  return m_writer;
+}
+
+void
+ResultsSampler::InstallAll ()
+{
+  NS_LOG_FUNCTION (this);
+
+  for (NodeList::Iterator n = NodeList::Begin (); n != NodeList::End (); n++)
+    for (uint32_t i = 0; i < (*n)->GetNApplications (); i++)
+      {
+        Ptr<BeaconSearchNet> app = DynamicCast<BeaconSearchNet> ((*n)->GetApplication (i));
+        if (!app)
+          continue;
+
+        Vehicle vehicle;
+        vehicle.node = *n;
+        vehicle.app = app;
+        vehicle.rxBytes = 0;
+        m_vehicles.push_back (vehicle);
+
+        for (uint32_t d = 0; d < (*n)->GetNDevices (); d++)
+          {
+            Ptr<WifiNetDevice> dev = DynamicCast<WifiNetDevice> ((*n)->GetDevice (d));
+            if (dev)
+              {
+                m_vehicles.back ().address = Mac48Address::ConvertFrom (dev->GetAddress ());
+                dev->GetPhy ()->TraceConnectWithoutContext (
+                    "MonitorSnifferRx",
+                    MakeBoundCallback (&ResultsSampler::PhyRx, this,
+                                      (uint32_t) (m_vehicles.size () - 1)));
+                break;
+              }
+          }
+        break;
+      }
+
+  m_writer = CreateObject<ResultsWriter> ();
+  m_writer->SetAttribute ("FileName", StringValue (m_fileName));
+  m_colTime = m_writer->AddColumn ("time_s", ResultsWriter::FIXED, 0.001);
+  m_colNode = m_writer->AddColumn ("node", ResultsWriter::INT64);
+  m_colX = m_writer->AddColumn ("x_m", ResultsWriter::FIXED, 0.01);
+  m_colY = m_writer->AddColumn ("y_m", ResultsWriter::FIXED, 0.01);
+  m_colRsu = m_writer->AddColumn ("rsu", ResultsWriter::INT64);
+  m_colSignal = m_writer->AddColumn ("signal_dbm", ResultsWriter::DOUBLE);
+  m_colAddr = m_writer->AddColumn ("ipv4", ResultsWriter::INT64);
+  m_colRxRate = m_writer->AddColumn ("rx_bps", ResultsWriter::INT64);
+  m_writer->Open ();
+
+  m_sampleEvent = Simulator::Schedule (m_interval, &ResultsSampler::Sample, this);
+}
+
+void
+ResultsSampler::PhyRx (ResultsSampler *sampler, uint32_t index, Ptr<const Packet> packet,
+                       uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu, SignalNoiseDbm sn)
+{
+  //The sniffer sees every frame on the air; keep the data sent to this vehicle
+  Vehicle &vehicle = sampler->m_vehicles[index];
+  WifiMacHeader hdr;
+  if (packet->PeekHeader (hdr) && hdr.IsData () && hdr.GetAddr1 () == vehicle.address)
+    vehicle.rxBytes += packet->GetSize ();
+}
+
+void
+ResultsSampler::Sample ()
+{
+  double now = Simulator::Now ().GetSeconds ();
+  for (auto &v : m_vehicles)
+    {
+      Vector pos = v.node->GetObject<MobilityModel> ()->GetPosition ();
+      Ptr<Ipv4> ipv4 = v.node->GetObject<Ipv4> ();
+
+      m_writer->SetDouble (m_colTime, now);
+      m_writer->SetInt (m_colNode, v.node->GetId ());
+      m_writer->SetDouble (m_colX, pos.x);
+      m_writer->SetDouble (m_colY, pos.y);
+      m_writer->SetInt (m_colRsu, v.app->GetRsuConnected ());
+      m_writer->SetDouble (m_colSignal, v.app->GetServingSignal ());
+      m_writer->SetInt (m_colAddr, ipv4->GetAddress (1, 0).GetLocal ().Get ());
+      m_writer->SetInt (m_colRxRate, v.rxBytes * 8 / m_interval.GetSeconds ());
+      m_writer->EndRow ();
+      v.rxBytes = 0;
+    }
+  m_sampleEvent = Simulator::Schedule (m_interval, &ResultsSampler::Sample, this);
+}
+
+} // namespace ns3
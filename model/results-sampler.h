@@ -0,0 +1,67 @@
+#ifndef RESULTS_SAMPLER_H
+#define RESULTS_SAMPLER_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/node.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/mac48-address.h"
+#include "beacon-search-net.h"
+#include "results-writer.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Periodically samples every vehicle running a BeaconSearchNet into a
+ * ResultsWriter: time, node, position, serving RSU, signal of the serving
+ * RSU, ipv4 address and the throughput of data frames addressed to the
+ * vehicle over the last interval; overheard traffic and beacons are not counted.
+ */
+class ResultsSampler : public ns3::Object
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  ResultsSampler ();
+  ~ResultsSampler ();
+
+  /** Sample every BeaconSearchNet installed so far, starting now */
+  void InstallAll ();
+
+  Ptr<ResultsWriter> GetWriter () const;
+
+private:
+  struct Vehicle
+  {
+    Ptr<Node> node;
+    Ptr<BeaconSearchNet> app;
+    Mac48Address address; /**< Wifi address frames must be sent to for counting */
+    uint64_t rxBytes; /**< Data bytes addressed to the vehicle since the last sample */
+  };
+
+  virtual void DoDispose (void);
+
+  void Sample ();
+
+  static void PhyRx (ResultsSampler *sampler, uint32_t index, Ptr<const Packet> packet,
+                     uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu, SignalNoiseDbm sn);
+
+  Time m_interval; /**< Sampling interval */
+  std::string m_fileName; /**< Output file */
+
+  Ptr<ResultsWriter> m_writer; /**< Columnar output */
+  std::vector<Vehicle> m_vehicles; /**< Sampled vehicles */
+  EventId m_sampleEvent; /**< Next sample */
+
+  uint32_t m_colTime;
+  uint32_t m_colNode;
+  uint32_t m_colX;
+  uint32_t m_colY;
+  uint32_t m_colRsu;
+  uint32_t m_colSignal;
+  uint32_t m_colAddr;
+  uint32_t m_colRxRate;
+};
+} // namespace ns3
+#endif
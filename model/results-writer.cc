@@ -0,0 +1,403 @@
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "results-writer.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("results-writer");
+NS_OBJECT_ENSURE_REGISTERED (ResultsWriter);
+
+namespace {
+
+const char RESULTS_MAGIC[8] = {'V', 'N', 'E', 'T', 'C', 'O', 'L', '1'};
+
+void
+PutVarint (std::string &out, uint64_t v)
+{
+  while (v >= 0x80)
+    {
+      out.push_back ((char) ((v & 0x7f) | 0x80));
+      v >>= 7;
+    }
+  out.push_back ((char) v);
+}
+
+uint64_t
+GetVarint (const uint8_t *&p, const uint8_t *end)
+{
+  uint64_t v = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7)
+    {
+      uint8_t b = *p++;
+      v |= (uint64_t) (b & 0x7f) << shift;
+      if (!(b & 0x80))
+        break;
+    }
+  return v;
+}
+
+uint64_t
+ZigZag (int64_t v)
+{
+  return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+int64_t
+UnZigZag (uint64_t v)
+{
+  return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+uint64_t
+DoubleBits (double d)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &d, sizeof (bits));
+  return bits;
+}
+
+double
+BitsDouble (uint64_t bits)
+{
+  double d;
+  std::memcpy (&d, &bits, sizeof (d));
+  return d;
+}
+
+template <typename T>
+void
+PutRaw (std::string &out, T v)
+{
+  out.append ((const char *) &v, sizeof (v));
+}
+
+template <typename T>
+bool
+GetRaw (std::FILE *f, T &v)
+{
+  return std::fread (&v, sizeof (v), 1, f) == 1;
+}
+
+} // namespace
+
+TypeId
+ResultsWriter::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::ResultsWriter")
+          .SetParent<Object> ()
+          .AddConstructor<ResultsWriter> ()
+          .AddAttribute ("FileName", "Columnar results file",
+                         StringValue ("contrib/vanetsim/results/results.vcol"),
+                         MakeStringAccessor (&ResultsWriter::m_fileName), MakeStringChecker ())
+          .AddAttribute ("BlockRows", "Rows buffered per column before a chunk is written",
+                         UintegerValue (8192), MakeUintegerAccessor (&ResultsWriter::m_blockRows),
+                         MakeUintegerChecker<uint32_t> (1));
+  return tid;
+}
+
+TypeId
+ResultsWriter::GetInstanceTypeId () const
+{
+  return ResultsWriter::GetTypeId ();
+}
+
+ResultsWriter::ResultsWriter () : m_file (0), m_offset (0), m_rows (0)
+{
+}
+
+ResultsWriter::~ResultsWriter ()
+{
+}
+
+void
+ResultsWriter::DoDispose ()
+{
+  Close ();
+  Object::DoDispose ();
+}
+
+uint32_t
+ResultsWriter::AddColumn (std::string name, ColumnType type, double scale)
+{
+  NS_ABORT_MSG_IF (m_file, "Columns must be added before ResultsWriter::Open");
+  NS_ABORT_MSG_IF (type == FIXED && scale <= 0, "FIXED column " << name << " needs a scale > 0");
+
+  Column column;
+  column.name = name;
+  column.type = type;
+  column.scale = (type == FIXED) ? scale : 1.0;
+  column.current = (type == DOUBLE) ? DoubleBits (0) : 0;
+  m_columns.push_back (column);
+  return m_columns.size () - 1;
+}
+
+void
+ResultsWriter::Open ()
+{
+  NS_LOG_FUNCTION (this << m_fileName);
+
+  m_file = std::fopen (m_fileName.c_str (), "wb");
+  if (!m_file)
+    NS_FATAL_ERROR ("Can't open results file " << m_fileName);
+
+  std::fwrite (RESULTS_MAGIC, sizeof (RESULTS_MAGIC), 1, m_file);
+  m_offset = sizeof (RESULTS_MAGIC);
+
+  for (auto &c : m_columns)
+    c.values.reserve (m_blockRows);
+
+  Simulator::ScheduleDestroy (&ResultsWriter::Close, this);
+}
+
+void
+ResultsWriter::SetInt (uint32_t column, int64_t value)
+{
+  Column &c = m_columns.at (column);
+  if (c.type == DOUBLE)
+    c.current = DoubleBits ((double) value);
+  else if (c.type == FIXED)
+    c.current = (uint64_t) std::llround (value / c.scale);
+  else
+    c.current = (uint64_t) value;
+}
+
+void
+ResultsWriter::SetDouble (uint32_t column, double value)
+{
+  Column &c = m_columns.at (column);
+  if (c.type == DOUBLE)
+    c.current = DoubleBits (value);
+  else if (c.type == FIXED)
+    c.current = (uint64_t) std::llround (value / c.scale);
+  else
+    c.current = (uint64_t) std::llround (value);
+}
+
+void
+ResultsWriter::EndRow ()
+{
+  NS_ASSERT (m_file);
+  for (auto &c : m_columns)
+    c.values.push_back (c.current);
+  m_rows++;
+  if (m_columns.size () && m_columns[0].values.size () >= m_blockRows)
+    FlushBlock ();
+}
+
+uint64_t
+ResultsWriter::GetRows () const
+{
+  return m_rows;
+}
+
+void
+ResultsWriter::Encode (const Column &column, std::string &out, Chunk &chunk) const
+{
+  chunk.rows = column.values.size ();
+  chunk.min = std::numeric_limits<double>::max ();
+  chunk.max = -std::numeric_limits<double>::max ();
+  chunk.sum = 0;
+
+  uint64_t previous = (column.type == DOUBLE) ? DoubleBits (0) : 0;
+  for (uint64_t raw : column.values)
+    {
+      double v;
+      if (column.type == DOUBLE)
+        {
+          PutVarint (out, raw ^ previous);
+          v = BitsDouble (raw);
+        }
+      else
+        {
+          PutVarint (out, ZigZag ((int64_t) (raw - previous)));
+          v = (int64_t) raw * column.scale;
+        }
+      previous = raw;
+
+      if (std::isnan (v))
+        continue;
+      chunk.min = std::min (chunk.min, v);
+      chunk.max = std::max (chunk.max, v);
+      chunk.sum += v;
+    }
+}
+
+void
+ResultsWriter::FlushBlock ()
+{
+  if (!m_file || m_columns.empty () || m_columns[0].values.empty ())
+    return;
+
+  std::string out;
+  for (auto &c : m_columns)
+    {
+      Chunk chunk;
+      out.clear ();
+      Encode (c, out, chunk);
+      chunk.offset = m_offset;
+      chunk.bytes = out.size ();
+      std::fwrite (out.data (), 1, out.size (), m_file);
+      m_offset += out.size ();
+      c.chunks.push_back (chunk);
+      c.values.clear ();
+    }
+}
+
+void
+ResultsWriter::Close ()
+{
+  if (!m_file)
+    return;
+
+  FlushBlock ();
+
+  std::string footer;
+  PutRaw<uint32_t> (footer, m_columns.size ());
+  for (auto const &c : m_columns)
+    {
+      PutRaw<uint16_t> (footer, c.name.size ());
+      footer.append (c.name);
+      PutRaw<uint8_t> (footer, c.type);
+      PutRaw<double> (footer, c.scale);
+      PutRaw<uint32_t> (footer, c.chunks.size ());
+      for (auto const &chunk : c.chunks)
+        {
+          PutRaw<uint64_t> (footer, chunk.offset);
+          PutRaw<uint32_t> (footer, chunk.bytes);
+          PutRaw<uint32_t> (footer, chunk.rows);
+          PutRaw<double> (footer, chunk.min);
+          PutRaw<double> (footer, chunk.max);
+          PutRaw<double> (footer, chunk.sum);
+        }
+    }
+  PutRaw<uint64_t> (footer, m_offset);
+  footer.append (RESULTS_MAGIC, sizeof (RESULTS_MAGIC));
+
+  std::fwrite (footer.data (), 1, footer.size (), m_file);
+  std::fclose (m_file);
+  m_file = 0;
+  NS_LOG_INFO ("results " << m_fileName << ": " << m_rows << " rows, " << m_offset
+                          << " bytes of column data");
+}
+
+ResultsReader::ResultsReader () : m_file (0)
+{
+}
+
+ResultsReader::~ResultsReader ()
+{
+  if (m_file)
+    std::fclose (m_file);
+}
+
+bool
+ResultsReader::Open (std::string fileName)
+{
+  m_file = std::fopen (fileName.c_str (), "rb");
+  if (!m_file)
+    return false;
+
+  char magic[sizeof (RESULTS_MAGIC)];
+  uint64_t footerOffset;
+  if (std::fseek (m_file, -(long) (sizeof (magic) + sizeof (footerOffset)), SEEK_END) != 0 ||
+      !GetRaw (m_file, footerOffset) || std::fread (magic, sizeof (magic), 1, m_file) != 1 ||
+      std::memcmp (magic, RESULTS_MAGIC, sizeof (magic)) != 0 ||
+      std::fseek (m_file, (long) footerOffset, SEEK_SET) != 0)
+    return false;
+
+  uint32_t nColumns;
+  if (!GetRaw (m_file, nColumns))
+    return false;
+  for (uint32_t i = 0; i < nColumns; i++)
+    {
+      ColumnInfo info;
+      uint16_t nameLength;
+      uint32_t nChunks;
+      if (!GetRaw (m_file, nameLength))
+        return false;
+      info.name.resize (nameLength);
+      if ((nameLength && std::fread (&info.name[0], 1, nameLength, m_file) != nameLength) ||
+          !GetRaw (m_file, info.type) || !GetRaw (m_file, info.scale) || !GetRaw (m_file, nChunks))
+        return false;
+
+      info.rows = 0;
+      info.min = std::numeric_limits<double>::max ();
+      info.max = -std::numeric_limits<double>::max ();
+      info.sum = 0;
+      std::vector<ChunkRef> chunks;
+      for (uint32_t j = 0; j < nChunks; j++)
+        {
+          ChunkRef ref;
+          double min, max, sum;
+          if (!GetRaw (m_file, ref.offset) || !GetRaw (m_file, ref.bytes) ||
+              !GetRaw (m_file, ref.rows) || !GetRaw (m_file, min) || !GetRaw (m_file, max) ||
+              !GetRaw (m_file, sum))
+            return false;
+          chunks.push_back (ref);
+          info.rows += ref.rows;
+          info.min = std::min (info.min, min);
+          info.max = std::max (info.max, max);
+          info.sum += sum;
+        }
+      m_columns.push_back (info);
+      m_chunks.push_back (chunks);
+    }
+  return true;
+}
+
+const std::vector<ResultsReader::ColumnInfo> &
+ResultsReader::GetColumns () const
+{
+  return m_columns;
+}
+
+std::vector<double>
+ResultsReader::ReadColumn (std::string name)
+{
+  std::vector<double> values;
+  for (size_t i = 0; i < m_columns.size (); i++)
+    {
+      if (m_columns[i].name != name)
+        continue;
+
+      const ColumnInfo &info = m_columns[i];
+      values.reserve (info.rows);
+      std::vector<uint8_t> data;
+      for (auto const &ref : m_chunks[i])
+        {
+          data.resize (ref.bytes);
+          if (std::fseek (m_file, (long) ref.offset, SEEK_SET) != 0 ||
+              (ref.bytes && std::fread (data.data (), 1, ref.bytes, m_file) != ref.bytes))
+            break;
+
+          const uint8_t *p = data.data ();
+          const uint8_t *end = p + data.size ();
+          uint64_t previous = (info.type == ResultsWriter::DOUBLE) ? DoubleBits (0) : 0;
+          for (uint32_t r = 0; r < ref.rows; r++)
+            {
+              uint64_t raw;
+              if (info.type == ResultsWriter::DOUBLE)
+                {
+                  raw = GetVarint (p, end) ^ previous;
+                  values.push_back (BitsDouble (raw));
+                }
+              else
+                {
+                  raw = previous + (uint64_t) UnZigZag (GetVarint (p, end));
+                  values.push_back ((int64_t) raw * info.scale);
+                }
+              previous = raw;
+            }
+        }
+      break;
+    }
+  return values;
+}
+
+} // namespace ns3
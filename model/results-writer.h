@@ -0,0 +1,135 @@
+#ifndef RESULTS_WRITER_H
+#define RESULTS_WRITER_H
+#include "ns3/object.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Streaming columnar results file.
+ *
+ * Rows are buffered column by column; every BlockRows rows each column is
+ * encoded and appended to the file as one chunk, so memory stays bounded by
+ * BlockRows x columns x 8 bytes. Chunks are compressed with a lightweight
+ * codec (no external library):
+ *  - INT64: delta to the previous value, zigzag, LEB128 varint
+ *  - FIXED: value / scale rounded to an integer, then as INT64 (lossy)
+ *  - DOUBLE: IEEE bits XOR the previous value, LEB128 varint (lossless)
+ *
+ * File layout (little endian):
+ *   "VNETCOL1"
+ *   chunk data ...
+ *   footer:
+ *     uint32 nColumns
+ *     per column: uint16 nameLength, name, uint8 type, double scale, uint32 nChunks,
+ *                 per chunk: uint64 offset, uint32 bytes, uint32 rows, double min, max, sum
+ *   uint64 footer offset
+ *   "VNETCOL1"
+ *
+ * A reader seeks to the end, reads the footer and then only the chunks of
+ * the columns it needs (see ResultsReader).
+ */
+class ResultsWriter : public ns3::Object
+{
+public:
+  enum ColumnType : uint8_t { INT64 = 1, DOUBLE = 2, FIXED = 3 };
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  ResultsWriter ();
+  ~ResultsWriter ();
+
+  /** Declare a column before Open; returns its index */
+  uint32_t AddColumn (std::string name, ColumnType type, double scale = 1.0);
+
+  void Open ();
+  void Close ();
+
+  /** Set a value of the current row; unset columns repeat their previous value */
+  void SetInt (uint32_t column, int64_t value);
+  void SetDouble (uint32_t column, double value);
+  /** Commit the current row */
+  void EndRow ();
+
+  uint64_t GetRows () const;
+
+private:
+  struct Chunk
+  {
+    uint64_t offset;
+    uint32_t bytes;
+    uint32_t rows;
+    double min;
+    double max;
+    double sum;
+  };
+
+  struct Column
+  {
+    std::string name;
+    ColumnType type;
+    double scale;
+    uint64_t current; /**< raw bits of the current row value */
+    std::vector<uint64_t> values; /**< rows of the block being filled */
+    std::vector<Chunk> chunks; /**< chunks already written */
+  };
+
+  virtual void DoDispose (void);
+
+  void FlushBlock ();
+  void Encode (const Column &column, std::string &out, Chunk &chunk) const;
+
+  std::string m_fileName; /**< Output file */
+  uint32_t m_blockRows; /**< Rows per chunk */
+
+  std::FILE *m_file; /**< Output stream */
+  uint64_t m_offset; /**< Current file offset */
+  uint64_t m_rows; /**< Rows written */
+  std::vector<Column> m_columns; /**< Column buffers and chunk index */
+};
+
+/**
+ * Reads single columns of a file written by ResultsWriter.
+ */
+class ResultsReader
+{
+public:
+  struct ColumnInfo
+  {
+    std::string name;
+    uint8_t type;
+    double scale;
+    uint64_t rows;
+    double min;
+    double max;
+    double sum;
+  };
+
+  ResultsReader ();
+  ~ResultsReader ();
+
+  /** Read the footer; returns false if the file is not a results file */
+  bool Open (std::string fileName);
+
+  const std::vector<ColumnInfo> &GetColumns () const;
+  /** Decode every chunk of one column */
+  std::vector<double> ReadColumn (std::string name);
+
+private:
+  struct ChunkRef
+  {
+    uint64_t offset;
+    uint32_t bytes;
+    uint32_t rows;
+  };
+
+  std::FILE *m_file;
+  std::vector<ColumnInfo> m_columns;
+  std::vector<std::vector<ChunkRef>> m_chunks;
+};
+
+} // namespace ns3
+#endif
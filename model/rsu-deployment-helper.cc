@@ -0,0 +1,558 @@
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/application.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/mobility-model.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/wifi-helper.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-phy.h"
+#include "rsu-deployment-helper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("rsu-deployment-helper");
+NS_OBJECT_ENSURE_REGISTERED (RsuDeploymentHelper);
+
+TypeId
+RsuDeploymentHelper::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::RsuDeploymentHelper")
+          .SetParent<Object> ()
+          .AddConstructor<RsuDeploymentHelper> ()
+          .AddAttribute ("NetFile", "SUMO network whose junctions are the RSU sites",
+                         StringValue ("contrib/vanetsim/traces/grid-map/map.net.xml"),
+                         MakeStringAccessor (&RsuDeploymentHelper::m_netFile),
+                         MakeStringChecker ())
+          .AddAttribute ("Policy", "How the sites are chosen",
+                         EnumValue (RsuDeploymentHelper::EVERY_KTH),
+                         MakeEnumAccessor (&RsuDeploymentHelper::m_policy),
+                         MakeEnumChecker (RsuDeploymentHelper::EVERY_KTH, "junction",
+                                          RsuDeploymentHelper::GRID, "grid",
+                                          RsuDeploymentHelper::COVERAGE, "coverage"))
+          .AddAttribute ("Every", "junction: one RSU every this many junctions", UintegerValue (1),
+                         MakeUintegerAccessor (&RsuDeploymentHelper::m_every),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("Spacing", "grid: distance between grid points (m)", DoubleValue (100),
+                         MakeDoubleAccessor (&RsuDeploymentHelper::m_spacing),
+                         MakeDoubleChecker<double> (1))
+          .AddAttribute ("Range", "coverage: radius covered by one RSU (m)", DoubleValue (100),
+                         MakeDoubleAccessor (&RsuDeploymentHelper::m_range),
+                         MakeDoubleChecker<double> (1))
+          .AddAttribute ("Coverage", "coverage: share of the junctions within Range of an RSU",
+                         DoubleValue (0.95), MakeDoubleAccessor (&RsuDeploymentHelper::m_coverage),
+                         MakeDoubleChecker<double> (0, 1))
+          .AddAttribute ("MaxRsus", "Upper bound on the RSUs (0: none)", UintegerValue (0),
+                         MakeUintegerAccessor (&RsuDeploymentHelper::m_maxRsus),
+                         MakeUintegerChecker<uint32_t> ())
+          .AddAttribute ("Height", "RSU antenna height (m)", DoubleValue (3.0),
+                         MakeDoubleAccessor (&RsuDeploymentHelper::m_height),
+                         MakeDoubleChecker<double> ())
+          .AddAttribute ("FanOut", "RSUs behind one backhaul router", UintegerValue (8),
+                         MakeUintegerAccessor (&RsuDeploymentHelper::m_fanOut),
+                         MakeUintegerChecker<uint32_t> (1, 1024))
+          .AddAttribute ("RsuNetwork", "First RSU subnet", Ipv4AddressValue ("10.0.0.0"),
+                         MakeIpv4AddressAccessor (&RsuDeploymentHelper::m_rsuNetwork),
+                         MakeIpv4AddressChecker ())
+          .AddAttribute ("RsuPrefix", "Prefix length of an RSU subnet (its DHCP pool)",
+                         UintegerValue (24), MakeUintegerAccessor (&RsuDeploymentHelper::m_rsuPrefix),
+                         MakeUintegerChecker<uint32_t> (8, 30))
+          .AddAttribute ("BackhaulNetwork", "First /30 of the backhaul links",
+                         Ipv4AddressValue ("192.168.0.0"),
+                         MakeIpv4AddressAccessor (&RsuDeploymentHelper::m_backhaulNetwork),
+                         MakeIpv4AddressChecker ())
+          .AddAttribute ("AccessDataRate", "RSU to router links", StringValue ("1Gbps"),
+                         MakeStringAccessor (&RsuDeploymentHelper::m_accessDataRate),
+                         MakeStringChecker ())
+          .AddAttribute ("AccessDelay", "RSU to router links", TimeValue (MilliSeconds (2)),
+                         MakeTimeAccessor (&RsuDeploymentHelper::m_accessDelay), MakeTimeChecker ())
+          .AddAttribute ("CoreDataRate", "Router to gateway links", StringValue ("10Gbps"),
+                         MakeStringAccessor (&RsuDeploymentHelper::m_coreDataRate),
+                         MakeStringChecker ())
+          .AddAttribute ("CoreDelay", "Router to gateway links", TimeValue (MilliSeconds (1)),
+                         MakeTimeAccessor (&RsuDeploymentHelper::m_coreDelay), MakeTimeChecker ())
+          .AddAttribute ("MultiChannel",
+                         "Control radio on the CCH, data radios on SCHs spread over the RSUs",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&RsuDeploymentHelper::m_multiChannel),
+                         MakeBooleanChecker ());
+  return tid;
+}
+
+TypeId
+RsuDeploymentHelper::GetInstanceTypeId () const
+{
+  return RsuDeploymentHelper::GetTypeId ();
+}
+
+RsuDeploymentHelper::RsuDeploymentHelper () : m_multiChannel (false), m_block (1)
+{
+  m_appFactory.SetTypeId ("ns3::BeaconRsuNet");
+}
+
+RsuDeploymentHelper::~RsuDeploymentHelper ()
+{
+}
+
+void
+RsuDeploymentHelper::SetDeployment (std::string spec)
+{
+  size_t colon = spec.find (':');
+  std::string policy = spec.substr (0, colon);
+  std::string value = colon == std::string::npos ? "" : spec.substr (colon + 1);
+
+  if (policy == "junction")
+    {
+      SetAttribute ("Policy", EnumValue (EVERY_KTH));
+      if (!value.empty ())
+        SetAttribute ("Every", UintegerValue (std::atoi (value.c_str ())));
+    }
+  else if (policy == "grid")
+    {
+      SetAttribute ("Policy", EnumValue (GRID));
+      if (!value.empty ())
+        SetAttribute ("Spacing", DoubleValue (std::atof (value.c_str ())));
+    }
+  else if (policy == "coverage")
+    {
+      SetAttribute ("Policy", EnumValue (COVERAGE));
+      if (!value.empty ())
+        SetAttribute ("Coverage", DoubleValue (std::atof (value.c_str ())));
+    }
+  else
+    NS_FATAL_ERROR ("Unknown RSU deployment " << spec);
+}
+
+void
+RsuDeploymentHelper::SetApplicationAttribute (std::string name, const AttributeValue &value)
+{
+  m_appFactory.Set (name, value);
+}
+
+static bool
+GetXmlAttribute (const std::string &line, const char *name, std::string &value)
+{
+  std::string key = std::string (" ") + name + "=\"";
+  size_t start = line.find (key);
+  if (start == std::string::npos)
+    return false;
+  start += key.size ();
+  size_t end = line.find ('"', start);
+  if (end == std::string::npos)
+    return false;
+  value = line.substr (start, end - start);
+  return true;
+}
+
+std::vector<RsuDeploymentHelper::Junction>
+RsuDeploymentHelper::ReadJunctions (std::string netFile)
+{
+  // <junction id="A1" type="priority" x="0.00" y="50.00" incLanes=...
+  std::ifstream file (netFile.c_str ());
+  NS_ABORT_MSG_IF (!file, "Can't open " << netFile);
+
+  std::vector<Junction> junctions;
+  std::string line, type, x, y;
+  while (std::getline (file, line))
+    {
+      size_t tag = line.find ("<junction ");
+      if (tag == std::string::npos)
+        continue;
+      line.erase (0, tag + 9);
+      if (GetXmlAttribute (line, "type", type) && type == "internal")
+        continue;
+
+      Junction j;
+      if (!GetXmlAttribute (line, "id", j.id) || !GetXmlAttribute (line, "x", x) ||
+          !GetXmlAttribute (line, "y", y))
+        continue;
+      j.x = std::atof (x.c_str ());
+      j.y = std::atof (y.c_str ());
+      junctions.push_back (j);
+    }
+  return junctions;
+}
+
+std::vector<RsuDeploymentHelper::Junction>
+RsuDeploymentHelper::Place () const
+{
+  std::vector<Junction> junctions = ReadJunctions (m_netFile);
+  NS_ABORT_MSG_IF (junctions.empty (), "No junction in " << m_netFile);
+
+  std::vector<uint32_t> chosen;
+  switch (m_policy)
+    {
+    case EVERY_KTH:
+      chosen = PlaceEveryKth (junctions);
+      break;
+    case GRID:
+      chosen = PlaceGrid (junctions);
+      break;
+    case COVERAGE:
+      chosen = PlaceCoverage (junctions);
+      break;
+    }
+  if (m_maxRsus && chosen.size () > m_maxRsus)
+    chosen.resize (m_maxRsus);
+
+  std::vector<Junction> sites;
+  for (uint32_t i : chosen)
+    sites.push_back (junctions[i]);
+  NS_LOG_INFO (sites.size () << " RSU sites out of " << junctions.size () << " junctions");
+  return sites;
+}
+
+std::vector<uint32_t>
+RsuDeploymentHelper::PlaceEveryKth (const std::vector<Junction> &junctions) const
+{
+  std::vector<uint32_t> chosen;
+  for (uint32_t i = 0; i < junctions.size (); i += m_every)
+    chosen.push_back (i);
+  return chosen;
+}
+
+std::vector<uint32_t>
+RsuDeploymentHelper::PlaceGrid (const std::vector<Junction> &junctions) const
+{
+  double minX = junctions[0].x, maxX = minX, minY = junctions[0].y, maxY = minY;
+  for (const auto &j : junctions)
+    {
+      minX = std::min (minX, j.x);
+      maxX = std::max (maxX, j.x);
+      minY = std::min (minY, j.y);
+      maxY = std::max (maxY, j.y);
+    }
+
+  // nearest junction to each grid point, if within one spacing
+  std::vector<uint32_t> chosen;
+  std::vector<bool> taken (junctions.size (), false);
+  for (double y = minY; y <= maxY + 1e-6; y += m_spacing)
+    for (double x = minX; x <= maxX + 1e-6; x += m_spacing)
+      {
+        uint32_t best = 0;
+        double bestDist = m_spacing * m_spacing;
+        bool found = false;
+        for (uint32_t i = 0; i < junctions.size (); i++)
+          {
+            double dx = junctions[i].x - x, dy = junctions[i].y - y;
+            if (dx * dx + dy * dy <= bestDist)
+              {
+                bestDist = dx * dx + dy * dy;
+                best = i;
+                found = true;
+              }
+          }
+        if (found && !taken[best])
+          {
+            taken[best] = true;
+            chosen.push_back (best);
+          }
+      }
+  return chosen;
+}
+
+std::vector<uint32_t>
+RsuDeploymentHelper::PlaceCoverage (const std::vector<Junction> &junctions) const
+{
+  uint32_t n = junctions.size ();
+  double range2 = m_range * m_range;
+
+  // neighbours within Range, found through cells of Range side
+  std::map<std::pair<int64_t, int64_t>, std::vector<uint32_t>> cells;
+  for (uint32_t i = 0; i < n; i++)
+    cells[std::make_pair ((int64_t) std::floor (junctions[i].x / m_range),
+                          (int64_t) std::floor (junctions[i].y / m_range))]
+        .push_back (i);
+
+  std::vector<std::vector<uint32_t>> neighbours (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      int64_t cx = std::floor (junctions[i].x / m_range);
+      int64_t cy = std::floor (junctions[i].y / m_range);
+      for (int64_t dx = -1; dx <= 1; dx++)
+        for (int64_t dy = -1; dy <= 1; dy++)
+          {
+            auto cell = cells.find (std::make_pair (cx + dx, cy + dy));
+            if (cell == cells.end ())
+              continue;
+            for (uint32_t j : cell->second)
+              {
+                double ddx = junctions[i].x - junctions[j].x;
+                double ddy = junctions[i].y - junctions[j].y;
+                if (ddx * ddx + ddy * ddy <= range2)
+                  neighbours[i].push_back (j);
+              }
+          }
+    }
+
+  // greedy set cover: the site covering the most uncovered junctions first
+  std::vector<uint32_t> gain (n);
+  for (uint32_t i = 0; i < n; i++)
+    gain[i] = neighbours[i].size ();
+  std::vector<bool> covered (n, false);
+  uint32_t target = std::ceil (m_coverage * n);
+  uint32_t nCovered = 0;
+
+  std::vector<uint32_t> chosen;
+  while (nCovered < target && (!m_maxRsus || chosen.size () < m_maxRsus))
+    {
+      uint32_t best = std::max_element (gain.begin (), gain.end ()) - gain.begin ();
+      if (!gain[best])
+        break;
+      chosen.push_back (best);
+      for (uint32_t j : neighbours[best])
+        if (!covered[j])
+          {
+            covered[j] = true;
+            nCovered++;
+            for (uint32_t k : neighbours[j])
+              gain[k]--;
+          }
+    }
+  NS_LOG_INFO (nCovered << " of " << n << " junctions within " << m_range << " m of an RSU");
+  return chosen;
+}
+
+void
+RsuDeploymentHelper::SortByZOrder (std::vector<Junction> &sites)
+{
+  double minX = sites[0].x, maxX = minX, minY = sites[0].y, maxY = minY;
+  for (const auto &s : sites)
+    {
+      minX = std::min (minX, s.x);
+      maxX = std::max (maxX, s.x);
+      minY = std::min (minY, s.y);
+      maxY = std::max (maxY, s.y);
+    }
+
+  auto code = [&] (const Junction &s) {
+    uint32_t x = (s.x - minX) / std::max (maxX - minX, 1.0) * 65535;
+    uint32_t y = (s.y - minY) / std::max (maxY - minY, 1.0) * 65535;
+    uint32_t morton = 0;
+    for (uint32_t b = 0; b < 16; b++)
+      morton |= ((x >> b) & 1) << (2 * b) | ((y >> b) & 1) << (2 * b + 1);
+    return morton;
+  };
+  std::stable_sort (sites.begin (), sites.end (), [&] (const Junction &a, const Junction &b) {
+    return code (a) < code (b);
+  });
+}
+
+Ipv4Address
+RsuDeploymentHelper::GetRsuNetwork (uint32_t i) const
+{
+  uint32_t index = (i / m_fanOut) * m_block + i % m_fanOut;
+  return Ipv4Address (m_rsuNetwork.Get () + (index << (32 - m_rsuPrefix)));
+}
+
+Ipv4Mask
+RsuDeploymentHelper::GetRsuMask () const
+{
+  return Ipv4Mask (~0u << (32 - m_rsuPrefix));
+}
+
+ApplicationContainer
+RsuDeploymentHelper::Install (const WifiHelper &wifi, const WifiPhyHelper &phy,
+                              const WifiMacHelper &mac)
+{
+  m_sites = Place ();
+  NS_ABORT_MSG_IF (m_sites.empty (), "No RSU site selected");
+  SortByZOrder (m_sites);
+
+  uint32_t n = m_sites.size ();
+  uint32_t clusters = (n + m_fanOut - 1) / m_fanOut;
+  m_block = 1;
+  while (m_block < m_fanOut)
+    m_block <<= 1;
+
+  // subnet plan: RSU blocks, then the /30 of every link, must fit and not overlap
+  uint64_t rsuStart = m_rsuNetwork.Get ();
+  uint64_t rsuSpan = ((uint64_t) clusters * m_block) << (32 - m_rsuPrefix);
+  uint64_t blockSize = (uint64_t) m_block << (32 - m_rsuPrefix);
+  uint64_t linkStart = m_backhaulNetwork.Get ();
+  uint64_t linkSpan = 4ull * (n + clusters);
+  NS_ABORT_MSG_IF (blockSize >> 24, "FanOut subnets of /" << m_rsuPrefix << " exceed a /8");
+  NS_ABORT_MSG_IF (rsuStart % blockSize, "RsuNetwork must be aligned to FanOut subnets");
+  NS_ABORT_MSG_IF (rsuStart + rsuSpan > (1ull << 32), "RsuNetwork too small for " << n << " RSUs");
+  NS_ABORT_MSG_IF (linkStart % 4 || linkStart + linkSpan > (1ull << 32),
+                   "BackhaulNetwork too small for " << n + clusters << " links");
+  NS_ABORT_MSG_IF (rsuStart < linkStart + linkSpan && linkStart < rsuStart + rsuSpan,
+                   "RSU and backhaul subnets overlap");
+
+  m_rsus.Create (n);
+  m_routers.Create (clusters);
+  m_gateway = CreateObject<Node> ();
+
+  // RSUs on their junctions, routers and gateway at the centre of what they serve
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  double sumX = 0, sumY = 0;
+  for (const auto &s : m_sites)
+    positions->Add (Vector (s.x, s.y, m_height));
+  for (uint32_t c = 0; c < clusters; c++)
+    {
+      double x = 0, y = 0;
+      uint32_t end = std::min (n, (c + 1) * m_fanOut);
+      for (uint32_t i = c * m_fanOut; i < end; i++)
+        {
+          x += m_sites[i].x;
+          y += m_sites[i].y;
+        }
+      sumX += x;
+      sumY += y;
+      positions->Add (Vector (x / (end - c * m_fanOut), y / (end - c * m_fanOut), 0));
+    }
+  positions->Add (Vector (sumX / n, sumY / n, 0));
+
+  NodeContainer all (m_rsus, m_routers, NodeContainer (m_gateway));
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator (positions);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (all);
+
+  InternetStackHelper stack;
+  stack.Install (all);
+
+  // the Wi-Fi address first: BeaconRsuNet uses interface 1
+  NetDeviceContainer wifiDevices = wifi.Install (phy, mac, m_rsus);
+  Ipv4AddressHelper address;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      address.SetBase (GetRsuNetwork (i), GetRsuMask ());
+      address.Assign (NetDeviceContainer (wifiDevices.Get (i)));
+    }
+  if (m_multiChannel)
+    {
+      InstallControlRadio (wifi, phy, mac, m_rsus);
+      SpreadServiceChannels (m_rsus);
+    }
+
+  PointToPointHelper access;
+  access.SetDeviceAttribute ("DataRate", StringValue (m_accessDataRate));
+  access.SetChannelAttribute ("Delay", TimeValue (m_accessDelay));
+  PointToPointHelper core;
+  core.SetDeviceAttribute ("DataRate", StringValue (m_coreDataRate));
+  core.SetChannelAttribute ("Delay", TimeValue (m_coreDelay));
+
+  Ipv4StaticRoutingHelper routing;
+  address.SetBase (m_backhaulNetwork, Ipv4Mask ("255.255.255.252"));
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Node> rsu = m_rsus.Get (i);
+      Ptr<Node> router = m_routers.Get (i / m_fanOut);
+      NetDeviceContainer link = access.Install (rsu, router);
+      Ipv4InterfaceContainer ifs = address.Assign (link);
+      address.NewNetwork ();
+
+      Ptr<Ipv4> rsuIp = rsu->GetObject<Ipv4> ();
+      routing.GetStaticRouting (rsuIp)->SetDefaultRoute (
+          ifs.GetAddress (1), rsuIp->GetInterfaceForDevice (link.Get (0)));
+      Ptr<Ipv4> routerIp = router->GetObject<Ipv4> ();
+      routing.GetStaticRouting (routerIp)->AddNetworkRouteTo (
+          GetRsuNetwork (i), GetRsuMask (), ifs.GetAddress (0),
+          routerIp->GetInterfaceForDevice (link.Get (1)));
+    }
+
+  Ptr<Ipv4> gatewayIp = m_gateway->GetObject<Ipv4> ();
+  Ipv4Mask blockMask (~0u << (32 - m_rsuPrefix + __builtin_ctz (m_block)));
+  for (uint32_t c = 0; c < clusters; c++)
+    {
+      Ptr<Node> router = m_routers.Get (c);
+      NetDeviceContainer link = core.Install (router, m_gateway);
+      Ipv4InterfaceContainer ifs = address.Assign (link);
+      address.NewNetwork ();
+
+      Ptr<Ipv4> routerIp = router->GetObject<Ipv4> ();
+      routing.GetStaticRouting (routerIp)->SetDefaultRoute (
+          ifs.GetAddress (1), routerIp->GetInterfaceForDevice (link.Get (0)));
+      // one route for the whole aligned block of the cluster
+      routing.GetStaticRouting (gatewayIp)->AddNetworkRouteTo (
+          GetRsuNetwork (c * m_fanOut), blockMask, ifs.GetAddress (0),
+          gatewayIp->GetInterfaceForDevice (link.Get (1)));
+    }
+
+  ApplicationContainer apps;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Application> app = m_appFactory.Create<Application> ();
+      m_rsus.Get (i)->AddApplication (app);
+      apps.Add (app);
+    }
+
+  NS_LOG_INFO (n << " RSUs behind " << clusters << " routers, subnets /" << m_rsuPrefix
+                  << " from " << m_rsuNetwork << ", backhaul from " << m_backhaulNetwork);
+  return apps;
+}
+
+NetDeviceContainer
+RsuDeploymentHelper::InstallControlRadio (const WifiHelper &wifi, const WifiPhyHelper &phy,
+                                          const WifiMacHelper &mac, NodeContainer nodes)
+{
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    DynamicCast<WifiNetDevice> (devices.Get (i))->GetPhy ()->SetChannelNumber (178); // CCH
+  return devices;
+}
+
+void
+RsuDeploymentHelper::SpreadServiceChannels (NodeContainer rsus)
+{
+  static const uint8_t channels[] = {172, 174, 176, 180, 182, 184}; // SCH1-6
+  const uint32_t nChannels = sizeof (channels) / sizeof (channels[0]);
+
+  std::vector<Vector> positions;
+  std::vector<uint32_t> assigned;
+  for (uint32_t i = 0; i < rsus.GetN (); i++)
+    {
+      Ptr<Node> rsu = rsus.Get (i);
+      Vector position = rsu->GetObject<MobilityModel> ()->GetPosition ();
+      std::vector<double> nearest (nChannels, std::numeric_limits<double>::infinity ());
+      for (uint32_t j = 0; j < i; j++)
+        nearest[assigned[j]] =
+            std::min (nearest[assigned[j]], CalculateDistance (position, positions[j]));
+      uint32_t best = std::max_element (nearest.begin (), nearest.end ()) - nearest.begin ();
+      positions.push_back (position);
+      assigned.push_back (best);
+
+      Ptr<WifiNetDevice> data;
+      for (uint32_t d = 0; d < rsu->GetNDevices () && !data; d++)
+        data = DynamicCast<WifiNetDevice> (rsu->GetDevice (d));
+      NS_ABORT_MSG_IF (!data, "RSU " << rsu->GetId () << " has no Wi-Fi device");
+      data->GetPhy ()->SetChannelNumber (channels[best]);
+      NS_LOG_INFO ("RSU " << rsu->GetId () << " on channel " << (uint32_t) channels[best]);
+    }
+}
+
+NodeContainer
+RsuDeploymentHelper::GetRsus () const
+{
+  return m_rsus;
+}
+
+NodeContainer
+RsuDeploymentHelper::GetRouters () const
+{
+  return m_routers;
+}
+
+Ptr<Node>
+RsuDeploymentHelper::GetGateway () const
+{
+  return m_gateway;
+}
+
+} // namespace ns3
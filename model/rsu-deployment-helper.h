@@ -0,0 +1,123 @@
+#ifndef RSU_DEPLOYMENT_HELPER_H
+#define RSU_DEPLOYMENT_HELPER_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/object-factory.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/application-container.h"
+#include "ns3/ipv4-address.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class WifiHelper;
+class WifiPhyHelper;
+class WifiMacHelper;
+
+/**
+ * Places RSUs on the junctions of a SUMO network and builds their backhaul.
+ *
+ * The non-internal junctions of NetFile are candidate sites. Policy picks
+ * every Every-th junction, the junction nearest to each point of a grid of
+ * Spacing, or greedily the junctions covering the most others within Range
+ * until Coverage of them are covered. MaxRsus caps the result.
+ *
+ * Install creates the RSU nodes with a Wi-Fi device and a BeaconRsuNet,
+ * groups nearby RSUs (Z-order) into clusters of FanOut behind a router,
+ * and links the routers to one gateway: a two-level point-to-point tree.
+ * Each RSU gets a RsuPrefix subnet from RsuNetwork; the subnets of a
+ * cluster form one aligned block, so the gateway holds one route per
+ * cluster. Links take /30 subnets from BackhaulNetwork. The plan aborts
+ * if the address blocks are too small or overlap.
+ *
+ * With MultiChannel each RSU gets a second radio on the CCH for the hellos
+ * and DHCP, and its first radio, which carries the data, is moved to a
+ * service channel spread over the RSUs. Vehicles need a control radio as
+ * well (InstallControlRadio) and tune their first radio to the SCH their
+ * RSU advertises.
+ */
+class RsuDeploymentHelper : public ns3::Object
+{
+public:
+  enum Policy { EVERY_KTH, GRID, COVERAGE };
+
+  /** Candidate RSU site */
+  struct Junction
+  {
+    std::string id;
+    double x;
+    double y;
+  };
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  RsuDeploymentHelper ();
+  ~RsuDeploymentHelper ();
+
+  /** Policy from "junction:<k>", "grid:<spacing>" or "coverage:<fraction>" */
+  void SetDeployment (std::string spec);
+  /** Attribute of the BeaconRsuNet installed on every RSU */
+  void SetApplicationAttribute (std::string name, const AttributeValue &value);
+
+  /** Non-internal junctions of a SUMO network file */
+  static std::vector<Junction> ReadJunctions (std::string netFile);
+  /** Junctions of NetFile selected by the policy */
+  std::vector<Junction> Place () const;
+
+  /** Create RSUs, routers and gateway; returns the RSU applications */
+  ApplicationContainer Install (const WifiHelper &wifi, const WifiPhyHelper &phy,
+                                const WifiMacHelper &mac);
+
+  NodeContainer GetRsus () const;
+  NodeContainer GetRouters () const;
+  Ptr<Node> GetGateway () const;
+  /** Wireless subnet of the i-th RSU */
+  Ipv4Address GetRsuNetwork (uint32_t i) const;
+  Ipv4Mask GetRsuMask () const;
+
+  /** Add a second radio on the CCH to each node, after its data radio */
+  static NetDeviceContainer InstallControlRadio (const WifiHelper &wifi, const WifiPhyHelper &phy,
+                                                 const WifiMacHelper &mac, NodeContainer nodes);
+  /**
+   * Put the first radio of each RSU on the SCH whose nearest RSU already on
+   * it is farthest away, so neighbours use different channels.
+   */
+  static void SpreadServiceChannels (NodeContainer rsus);
+
+private:
+  std::vector<uint32_t> PlaceEveryKth (const std::vector<Junction> &junctions) const;
+  std::vector<uint32_t> PlaceGrid (const std::vector<Junction> &junctions) const;
+  std::vector<uint32_t> PlaceCoverage (const std::vector<Junction> &junctions) const;
+  /** Order sites so neighbours are consecutive (Morton code) */
+  static void SortByZOrder (std::vector<Junction> &sites);
+
+  std::string m_netFile; /**< SUMO network */
+  Policy m_policy; /**< Site selection */
+  uint32_t m_every; /**< EVERY_KTH: take one junction out of this many */
+  double m_spacing; /**< GRID: grid spacing (m) */
+  double m_range; /**< COVERAGE: radius covered by an RSU (m) */
+  double m_coverage; /**< COVERAGE: share of the junctions to cover */
+  uint32_t m_maxRsus; /**< Upper bound on the RSUs (0: none) */
+  double m_height; /**< Antenna height (m) */
+  uint32_t m_fanOut; /**< RSUs behind one router */
+  Ipv4Address m_rsuNetwork; /**< First RSU subnet */
+  uint32_t m_rsuPrefix; /**< Prefix length of an RSU subnet */
+  Ipv4Address m_backhaulNetwork; /**< First backhaul /30 */
+  std::string m_accessDataRate; /**< RSU to router links */
+  Time m_accessDelay;
+  std::string m_coreDataRate; /**< Router to gateway links */
+  Time m_coreDelay;
+  bool m_multiChannel; /**< Hellos and DHCP on the CCH, data on spread SCHs */
+
+  ObjectFactory m_appFactory; /**< BeaconRsuNet */
+  std::vector<Junction> m_sites; /**< Sites of the installed RSUs */
+  NodeContainer m_rsus;
+  NodeContainer m_routers;
+  Ptr<Node> m_gateway;
+  uint32_t m_block; /**< RSU subnets per cluster block (power of two) */
+};
+} // namespace ns3
+#endif
@@ -0,0 +1,67 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer
+ * thread. Head and tail are kept on separate cache lines; each side only
+ * writes its own index and reads the other one with acquire semantics.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+  explicit SpscQueue (size_t capacity) : m_slots (capacity + 1), m_head (0), m_tail (0)
+  {
+  }
+
+  /** Producer: move the item in, false (item untouched) if the queue is full */
+  bool
+  Push (T &item)
+  {
+    size_t tail = m_tail.load (std::memory_order_relaxed);
+    size_t next = (tail + 1) % m_slots.size ();
+    if (next == m_head.load (std::memory_order_acquire))
+      return false;
+    m_slots[tail] = std::move (item);
+    m_tail.store (next, std::memory_order_release);
+    return true;
+  }
+
+  /** Consumer: move the oldest item out, false if the queue is empty */
+  bool
+  Pop (T &item)
+  {
+    size_t head = m_head.load (std::memory_order_relaxed);
+    if (head == m_tail.load (std::memory_order_acquire))
+      return false;
+    item = std::move (m_slots[head]);
+    m_head.store ((head + 1) % m_slots.size (), std::memory_order_release);
+    return true;
+  }
+
+  bool
+  IsEmpty () const
+  {
+    return m_head.load (std::memory_order_acquire) == m_tail.load (std::memory_order_acquire);
+  }
+
+  bool
+  IsFull () const
+  {
+    size_t next = (m_tail.load (std::memory_order_acquire) + 1) % m_slots.size ();
+    return next == m_head.load (std::memory_order_acquire);
+  }
+
+private:
+  std::vector<T> m_slots; /**< One slot more than the capacity */
+  std::atomic<size_t> m_head; /**< Next slot to read, written by the consumer */
+  char m_pad[64]; /**< Keeps the two indexes on separate cache lines */
+  std::atomic<size_t> m_tail; /**< Next slot to write, written by the producer */
+};
+} // namespace ns3
+#endif
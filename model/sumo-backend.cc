@@ -0,0 +1,190 @@
+#include "ns3/log.h"
+#include "ns3/traci-module.h"
+#include "sumo-backend.h"
+
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("sumo-backend");
+
+static const double g_networkRange = 1e7; /**< Context subscription range (m) */
+
+SumoBackend::~SumoBackend ()
+{
+}
+
+TraciSumoBackend::TraciSumoBackend (uint16_t port, double waitForSocket)
+    : m_port (port), m_waitForSocket (waitForSocket), m_traci (new TraCIAPI ()), m_pid (0)
+{
+}
+
+TraciSumoBackend::~TraciSumoBackend ()
+{
+  Close ();
+  delete m_traci;
+}
+
+void
+TraciSumoBackend::Start (const std::vector<std::string> &args)
+{
+  std::vector<char *> argv;
+  for (const auto &a : args)
+    argv.push_back (const_cast<char *> (a.c_str ()));
+  argv.push_back (0);
+
+  m_pid = fork ();
+  if (m_pid < 0)
+    NS_FATAL_ERROR ("Can't fork SUMO");
+  if (m_pid == 0)
+    {
+      execvp (argv[0], argv.data ());
+      _exit (127);
+    }
+
+  auto deadline = std::chrono::steady_clock::now () + std::chrono::duration<double> (m_waitForSocket);
+  while (true)
+    {
+      try
+        {
+          m_traci->connect ("localhost", m_port);
+          break;
+        }
+      catch (std::exception &e)
+        {
+          if (std::chrono::steady_clock::now () > deadline)
+            NS_FATAL_ERROR ("Can't connect to SUMO on port " << m_port << ": " << e.what ());
+          std::this_thread::sleep_for (std::chrono::milliseconds (50));
+        }
+    }
+  NS_LOG_INFO ("SUMO " << m_pid << " connected on port " << m_port);
+}
+
+void
+TraciSumoBackend::Close ()
+{
+  if (!m_pid)
+    return;
+  try
+    {
+      m_traci->close ();
+    }
+  catch (std::exception &e)
+    {
+      NS_LOG_WARN ("Closing TraCI: " << e.what ());
+      kill (m_pid, SIGTERM);
+    }
+  waitpid (m_pid, 0, 0);
+  m_pid = 0;
+}
+
+void
+TraciSumoBackend::SimulationStep (double time)
+{
+  m_traci->simulationStep (time);
+}
+
+double
+TraciSumoBackend::GetTime ()
+{
+  return m_traci->simulation.getTime ();
+}
+
+void
+TraciSumoBackend::Subscribe (bool dynamics, bool stops)
+{
+  std::vector<int> vars = {libsumo::VAR_POSITION3D, libsumo::VAR_SPEED, libsumo::VAR_ANGLE};
+  if (dynamics)
+    {
+      vars.push_back (libsumo::VAR_ACCELERATION);
+      vars.push_back (libsumo::VAR_ROAD_ID);
+    }
+  if (stops)
+    vars.push_back (libsumo::VAR_STOPSTATE);
+
+  // a context around any junction, with a range beyond any network, holds every vehicle
+  std::vector<std::string> junctions = m_traci->junction.getIDList ();
+  NS_ABORT_MSG_IF (junctions.empty (), "SUMO network without junctions");
+  m_junction = junctions.front ();
+  m_traci->junction.subscribeContext (m_junction, libsumo::CMD_GET_VEHICLE_VARIABLE,
+                                      g_networkRange, vars);
+  // ids of the step only: a widened interval is stepped one SUMO step at a time
+  m_traci->simulation.subscribe (
+      {libsumo::VAR_DEPARTED_VEHICLES_IDS, libsumo::VAR_ARRIVED_VEHICLES_IDS});
+}
+
+void
+TraciSumoBackend::GetFlows (std::vector<std::string> &departed, std::vector<std::string> &arrived)
+{
+  typedef libsumo::TraCIStringList List;
+  libsumo::TraCIResults r = m_traci->simulation.getSubscriptionResults ("");
+  auto d = std::dynamic_pointer_cast<List> (r[libsumo::VAR_DEPARTED_VEHICLES_IDS]);
+  auto a = std::dynamic_pointer_cast<List> (r[libsumo::VAR_ARRIVED_VEHICLES_IDS]);
+  departed = d ? d->value : std::vector<std::string> ();
+  arrived = a ? a->value : std::vector<std::string> ();
+}
+
+void
+TraciSumoBackend::GetVehicles (std::vector<SumoVehicleState> &states)
+{
+  states.clear ();
+  libsumo::SubscriptionResults results =
+      m_traci->junction.getContextSubscriptionResults (m_junction);
+  for (auto &v : results)
+    {
+      libsumo::TraCIResults &r = v.second;
+      SumoVehicleState state;
+      state.id = v.first;
+      auto pos = std::dynamic_pointer_cast<libsumo::TraCIPosition> (r[libsumo::VAR_POSITION3D]);
+      auto speed = std::dynamic_pointer_cast<libsumo::TraCIDouble> (r[libsumo::VAR_SPEED]);
+      auto angle = std::dynamic_pointer_cast<libsumo::TraCIDouble> (r[libsumo::VAR_ANGLE]);
+      auto accel = std::dynamic_pointer_cast<libsumo::TraCIDouble> (r[libsumo::VAR_ACCELERATION]);
+      auto road = std::dynamic_pointer_cast<libsumo::TraCIString> (r[libsumo::VAR_ROAD_ID]);
+      auto stop = std::dynamic_pointer_cast<libsumo::TraCIInt> (r[libsumo::VAR_STOPSTATE]);
+      if (!pos || !speed || !angle)
+        continue;
+      state.x = pos->x;
+      state.y = pos->y;
+      state.z = pos->z;
+      state.speed = speed->value;
+      state.angle = angle->value;
+      state.acceleration = accel ? accel->value : 0;
+      state.onJunction = road && road->value.compare (0, 1, ":") == 0;
+      state.stopState = stop ? stop->value : 0;
+      states.push_back (state);
+    }
+}
+void
+TraciSumoBackend::Apply (const SumoCommand &c)
+{
+  switch (c.type)
+    {
+    case SumoCommand::SET_SPEED:
+      m_traci->vehicle.setSpeed (c.vehicleId, c.value);
+      break;
+    case SumoCommand::SLOW_DOWN:
+      m_traci->vehicle.slowDown (c.vehicleId, c.value, c.duration);
+      break;
+    case SumoCommand::SET_MAX_SPEED:
+      m_traci->vehicle.setMaxSpeed (c.vehicleId, c.value);
+      break;
+    case SumoCommand::CHANGE_TARGET:
+      m_traci->vehicle.changeTarget (c.vehicleId, c.edge);
+      break;
+    case SumoCommand::CHANGE_LANE:
+      m_traci->vehicle.changeLane (c.vehicleId, c.lane, c.duration);
+      break;
+    case SumoCommand::SET_STOP:
+      m_traci->vehicle.setStop (c.vehicleId, c.edge, c.value, c.lane, c.duration);
+      break;
+    case SumoCommand::RESUME:
+      m_traci->vehicle.resume (c.vehicleId);
+      break;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,147 @@
+#ifndef SUMO_BACKEND_H
+#define SUMO_BACKEND_H
+#include "ns3/simple-ref-count.h"
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+class TraCIAPI;
+
+namespace ns3 {
+
+/** Kinematics of one vehicle after a SUMO step */
+struct SumoVehicleState
+{
+  std::string id;
+  double x;
+  double y;
+  double z;
+  double speed; /**< m/s */
+  double angle; /**< SUMO heading: degrees, 0 north, clockwise */
+  double acceleration; /**< m/s^2, filled by GetVehicleDynamics */
+  bool onJunction; /**< On a junction internal edge, filled by GetVehicleDynamics */
+  int stopState; /**< SUMO stop state bits (1: stopped, 2: parking), filled by GetStopState */
+};
+
+/** Change of a vehicle requested by ns-3, applied at the next synchronization */
+struct SumoCommand
+{
+  enum Type { SET_SPEED, SLOW_DOWN, SET_MAX_SPEED, CHANGE_TARGET, CHANGE_LANE, SET_STOP, RESUME };
+
+  std::string vehicleId;
+  Type type;
+  double value; /**< speed (m/s) or stop position (m) */
+  double duration; /**< SLOW_DOWN, CHANGE_LANE, SET_STOP (s) */
+  std::string edge; /**< CHANGE_TARGET, SET_STOP */
+  int lane; /**< CHANGE_LANE, SET_STOP */
+};
+
+/** Everything VanetSumoClient needs from one SUMO step */
+struct SumoStep
+{
+  double time; /**< SUMO time reached */
+  uint32_t nextSteps; /**< SynchIntervals until the next synchronization */
+  double maxError; /**< Largest dead-reckoning error of this step (m) */
+  uint32_t errors; /**< Vehicles beyond the dead-reckoning error bound */
+  std::vector<std::string> departed; /**< Tracked vehicles that entered the network */
+  std::vector<std::string> arrived; /**< Tracked vehicles that left the network */
+  std::vector<SumoVehicleState> vehicles; /**< States of all tracked vehicles */
+};
+
+/**
+ * Connection to a running SUMO. Calls are made from a single thread at a
+ * time, the simulation thread or the VanetSumoClient pipeline thread.
+ */
+class SumoBackend : public SimpleRefCount<SumoBackend>
+{
+public:
+  virtual ~SumoBackend ();
+
+  /** Start SUMO with this command line (args[0] is the binary) */
+  virtual void Start (const std::vector<std::string> &args) = 0;
+  virtual void Close () = 0;
+
+  /** Advance SUMO until the given time (seconds) */
+  virtual void SimulationStep (double time) = 0;
+  virtual double GetTime () = 0;
+  /**
+   * Subscribe, once after Start, to the vehicle variables for the whole
+   * network and to the departed and arrived ids: SUMO then returns them with
+   * every step, so a step is a single exchange however many vehicles there
+   * are.
+   *
+   * \param dynamics also the acceleration and road (junction flag), needed
+   *        by the adaptive synchronization only
+   * \param stops also the stop state, needed to report stopped vehicles only
+   */
+  virtual void Subscribe (bool dynamics, bool stops) = 0;
+  /** States of the vehicles in the network after the last step, sorted by
+   * id; comparing two lists also finds the departures and arrivals of
+   * intermediate SUMO steps */
+  virtual void GetVehicles (std::vector<SumoVehicleState> &states) = 0;
+  /** Vehicles that entered and left the network in the last SUMO step only */
+  virtual void GetFlows (std::vector<std::string> &departed, std::vector<std::string> &arrived) = 0;
+  virtual void Apply (const SumoCommand &command) = 0;
+};
+
+/** SUMO in its own process, driven over the TraCI socket */
+class TraciSumoBackend : public SumoBackend
+{
+public:
+  /**
+   * \param port TraCI port given to SUMO with --remote-port
+   * \param waitForSocket seconds to retry the connection while SUMO starts
+   */
+  TraciSumoBackend (uint16_t port, double waitForSocket);
+  ~TraciSumoBackend ();
+
+  virtual void Start (const std::vector<std::string> &args);
+  virtual void Close ();
+
+  virtual void SimulationStep (double time);
+  virtual double GetTime ();
+  virtual void Subscribe (bool dynamics, bool stops);
+  virtual void GetVehicles (std::vector<SumoVehicleState> &states);
+  virtual void GetFlows (std::vector<std::string> &departed, std::vector<std::string> &arrived);
+  virtual void Apply (const SumoCommand &command);
+
+private:
+  uint16_t m_port;
+  double m_waitForSocket;
+  TraCIAPI *m_traci;
+  pid_t m_pid; /**< SUMO process */
+  std::string m_junction; /**< Center of the context subscription */
+};
+
+/**
+ * SUMO linked into the ns-3 process through libsumo: no child process, no
+ * socket and no serialization. libsumo holds a single simulation per
+ * process and has no GUI. Enabled by configuring with --with-libsumo;
+ * otherwise the class exists but IsAvailable is false and it can't start.
+ */
+class LibsumoBackend : public SumoBackend
+{
+public:
+  /** True if vanetsim was built with --with-libsumo */
+  static bool IsAvailable ();
+
+  LibsumoBackend ();
+  ~LibsumoBackend ();
+
+  virtual void Start (const std::vector<std::string> &args);
+  virtual void Close ();
+
+  virtual void SimulationStep (double time);
+  virtual double GetTime ();
+  virtual void Subscribe (bool dynamics, bool stops);
+  virtual void GetVehicles (std::vector<SumoVehicleState> &states);
+  virtual void GetFlows (std::vector<std::string> &departed, std::vector<std::string> &arrived);
+  virtual void Apply (const SumoCommand &command);
+
+private:
+  bool m_running;
+  std::string m_junction; /**< Center of the context subscription */
+};
+} // namespace ns3
+#endif
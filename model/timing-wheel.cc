@@ -0,0 +1,286 @@
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "timing-wheel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("timing-wheel");
+NS_OBJECT_ENSURE_REGISTERED (TimingWheel);
+
+Ptr<TimingWheel> TimingWheel::s_default = 0;
+
+TypeId
+TimingWheel::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::TimingWheel")
+          .SetParent<Object> ()
+          .AddConstructor<TimingWheel> ()
+          .AddAttribute ("Granularity", "Length of a tick; timer phases are kept to it",
+                         TimeValue (MicroSeconds (10)),
+                         MakeTimeAccessor (&TimingWheel::m_granularity), MakeTimeChecker ())
+          .AddAttribute ("Fired", "Timer callbacks fired", TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&TimingWheel::m_fired),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("Wakes", "Scheduler events used to fire them", TypeId::ATTR_GET,
+                         UintegerValue (0), MakeUintegerAccessor (&TimingWheel::m_wakes),
+                         MakeUintegerChecker<uint64_t> ());
+  return tid;
+}
+
+TypeId
+TimingWheel::GetInstanceTypeId () const
+{
+  return TimingWheel::GetTypeId ();
+}
+
+TimingWheel::TimingWheel ()
+    : m_count (0),
+      m_now (0),
+      m_wake (std::numeric_limits<uint64_t>::max ()),
+      m_fired (0),
+      m_wakes (0)
+{
+  std::fill (&m_heads[0][0], &m_heads[0][0] + LEVELS * SLOTS, -1);
+  std::memset (m_occupied, 0, sizeof (m_occupied));
+  // index 0 is never handed out, so no TimerId is 0
+  m_timers.resize (1);
+  m_timers[0].active = false;
+}
+
+TimingWheel::~TimingWheel ()
+{
+}
+
+void
+TimingWheel::DoDispose ()
+{
+  m_event.Cancel ();
+  m_timers.clear ();
+  m_free.clear ();
+  Object::DoDispose ();
+}
+
+Ptr<TimingWheel>
+TimingWheel::GetDefault ()
+{
+  if (!s_default)
+    {
+      s_default = CreateObject<TimingWheel> ();
+      Simulator::ScheduleDestroy ([] () {
+        s_default->Dispose ();
+        s_default = 0;
+      });
+    }
+  return s_default;
+}
+
+uint64_t
+TimingWheel::ToTick (Time t) const
+{
+  // rounded up: a timer never fires before its time
+  int64_t step = m_granularity.GetTimeStep ();
+  return (t.GetTimeStep () + step - 1) / step;
+}
+
+TimingWheel::TimerId
+TimingWheel::Schedule (Time delay, Time period, Callback<void> callback)
+{
+  int64_t step = m_granularity.GetTimeStep ();
+  if (!m_count)
+    m_now = Simulator::Now ().GetTimeStep () / step; // last tick already passed
+
+  int32_t index;
+  if (m_free.empty ())
+    {
+      index = m_timers.size ();
+      m_timers.push_back (Timer ());
+      m_timers[index].generation = 0;
+    }
+  else
+    {
+      index = m_free.back ();
+      m_free.pop_back ();
+    }
+
+  Timer &t = m_timers[index];
+  t.callback = callback;
+  // m_now may lag Now () while the wheel sleeps; the expiry is rounded up from Now () itself
+  t.expiry = std::max (ToTick (Simulator::Now () + delay), m_now + 1);
+  t.period =
+      period.IsZero () ? 0 : std::max<int64_t> ((period.GetTimeStep () + step / 2) / step, 1);
+  t.generation++;
+  t.active = true;
+  m_count++;
+  Insert (index);
+  Reschedule ();
+  return ((uint64_t) t.generation << 32) | (uint32_t) index;
+}
+
+bool
+TimingWheel::IsRunning (TimerId id) const
+{
+  uint32_t index = id & 0xffffffff;
+  return index && index < m_timers.size () && m_timers[index].active &&
+         m_timers[index].generation == (id >> 32);
+}
+
+void
+TimingWheel::Cancel (TimerId id)
+{
+  if (!IsRunning (id))
+    return;
+  int32_t index = id & 0xffffffff;
+  Unlink (index);
+  Release (index);
+}
+
+void
+TimingWheel::Release (int32_t index)
+{
+  m_timers[index].active = false;
+  m_timers[index].callback = Callback<void> ();
+  m_free.push_back (index);
+  m_count--;
+}
+
+void
+TimingWheel::Insert (int32_t index)
+{
+  Timer &t = m_timers[index];
+  uint64_t delta = t.expiry - m_now;
+  NS_ABORT_MSG_IF (delta >> (LEVELS * SLOT_BITS), "Timer beyond the range of the wheel");
+
+  uint32_t level = 0;
+  while (level < LEVELS - 1 && delta >= (1ull << (SLOT_BITS * (level + 1))))
+    level++;
+  uint32_t slot = (t.expiry >> (SLOT_BITS * level)) & (SLOTS - 1);
+
+  t.level = level;
+  t.slot = slot;
+  t.prev = -1;
+  t.next = m_heads[level][slot];
+  if (t.next >= 0)
+    m_timers[t.next].prev = index;
+  m_heads[level][slot] = index;
+  m_occupied[level][slot / 64] |= 1ull << (slot % 64);
+}
+
+void
+TimingWheel::Unlink (int32_t index)
+{
+  Timer &t = m_timers[index];
+  if (t.prev >= 0)
+    m_timers[t.prev].next = t.next;
+  else
+    m_heads[t.level][t.slot] = t.next;
+  if (t.next >= 0)
+    m_timers[t.next].prev = t.prev;
+  if (m_heads[t.level][t.slot] < 0)
+    m_occupied[t.level][t.slot / 64] &= ~(1ull << (t.slot % 64));
+}
+
+void
+TimingWheel::Cascade (uint32_t level, uint32_t slot)
+{
+  int32_t index = m_heads[level][slot];
+  m_heads[level][slot] = -1;
+  m_occupied[level][slot / 64] &= ~(1ull << (slot % 64));
+  while (index >= 0)
+    {
+      int32_t next = m_timers[index].next;
+      Insert (index);
+      index = next;
+    }
+}
+
+int32_t
+TimingWheel::FindNext (const uint64_t *bitmap, uint32_t from)
+{
+  for (uint32_t d = 0; d < SLOTS;)
+    {
+      uint32_t slot = (from + d) & (SLOTS - 1);
+      uint64_t word = bitmap[slot / 64] >> (slot % 64);
+      if (word)
+        {
+          d += __builtin_ctzll (word);
+          return d < SLOTS ? d : -1;
+        }
+      d += 64 - slot % 64;
+    }
+  return -1;
+}
+
+uint64_t
+TimingWheel::GetNextWake () const
+{
+  uint64_t wake = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      // level 0: the tick itself; above: the start of the block to cascade
+      uint32_t shift = SLOT_BITS * level;
+      uint64_t block = (m_now >> shift) + 1;
+      int32_t d = FindNext (m_occupied[level], block & (SLOTS - 1));
+      if (d >= 0)
+        wake = std::min (wake, (block + d) << shift);
+    }
+  return wake;
+}
+
+void
+TimingWheel::Reschedule ()
+{
+  uint64_t wake = GetNextWake ();
+  if (wake == m_wake && m_event.IsRunning ())
+    return;
+  m_event.Cancel ();
+  m_wake = wake;
+  if (wake == std::numeric_limits<uint64_t>::max ())
+    return;
+  // a cascade of a block entered while the wheel slept can be due already
+  Time at = std::max (TimeStep (wake * m_granularity.GetTimeStep ()), Simulator::Now ());
+  m_event = Simulator::Schedule (at - Simulator::Now (), &TimingWheel::Wake, this);
+}
+
+void
+TimingWheel::Wake ()
+{
+  m_wakes++;
+  uint64_t previous = m_now;
+  m_now = m_wake;
+
+  // bring the timers of the blocks just entered down, highest level first
+  for (uint32_t level = LEVELS - 1; level > 0; level--)
+    {
+      uint32_t shift = SLOT_BITS * level;
+      if ((m_now >> shift) != (previous >> shift))
+        Cascade (level, (m_now >> shift) & (SLOTS - 1));
+    }
+
+  uint32_t slot = m_now & (SLOTS - 1);
+  int32_t index;
+  while ((index = m_heads[0][slot]) >= 0)
+    {
+      Unlink (index);
+      Timer &t = m_timers[index];
+      Callback<void> callback = t.callback;
+      if (t.period)
+        {
+          // re-armed first: the callback may cancel its own timer
+          t.expiry += t.period;
+          Insert (index);
+        }
+      else
+        Release (index);
+      m_fired++;
+      callback ();
+    }
+  Reschedule ();
+}
+
+} // namespace ns3
@@ -0,0 +1,88 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Hierarchical timing wheel shared by periodic application timers.
+ *
+ * Time is cut in ticks of Granularity. Four levels of 256 slots hold the
+ * timers due within 2^8, 2^16, 2^24 and 2^32 ticks; a timer moves down one
+ * level when the wheel enters its block. Insert and cancel are O(1), and a
+ * single ns-3 event is scheduled, at the next tick holding timers (or the
+ * next block to cascade), which fires every timer of that slot. A timer
+ * fires on the first tick at or after its time, never before it; the period
+ * is rounded to the nearest tick.
+ */
+class TimingWheel : public ns3::Object
+{
+public:
+  typedef uint64_t TimerId; /**< generation << 32 | index, 0 is never used */
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  TimingWheel ();
+  ~TimingWheel ();
+
+  /** Wheel shared by the applications of this simulation */
+  static Ptr<TimingWheel> GetDefault ();
+
+  /** Fire the callback after delay, then every period (0: once) */
+  TimerId Schedule (Time delay, Time period, Callback<void> callback);
+  void Cancel (TimerId id);
+  bool IsRunning (TimerId id) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  enum { LEVELS = 4, SLOT_BITS = 8, SLOTS = 1 << SLOT_BITS };
+
+  struct Timer
+  {
+    Callback<void> callback;
+    uint64_t expiry; /**< tick */
+    uint64_t period; /**< ticks, 0: one-shot */
+    uint32_t generation;
+    int32_t prev;
+    int32_t next;
+    uint8_t level;
+    uint8_t slot;
+    bool active;
+  };
+
+  uint64_t ToTick (Time t) const; /**< First tick at or after t */
+  void Insert (int32_t index);
+  void Unlink (int32_t index);
+  void Release (int32_t index);
+  void Cascade (uint32_t level, uint32_t slot);
+  uint64_t GetNextWake () const;
+  void Reschedule ();
+  void Wake ();
+
+  static int32_t FindNext (const uint64_t *bitmap, uint32_t from);
+
+  Time m_granularity; /**< Length of a tick */
+
+  std::vector<Timer> m_timers; /**< Timer pool */
+  std::vector<int32_t> m_free; /**< Unused entries of the pool */
+  int32_t m_heads[LEVELS][SLOTS]; /**< First timer of each slot (-1: empty) */
+  uint64_t m_occupied[LEVELS][SLOTS / 64]; /**< Bitmap of the non-empty slots */
+  uint32_t m_count; /**< Active timers */
+  uint64_t m_now; /**< Last tick processed */
+  uint64_t m_wake; /**< Tick of the pending wake event */
+  EventId m_event; /**< Pending wake event */
+
+  uint64_t m_fired; /**< Callbacks fired */
+  uint64_t m_wakes; /**< Scheduler events used */
+
+  static Ptr<TimingWheel> s_default;
+};
+} // namespace ns3
+#endif
@@ -0,0 +1,237 @@
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/vector.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+#include "ns3/mobility-model.h"
+#include "ns3/wifi-net-device.h"
+#include "vanet-anim-exporter.h"
+
+#include <cmath>
+#include <sstream>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("vanet-anim-exporter");
+NS_OBJECT_ENSURE_REGISTERED (VanetAnimExporter);
+
+TypeId
+VanetAnimExporter::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::VanetAnimExporter")
+          .SetParent<Object> ()
+          .AddConstructor<VanetAnimExporter> ()
+          .AddAttribute ("FileName", "NetAnim XML output",
+                         StringValue ("contrib/vanetsim/results/vanet-anim.xml"),
+                         MakeStringAccessor (&VanetAnimExporter::m_fileName), MakeStringChecker ())
+          .AddAttribute ("PollInterval", "How often node positions are checked",
+                         TimeValue (Seconds (0.1)),
+                         MakeTimeAccessor (&VanetAnimExporter::m_pollInterval), MakeTimeChecker ())
+          .AddAttribute ("DistanceThreshold",
+                         "Movement (m) since the last position of a node that writes a new one",
+                         DoubleValue (5.0),
+                         MakeDoubleAccessor (&VanetAnimExporter::m_distanceThreshold),
+                         MakeDoubleChecker<double> (0))
+          .AddAttribute ("TimeThreshold",
+                         "Time since the last position of a moving node that writes a new one",
+                         TimeValue (Seconds (1)),
+                         MakeTimeAccessor (&VanetAnimExporter::m_timeThreshold), MakeTimeChecker ())
+          .AddAttribute ("Decimation",
+                         "Write a position when either threshold is exceeded, or only both",
+                         EnumValue (VanetAnimExporter::DECIMATION_EITHER),
+                         MakeEnumAccessor (&VanetAnimExporter::m_decimation),
+                         MakeEnumChecker (VanetAnimExporter::DECIMATION_EITHER, "Either",
+                                          VanetAnimExporter::DECIMATION_BOTH, "Both"))
+          .AddAttribute ("PacketSampling", "Animate 1 of every N wireless frames (0: none)",
+                         UintegerValue (100),
+                         MakeUintegerAccessor (&VanetAnimExporter::m_packetSampling),
+                         MakeUintegerChecker<uint32_t> ())
+          .AddAttribute ("MaxNodes", "Only the first MaxNodes nodes are animated",
+                         UintegerValue (500), MakeUintegerAccessor (&VanetAnimExporter::m_maxNodes),
+                         MakeUintegerChecker<uint32_t> ())
+          .AddAttribute ("MinBound", "Lower corner of the animated area",
+                         VectorValue (Vector (0, 0, 0)),
+                         MakeVectorAccessor (&VanetAnimExporter::m_minBound), MakeVectorChecker ())
+          .AddAttribute ("MaxBound", "Upper corner of the animated area",
+                         VectorValue (Vector (200, 200, 0)),
+                         MakeVectorAccessor (&VanetAnimExporter::m_maxBound),
+                         MakeVectorChecker ());
+  return tid;
+}
+
+TypeId
+VanetAnimExporter::GetInstanceTypeId () const
+{
+  return VanetAnimExporter::GetTypeId ();
+}
+
+VanetAnimExporter::VanetAnimExporter ()
+    : m_decimation (DECIMATION_EITHER), m_positionsWritten (0), m_packetsWritten (0)
+{
+}
+
+VanetAnimExporter::~VanetAnimExporter ()
+{
+}
+
+void
+VanetAnimExporter::DoDispose ()
+{
+  Stop ();
+  m_nodes.clear ();
+  Object::DoDispose ();
+}
+
+void
+VanetAnimExporter::Write (const std::string &xml)
+{
+  m_writer.Append (xml.data (), xml.size ());
+}
+
+void
+VanetAnimExporter::SetNodeDescription (Ptr<Node> node, std::string description, uint8_t r,
+                                       uint8_t g, uint8_t b)
+{
+  std::ostringstream os;
+  os << "<nu p=\"d\" t=\"0\" id=\"" << node->GetId () << "\" descr=\"" << description << "\"/>\n"
+     << "<nu p=\"c\" t=\"0\" id=\"" << node->GetId () << "\" r=\"" << (uint32_t) r << "\" g=\""
+     << (uint32_t) g << "\" b=\"" << (uint32_t) b << "\"/>\n";
+  m_descriptions.push_back (os.str ());
+}
+
+void
+VanetAnimExporter::Start ()
+{
+  NS_LOG_FUNCTION (this << m_fileName);
+
+  m_writer.Open (m_fileName);
+
+  std::ostringstream os;
+  os << "<anim ver=\"netanim-3.108\" filetype=\"animation\" >\n"
+     << "<topology minX=\"" << m_minBound.x << "\" minY=\"" << m_minBound.y << "\" maxX=\""
+     << m_maxBound.x << "\" maxY=\"" << m_maxBound.y << "\">\n";
+
+  for (NodeList::Iterator n = NodeList::Begin ();
+       n != NodeList::End () && m_nodes.size () < m_maxNodes; n++)
+    {
+      Ptr<MobilityModel> mob = (*n)->GetObject<MobilityModel> ();
+      if (!mob)
+        continue;
+
+      AnimNode animNode;
+      animNode.node = *n;
+      animNode.lastPos = mob->GetPosition ();
+      animNode.lastWrite = Simulator::Now ();
+      m_nodes.push_back (animNode);
+      os << "<node id=\"" << (*n)->GetId () << "\" sysId=\"0\" locX=\"" << animNode.lastPos.x
+         << "\" locY=\"" << animNode.lastPos.y << "\" />\n";
+
+      for (uint32_t i = 0; i < (*n)->GetNDevices () && m_packetSampling; i++)
+        {
+          Ptr<WifiNetDevice> dev = DynamicCast<WifiNetDevice> ((*n)->GetDevice (i));
+          if (!dev)
+            continue;
+          dev->GetPhy ()->TraceConnectWithoutContext (
+              "MonitorSnifferTx",
+              MakeBoundCallback (&VanetAnimExporter::SnifferTx, this, (*n)->GetId ()));
+          dev->GetPhy ()->TraceConnectWithoutContext (
+              "MonitorSnifferRx",
+              MakeBoundCallback (&VanetAnimExporter::SnifferRx, this, (*n)->GetId ()));
+        }
+    }
+  os << "</topology>\n";
+  for (auto const &d : m_descriptions)
+    os << d;
+  Write (os.str ());
+
+  m_pollEvent = Simulator::Schedule (m_pollInterval, &VanetAnimExporter::PollPositions, this);
+  Simulator::ScheduleDestroy (&VanetAnimExporter::Stop, this);
+}
+
+void
+VanetAnimExporter::PollPositions ()
+{
+  Time now = Simulator::Now ();
+  std::ostringstream os;
+  for (auto &n : m_nodes)
+    {
+      Vector pos = n.node->GetObject<MobilityModel> ()->GetPosition ();
+      double dx = pos.x - n.lastPos.x;
+      double dy = pos.y - n.lastPos.y;
+      if (dx == 0 && dy == 0)
+        continue;
+      bool timeDue = now - n.lastWrite >= m_timeThreshold;
+      bool distanceDue = dx * dx + dy * dy >= m_distanceThreshold * m_distanceThreshold;
+      if (m_decimation == DECIMATION_BOTH ? !(timeDue && distanceDue) : !(timeDue || distanceDue))
+        continue;
+
+      os << "<nu p=\"p\" t=\"" << now.GetSeconds () << "\" id=\"" << n.node->GetId ()
+         << "\" x=\"" << pos.x << "\" y=\"" << pos.y << "\" z=\"" << pos.z << "\"/>\n";
+      n.lastPos = pos;
+      n.lastWrite = now;
+      m_positionsWritten++;
+    }
+  Write (os.str ());
+
+  m_pollEvent = Simulator::Schedule (m_pollInterval, &VanetAnimExporter::PollPositions, this);
+}
+
+Time
+VanetAnimExporter::GetTxDuration (Ptr<const Packet> packet, WifiTxVector tx)
+{
+  uint64_t rate = tx.GetMode ().GetDataRate (tx.GetChannelWidth ());
+  return rate ? Seconds (packet->GetSize () * 8.0 / rate) : Seconds (0);
+}
+
+void
+VanetAnimExporter::SnifferTx (VanetAnimExporter *anim, uint32_t nodeId, Ptr<const Packet> packet,
+                              uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu)
+{
+  if (packet->GetUid () % anim->m_packetSampling)
+    return;
+
+  double start = Simulator::Now ().GetSeconds ();
+  double end = start + GetTxDuration (packet, tx).GetSeconds ();
+  std::ostringstream os;
+  os.precision (9);
+  os << "<wpr uId=\"" << packet->GetUid () << "\" fId=\"" << nodeId << "\" fbTx=\"" << start
+     << "\" lbTx=\"" << end << "\"/>\n";
+  anim->Write (os.str ());
+  anim->m_packetsWritten++;
+}
+
+void
+VanetAnimExporter::SnifferRx (VanetAnimExporter *anim, uint32_t nodeId, Ptr<const Packet> packet,
+                              uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu,
+                              SignalNoiseDbm sn)
+{
+  if (packet->GetUid () % anim->m_packetSampling)
+    return;
+
+  // the sniffer fires once the frame has been received
+  double end = Simulator::Now ().GetSeconds ();
+  double start = end - GetTxDuration (packet, tx).GetSeconds ();
+  std::ostringstream os;
+  os.precision (9);
+  os << "<wpr uId=\"" << packet->GetUid () << "\" tId=\"" << nodeId << "\" fbRx=\"" << start
+     << "\" lbRx=\"" << end << "\"/>\n";
+  anim->Write (os.str ());
+}
+
+void
+VanetAnimExporter::Stop ()
+{
+  if (!m_writer.IsOpen ())
+    return;
+
+  m_pollEvent.Cancel ();
+  Write ("</anim>\n");
+  m_writer.Close ();
+  NS_LOG_INFO ("animation " << m_fileName << ": " << m_positionsWritten << " positions, "
+                            << m_packetsWritten << " packets");
+}
+
+} // namespace ns3
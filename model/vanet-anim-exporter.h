@@ -0,0 +1,87 @@
+#ifndef VANET_ANIM_EXPORTER_H
+#define VANET_ANIM_EXPORTER_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/node.h"
+#include "ns3/vector.h"
+#include "ns3/wifi-phy.h"
+#include "async-file-writer.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * NetAnim trace writer for large scenarios.
+ *
+ * AnimationInterface records every node at every poll and every packet,
+ * which for thousands of vehicles at the 0.1 s TraCI step is gigabytes.
+ * This exporter writes the same XML format, reduced by:
+ *  - position decimation: a node update is written once it moved
+ *    DistanceThreshold meters or TimeThreshold passed since its last one
+ *    (Decimation Either, the default), or only when both hold (Both);
+ *    a node that has not moved at all is never written again
+ *  - packet sampling: 1 of every PacketSampling wireless frames (by packet
+ *    uid, so transmission and receptions of a frame are kept together)
+ *  - a node cap: only the first MaxNodes nodes are animated
+ *
+ * The XML is streamed through an AsyncFileWriter while the run goes on.
+ */
+class VanetAnimExporter : public ns3::Object
+{
+public:
+  /** How the two decimation thresholds combine */
+  enum Decimation { DECIMATION_EITHER, DECIMATION_BOTH };
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  VanetAnimExporter ();
+  ~VanetAnimExporter ();
+
+  /** Describe and color a node (e.g. RSUs) before Start */
+  void SetNodeDescription (Ptr<Node> node, std::string description, uint8_t r, uint8_t g,
+                           uint8_t b);
+
+  /** Write the topology and start polling positions and packets */
+  void Start ();
+  void Stop ();
+
+private:
+  struct AnimNode
+  {
+    Ptr<Node> node;
+    Vector lastPos; /**< last written position */
+    Time lastWrite; /**< time of the last written position */
+  };
+
+  virtual void DoDispose (void);
+
+  void PollPositions ();
+  void Write (const std::string &xml);
+
+  static void SnifferTx (VanetAnimExporter *anim, uint32_t nodeId, Ptr<const Packet> packet,
+                         uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu);
+  static void SnifferRx (VanetAnimExporter *anim, uint32_t nodeId, Ptr<const Packet> packet,
+                         uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu, SignalNoiseDbm sn);
+  static Time GetTxDuration (Ptr<const Packet> packet, WifiTxVector tx);
+
+  std::string m_fileName; /**< Output XML */
+  Time m_pollInterval; /**< Position poll interval */
+  double m_distanceThreshold; /**< Movement that triggers a new position */
+  Time m_timeThreshold; /**< Time since the last position that triggers a new one */
+  Decimation m_decimation; /**< Either threshold or both of them */
+  uint32_t m_packetSampling; /**< Keep 1 of every N frames (0: none) */
+  uint32_t m_maxNodes; /**< Nodes animated */
+  Vector m_minBound; /**< Topology bounds */
+  Vector m_maxBound;
+
+  std::vector<AnimNode> m_nodes; /**< Animated nodes */
+  std::vector<std::string> m_descriptions; /**< Extra node elements written with the topology */
+  AsyncFileWriter m_writer; /**< Background file output */
+  EventId m_pollEvent; /**< Next position poll */
+  uint64_t m_positionsWritten;
+  uint64_t m_packetsWritten;
+};
+} // namespace ns3
+#endif
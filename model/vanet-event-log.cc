@@ -0,0 +1,235 @@
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/callback.h"
+#include "vanet-event-log.h"
+#include "beacon-rsu-net.h"
+#include "beacon-search-net.h"
+
+#include <cstring>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("vanet-event-log");
+NS_OBJECT_ENSURE_REGISTERED (VanetEventLog);
+
+namespace {
+
+/* Trace sinks; the log and the node id are bound when connecting */
+void
+BeaconTxSink (VanetEventLog *log, uint32_t nodeId, Ptr<const Packet> packet)
+{
+  log->Log (nodeId, VanetEventLog::BEACON_TX, packet->GetSize ());
+}
+
+void
+BeaconRxSink (VanetEventLog *log, uint32_t nodeId, uint32_t rsuId, double signal, double noise)
+{
+  log->Log (nodeId, VanetEventLog::BEACON_RX, rsuId, (uint32_t) (int32_t) (noise * 100), signal);
+}
+
+void
+DhcpRequestTxSink (VanetEventLog *log, uint32_t nodeId, Ipv4Address rsuAddr, bool retry)
+{
+  log->Log (nodeId, VanetEventLog::DHCP_REQUEST_TX, rsuAddr.Get (), retry);
+}
+
+void
+DhcpRequestRxSink (VanetEventLog *log, uint32_t nodeId, uint32_t vehicleId, Ipv4Address addr)
+{
+  log->Log (nodeId, VanetEventLog::DHCP_REQUEST_RX, vehicleId, addr.Get ());
+}
+
+void
+DhcpOfferTxSink (VanetEventLog *log, uint32_t nodeId, uint32_t vehicleId, Ipv4Address addr)
+{
+  log->Log (nodeId, VanetEventLog::DHCP_OFFER_TX, vehicleId, addr.Get ());
+}
+
+void
+DhcpOfferRxSink (VanetEventLog *log, uint32_t nodeId, uint32_t rsuId, Ipv4Address addr)
+{
+  log->Log (nodeId, VanetEventLog::DHCP_OFFER_RX, rsuId, addr.Get ());
+}
+
+void
+HandoverSink (VanetEventLog *log, uint32_t nodeId, uint32_t oldRsuId, uint32_t newRsuId)
+{
+  log->Log (nodeId, VanetEventLog::HANDOVER, oldRsuId, newRsuId);
+}
+
+void
+PingPongSink (VanetEventLog *log, uint32_t nodeId, uint32_t oldRsuId, uint32_t newRsuId)
+{
+  log->Log (nodeId, VanetEventLog::PING_PONG, oldRsuId, newRsuId);
+}
+
+void
+LeasesSink (VanetEventLog *log, uint32_t nodeId, uint32_t oldValue, uint32_t newValue)
+{
+  log->Log (nodeId, VanetEventLog::LEASES_IN_USE, oldValue, newValue);
+}
+
+} // namespace
+
+TypeId
+VanetEventLog::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::VanetEventLog")
+          .SetParent<Object> ()
+          .AddConstructor<VanetEventLog> ()
+          .AddAttribute ("FileName", "Binary event log file",
+                         StringValue ("contrib/vanetsim/results/vanet-events.bin"),
+                         MakeStringAccessor (&VanetEventLog::m_fileName), MakeStringChecker ())
+          .AddAttribute ("BufferRecords", "Ring buffer capacity (records)", UintegerValue (65536),
+                         MakeUintegerAccessor (&VanetEventLog::m_bufferRecords),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("Mode",
+                         "Stream: write every full buffer. "
+                         "FlightRecorder: keep only the last BufferRecords events",
+                         EnumValue (VanetEventLog::STREAM),
+                         MakeEnumAccessor (&VanetEventLog::m_mode),
+                         MakeEnumChecker (VanetEventLog::STREAM, "Stream",
+                                          VanetEventLog::FLIGHT_RECORDER, "FlightRecorder"));
+  return tid;
+}
+
+TypeId
+VanetEventLog::GetInstanceTypeId () const
+{
+  return VanetEventLog::GetTypeId ();
+}
+
+VanetEventLog::VanetEventLog ()
+    : m_file (0), m_head (0), m_used (0), m_overwritten (0), m_written (0)
+{
+}
+
+VanetEventLog::~VanetEventLog ()
+{
+}
+
+void
+VanetEventLog::DoDispose ()
+{
+  Close ();
+  Object::DoDispose ();
+}
+
+void
+VanetEventLog::Open ()
+{
+  NS_LOG_FUNCTION (this << m_fileName);
+
+  m_file = std::fopen (m_fileName.c_str (), "wb");
+  if (!m_file)
+    NS_FATAL_ERROR ("Can't open event log file " << m_fileName);
+
+  FileHeader header;
+  std::memcpy (header.magic, "VNETLOG1", sizeof (header.magic));
+  header.recordSize = sizeof (Record);
+  header.reserved = 0;
+  std::fwrite (&header, sizeof (header), 1, m_file);
+
+  m_ring.assign (m_bufferRecords, Record ());
+  m_head = 0;
+  m_used = 0;
+
+  // make sure the last records reach the file
+  Simulator::ScheduleDestroy (&VanetEventLog::Close, this);
+}
+
+void
+VanetEventLog::InstallAll ()
+{
+  if (!m_file)
+    Open ();
+
+  for (NodeList::Iterator n = NodeList::Begin (); n != NodeList::End (); n++)
+    {
+      uint32_t nodeId = (*n)->GetId ();
+      for (uint32_t i = 0; i < (*n)->GetNApplications (); i++)
+        {
+          Ptr<Application> app = (*n)->GetApplication (i);
+          if (DynamicCast<BeaconRsuNet> (app))
+            {
+              app->TraceConnectWithoutContext ("BeaconTx",
+                                               MakeBoundCallback (&BeaconTxSink, this, nodeId));
+              app->TraceConnectWithoutContext (
+                  "DhcpRequestRx", MakeBoundCallback (&DhcpRequestRxSink, this, nodeId));
+              app->TraceConnectWithoutContext ("DhcpOfferTx",
+                                               MakeBoundCallback (&DhcpOfferTxSink, this, nodeId));
+              app->TraceConnectWithoutContext ("LeasesInUse",
+                                               MakeBoundCallback (&LeasesSink, this, nodeId));
+            }
+          else if (DynamicCast<BeaconSearchNet> (app))
+            {
+              app->TraceConnectWithoutContext ("BeaconRx",
+                                               MakeBoundCallback (&BeaconRxSink, this, nodeId));
+              app->TraceConnectWithoutContext (
+                  "DhcpRequestTx", MakeBoundCallback (&DhcpRequestTxSink, this, nodeId));
+              app->TraceConnectWithoutContext ("DhcpOfferRx",
+                                               MakeBoundCallback (&DhcpOfferRxSink, this, nodeId));
+              app->TraceConnectWithoutContext ("Handover",
+                                               MakeBoundCallback (&HandoverSink, this, nodeId));
+              app->TraceConnectWithoutContext ("PingPong",
+                                               MakeBoundCallback (&PingPongSink, this, nodeId));
+            }
+        }
+    }
+}
+
+void
+VanetEventLog::WriteRange (size_t first, size_t count)
+{
+  if (count)
+    {
+      std::fwrite (&m_ring[first], sizeof (Record), count, m_file);
+      m_written += count;
+    }
+}
+
+void
+VanetEventLog::Flush ()
+{
+  if (!m_file || !m_used)
+    return;
+
+  // oldest record first; the used part of the ring may wrap around
+  size_t tail = (m_head + m_ring.size () - m_used) % m_ring.size ();
+  if (tail < m_head)
+    WriteRange (tail, m_head - tail);
+  else
+    {
+      WriteRange (tail, m_ring.size () - tail);
+      WriteRange (0, m_head);
+    }
+  m_used = 0;
+}
+
+void
+VanetEventLog::Close ()
+{
+  if (!m_file)
+    return;
+
+  Flush ();
+  std::fclose (m_file);
+  m_file = 0;
+  NS_LOG_INFO ("event log " << m_fileName << ": " << m_written << " records written, "
+                            << m_overwritten << " overwritten");
+}
+
+const char *
+VanetEventLog::GetEventName (uint16_t type)
+{
+  static const char *names[EVENT_TYPE_MAX] = {
+      "UNKNOWN",       "BEACON_TX",     "BEACON_RX", "DHCP_REQUEST_TX", "DHCP_REQUEST_RX",
+      "DHCP_OFFER_TX", "DHCP_OFFER_RX", "HANDOVER",  "PING_PONG",       "LEASES_IN_USE"};
+  return (type < EVENT_TYPE_MAX) ? names[type] : names[0];
+}
+
+} // namespace ns3
@@ -0,0 +1,118 @@
+#ifndef VANET_EVENT_LOG_H
+#define VANET_EVENT_LOG_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-address.h"
+#include <cstdio>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Structured binary event log.
+ *
+ * Every event is a fixed-size Record appended to a preallocated ring buffer.
+ * In stream mode the ring is written to FileName in one block whenever it
+ * fills up; in flight-recorder mode the oldest records are overwritten and
+ * only the last BufferRecords events are written when the log is closed.
+ * Use vanet-event-log-decode to print the file.
+ *
+ * File layout: FileHeader followed by Records, both in host byte order.
+ */
+class VanetEventLog : public ns3::Object
+{
+public:
+  enum EventType : uint16_t {
+    BEACON_TX = 1, /**< arg0: packet size */
+    BEACON_RX, /**< arg0: RSU id, arg1: noise (0.01 dBm, signed), value: signal (dBm) */
+    DHCP_REQUEST_TX, /**< arg0: RSU ip, arg1: retry */
+    DHCP_REQUEST_RX, /**< arg0: vehicle id, arg1: RSU ip */
+    DHCP_OFFER_TX, /**< arg0: vehicle id, arg1: offered ip */
+    DHCP_OFFER_RX, /**< arg0: RSU id, arg1: offered ip */
+    HANDOVER, /**< arg0: old RSU id, arg1: new RSU id */
+    PING_PONG, /**< arg0: old RSU id, arg1: new RSU id */
+    LEASES_IN_USE, /**< arg0: old value, arg1: new value */
+    EVENT_TYPE_MAX
+  };
+
+  enum Mode { STREAM, FLIGHT_RECORDER };
+
+#pragma pack(push, 1)
+  struct FileHeader
+  {
+    char magic[8]; /**< "VNETLOG1" */
+    uint32_t recordSize;
+    uint32_t reserved;
+  };
+
+  struct Record
+  {
+    int64_t timeNs;
+    uint32_t nodeId;
+    uint16_t type;
+    uint16_t flags;
+    uint32_t arg0;
+    uint32_t arg1;
+    double value;
+  };
+#pragma pack(pop)
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  VanetEventLog ();
+  ~VanetEventLog ();
+
+  /** Open FileName and allocate the ring buffer */
+  void Open ();
+  /** Connect to the trace sources of every BeaconRsuNet and BeaconSearchNet installed so far */
+  void InstallAll ();
+
+  /** Append one record */
+  inline void
+  Log (uint32_t nodeId, EventType type, uint32_t arg0 = 0, uint32_t arg1 = 0, double value = 0)
+  {
+    Record &r = m_ring[m_head];
+    r.timeNs = Simulator::Now ().GetNanoSeconds ();
+    r.nodeId = nodeId;
+    r.type = type;
+    r.flags = 0;
+    r.arg0 = arg0;
+    r.arg1 = arg1;
+    r.value = value;
+
+    m_head = (m_head + 1 == m_ring.size ()) ? 0 : m_head + 1;
+    if (m_used < m_ring.size ())
+      m_used++;
+    else
+      m_overwritten++;
+    if (m_used == m_ring.size () && m_mode == STREAM)
+      Flush ();
+  }
+
+  /** Write the buffered records to the file */
+  void Flush ();
+  /** Flush and close the file */
+  void Close ();
+
+  static const char *GetEventName (uint16_t type);
+
+private:
+  virtual void DoDispose (void);
+
+  void WriteRange (size_t first, size_t count);
+
+  std::string m_fileName; /**< Output file */
+  uint32_t m_bufferRecords; /**< Ring buffer capacity */
+  Mode m_mode; /**< Stream or flight recorder */
+
+  std::FILE *m_file; /**< Output stream */
+  std::vector<Record> m_ring; /**< Preallocated records */
+  size_t m_head; /**< Next slot to write */
+  size_t m_used; /**< Records not yet written to the file */
+  uint64_t m_overwritten; /**< Records lost in flight-recorder mode */
+  uint64_t m_written; /**< Records written to the file */
+};
+} // namespace ns3
+#endif
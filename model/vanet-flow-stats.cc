@@ -0,0 +1,257 @@
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+#include "vanet-flow-stats.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("vanet-flow-stats");
+NS_OBJECT_ENSURE_REGISTERED (VanetFlowStats);
+
+VanetFlowStats::Counters::Counters ()
+    : txPackets (0), txBytes (0), rxPackets (0), rxBytes (0), delaySum (0), delayMax (0)
+{
+}
+
+VanetFlowStats::Vehicle::Vehicle () : firstTx (Seconds (-1))
+{
+}
+
+TypeId
+VanetFlowStats::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::VanetFlowStats")
+          .SetParent<Object> ()
+          .AddConstructor<VanetFlowStats> ()
+          .AddAttribute ("RecoveryWindow", "Time after a new address counted as recovery",
+                         TimeValue (Seconds (1)),
+                         MakeTimeAccessor (&VanetFlowStats::m_recoveryWindow),
+                         MakeTimeChecker ());
+  return tid;
+}
+
+TypeId
+VanetFlowStats::GetInstanceTypeId () const
+{
+  return VanetFlowStats::GetTypeId ();
+}
+
+VanetFlowStats::VanetFlowStats ()
+{
+}
+
+VanetFlowStats::~VanetFlowStats ()
+{
+}
+
+void
+VanetFlowStats::DoDispose ()
+{
+  m_vehicles.clear ();
+  Object::DoDispose ();
+}
+
+std::string
+VanetFlowStats::GetPhaseName (Phase phase)
+{
+  static const char *names[] = {"detached", "attached", "handover", "recovery"};
+  return names[phase];
+}
+
+void
+VanetFlowStats::Install (Ptr<BeaconSearchNet> app)
+{
+  std::string context = std::to_string (app->GetNode ()->GetId ());
+  m_vehicles[app->GetNode ()->GetId ()].app = app;
+  app->TraceConnect ("DhcpRequestTx", context,
+                     MakeCallback (&VanetFlowStats::NotifyRequest, this));
+  app->TraceConnect ("DhcpOfferRx", context, MakeCallback (&VanetFlowStats::NotifyOffer, this));
+}
+
+void
+VanetFlowStats::Install (Ptr<VanetTrafficClient> app)
+{
+  app->TraceConnectWithoutContext ("Tx", MakeCallback (&VanetFlowStats::NotifyTx, this));
+  app->TraceConnectWithoutContext ("Rx", MakeCallback (&VanetFlowStats::NotifyRx, this));
+  app->TraceConnectWithoutContext ("Detach", MakeCallback (&VanetFlowStats::NotifyDetach, this));
+}
+
+void
+VanetFlowStats::Install (Ptr<VanetTrafficServer> app)
+{
+  app->TraceConnectWithoutContext ("Tx", MakeCallback (&VanetFlowStats::NotifyTx, this));
+  app->TraceConnectWithoutContext ("Rx", MakeCallback (&VanetFlowStats::NotifyRx, this));
+}
+
+void
+VanetFlowStats::InstallAll ()
+{
+  for (NodeList::Iterator n = NodeList::Begin (); n != NodeList::End (); ++n)
+    for (uint32_t i = 0; i < (*n)->GetNApplications (); i++)
+      {
+        Ptr<Application> app = (*n)->GetApplication (i);
+        if (Ptr<BeaconSearchNet> search = DynamicCast<BeaconSearchNet> (app))
+          Install (search);
+        else if (Ptr<VanetTrafficClient> client = DynamicCast<VanetTrafficClient> (app))
+          Install (client);
+        else if (Ptr<VanetTrafficServer> server = DynamicCast<VanetTrafficServer> (app))
+          Install (server);
+      }
+}
+
+void
+VanetFlowStats::SetPhase (uint32_t vehicleId, uint32_t rsuId, Phase phase, Time start)
+{
+  std::vector<Segment> &timeline = m_vehicles[vehicleId].timeline;
+  while (!timeline.empty () && timeline.back ().start > Now ())
+    timeline.pop_back ();
+  if (!timeline.empty () && timeline.back ().rsuId == rsuId && timeline.back ().phase == phase)
+    return;
+  Segment s = {start, rsuId, phase};
+  timeline.push_back (s);
+}
+
+VanetFlowStats::Segment
+VanetFlowStats::GetSegment (const Vehicle &v, Time t) const
+{
+  auto it = std::upper_bound (v.timeline.begin (), v.timeline.end (), t,
+                              [] (Time time, const Segment &s) { return time < s.start; });
+  if (it == v.timeline.begin ())
+    return Segment{Seconds (0), 9999, PHASE_DETACHED};
+  return *(--it);
+}
+
+void
+VanetFlowStats::NotifyRequest (std::string context, Ipv4Address rsuAddr, bool retry)
+{
+  uint32_t vehicleId = std::stoul (context);
+  Vehicle &v = m_vehicles[vehicleId];
+  Segment current = GetSegment (v, Now ());
+  // pre-acquisitions of a make before break handover keep the vehicle attached
+  if (v.app && v.app->IsHandoverPending () && current.phase != PHASE_DETACHED)
+    SetPhase (vehicleId, current.rsuId, PHASE_HANDOVER, Now ());
+}
+
+void
+VanetFlowStats::NotifyOffer (std::string context, uint32_t rsuId, Ipv4Address addr)
+{
+  uint32_t vehicleId = std::stoul (context);
+  Segment current = GetSegment (m_vehicles[vehicleId], Now ());
+  if (current.phase == PHASE_DETACHED ||
+      (current.rsuId == rsuId && current.phase != PHASE_HANDOVER))
+    {
+      SetPhase (vehicleId, rsuId, PHASE_ATTACHED, Now ());
+      return;
+    }
+  SetPhase (vehicleId, rsuId, PHASE_RECOVERY, Now ());
+  Segment attached = {Now () + m_recoveryWindow, rsuId, PHASE_ATTACHED};
+  m_vehicles[vehicleId].timeline.push_back (attached);
+}
+
+void
+VanetFlowStats::NotifyDetach (uint32_t vehicleId)
+{
+  SetPhase (vehicleId, 9999, PHASE_DETACHED, Now ());
+}
+
+void
+VanetFlowStats::NotifyTx (const VanetTrafficTag &tag, uint32_t bytes)
+{
+  Vehicle &v = m_vehicles[tag.GetVehicleId ()];
+  if (v.firstTx.IsNegative ())
+    v.firstTx = Now ();
+  Segment s = GetSegment (v, Now ());
+
+  Counters *counters[] = {&v.flows[tag.GetDirection ()],
+                          &m_buckets[BucketKey (s.rsuId, s.phase, tag.GetDirection ())]};
+  for (Counters *c : counters)
+    {
+      c->txPackets++;
+      c->txBytes += bytes;
+    }
+}
+
+void
+VanetFlowStats::NotifyRx (const VanetTrafficTag &tag, uint32_t bytes)
+{
+  // counted in the bucket the data was sent in
+  Vehicle &v = m_vehicles[tag.GetVehicleId ()];
+  Segment s = GetSegment (v, tag.GetTxTime ());
+  double delay = (Now () - tag.GetTxTime ()).GetSeconds ();
+
+  Counters *counters[] = {&v.flows[tag.GetDirection ()],
+                          &m_buckets[BucketKey (s.rsuId, s.phase, tag.GetDirection ())]};
+  for (Counters *c : counters)
+    {
+      c->rxPackets++;
+      c->rxBytes += bytes;
+      c->delaySum += delay;
+      c->delayMax = std::max (c->delayMax, delay);
+    }
+}
+
+void
+VanetFlowStats::Print (std::ostream &os) const
+{
+  static const char *directions[] = {"up", "down"};
+  auto printCounters = [&os] (const Counters &c, double seconds) {
+    double loss = c.txBytes ? 100.0 * (1 - (double) c.rxBytes / c.txBytes) : 0;
+    os << " " << std::setw (8) << c.txPackets << " " << std::setw (8) << c.rxPackets << " "
+       << std::setw (6) << loss << " " << std::setw (9)
+       << (seconds > 0 ? c.rxBytes * 8 / seconds / 1000 : 0) << " "
+       << (c.rxPackets ? c.delaySum / c.rxPackets * 1000 : 0) << "/" << c.delayMax * 1000
+       << std::endl;
+  };
+
+  os << std::fixed << std::setprecision (1);
+  os << "vehicle dir  tx-pkts  rx-pkts  loss% goodput-kbps delay-ms (mean/max), goodput over "
+        "the time attached"
+     << std::endl;
+  std::map<std::pair<uint32_t, Phase>, double> exposure; // vehicle seconds per RSU and phase
+  for (auto const &v : m_vehicles)
+    {
+      if (v.second.firstTx.IsNegative ())
+        continue;
+      // time in each RSU and phase since the first packet
+      double active = 0;
+      Segment current = GetSegment (v.second, v.second.firstTx);
+      current.start = v.second.firstTx;
+      for (auto s = v.second.timeline.begin (); current.start < Now (); ++s)
+        {
+          if (s != v.second.timeline.end () && s->start <= current.start)
+            continue;
+          Time end = (s == v.second.timeline.end ()) ? Now () : std::min (s->start, Now ());
+          double seconds = (end - current.start).GetSeconds ();
+          exposure[std::make_pair (current.rsuId, current.phase)] += seconds;
+          if (current.phase != PHASE_DETACHED)
+            active += seconds;
+          if (s == v.second.timeline.end ())
+            break;
+          current = *s;
+        }
+
+      for (int d = 0; d < 2; d++)
+        if (v.second.flows[d].txPackets || v.second.flows[d].rxPackets)
+          {
+            os << std::setw (7) << v.first << " " << std::setw (4) << directions[d];
+            printCounters (v.second.flows[d], active);
+          }
+    }
+
+  os << "    rsu phase     dir  tx-pkts  rx-pkts  loss% goodput-kbps delay-ms (mean/max)"
+     << std::endl;
+  for (auto const &b : m_buckets)
+    {
+      uint32_t rsuId = std::get<0> (b.first);
+      Phase phase = std::get<1> (b.first);
+      os << std::setw (7) << rsuId << " " << std::setw (9) << std::left << GetPhaseName (phase)
+         << std::right << " " << std::setw (4) << directions[std::get<2> (b.first)];
+      auto it = exposure.find (std::make_pair (rsuId, phase));
+      printCounters (b.second, it == exposure.end () ? 0 : it->second);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,100 @@
+#ifndef VANET_FLOW_STATS_H
+#define VANET_FLOW_STATS_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+#include "beacon-search-net.h"
+#include "vanet-traffic-app.h"
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Goodput, delay and loss of the VanetTrafficClient/Server flows, per
+ * vehicle and per (serving RSU, handover phase). The phase of a packet is
+ * the phase of its vehicle when it was sent:
+ *
+ *  detached = no address from an RSU yet, or left the simulation
+ *  attached = connected to the RSU
+ *  handover = DHCP request of a break before make handover sent, no offer yet
+ *  recovery = within RecoveryWindow after the new address
+ *
+ * Goodput of a bucket is its received bits over the vehicle time spent in
+ * it, so phases of different lengths compare per vehicle.
+ */
+class VanetFlowStats : public ns3::Object
+{
+public:
+  enum Phase { PHASE_DETACHED, PHASE_ATTACHED, PHASE_HANDOVER, PHASE_RECOVERY };
+
+  struct Counters
+  {
+    Counters ();
+    uint64_t txPackets;
+    uint64_t txBytes;
+    uint64_t rxPackets; /**< Tagged chunks for TCP */
+    uint64_t rxBytes;
+    double delaySum; /**< s */
+    double delayMax; /**< s */
+  };
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  VanetFlowStats ();
+  ~VanetFlowStats ();
+
+  /** Follow the handover phases of one vehicle */
+  void Install (Ptr<BeaconSearchNet> app);
+  void Install (Ptr<VanetTrafficClient> app);
+  void Install (Ptr<VanetTrafficServer> app);
+  /** Connect to every BeaconSearchNet and traffic app installed so far */
+  void InstallAll ();
+
+  void NotifyTx (const VanetTrafficTag &tag, uint32_t bytes);
+  void NotifyRx (const VanetTrafficTag &tag, uint32_t bytes);
+
+  /** Per vehicle, then per RSU and phase */
+  void Print (std::ostream &os) const;
+
+  static std::string GetPhaseName (Phase phase);
+
+private:
+  struct Segment
+  {
+    Time start;
+    uint32_t rsuId;
+    Phase phase;
+  };
+
+  struct Vehicle
+  {
+    Vehicle ();
+    Ptr<BeaconSearchNet> app;
+    std::vector<Segment> timeline; /**< Phase changes, in time order */
+    Counters flows[2]; /**< Per direction */
+    Time firstTx; /**< Start of the time counted for the goodput (-1 s if no traffic) */
+  };
+
+  /** (RSU id, phase, direction) */
+  typedef std::tuple<uint32_t, Phase, VanetTrafficTag::Direction> BucketKey;
+
+  virtual void DoDispose (void);
+
+  /** The context of the traces is the vehicle node id */
+  void NotifyRequest (std::string context, Ipv4Address rsuAddr, bool retry);
+  void NotifyOffer (std::string context, uint32_t rsuId, Ipv4Address addr);
+  void NotifyDetach (uint32_t vehicleId);
+
+  /** Enter a phase now, dropping the phase changes planned after now */
+  void SetPhase (uint32_t vehicleId, uint32_t rsuId, Phase phase, Time start);
+  Segment GetSegment (const Vehicle &v, Time t) const;
+
+  Time m_recoveryWindow; /**< Length of the recovery phase */
+  std::map<uint32_t, Vehicle> m_vehicles; /**< Vehicle node id -> state and flows */
+  std::map<BucketKey, Counters> m_buckets; /**< Flows per RSU, phase and direction */
+};
+} // namespace ns3
+#endif
@@ -0,0 +1,271 @@
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/output-stream-wrapper.h"
+#include "vanet-host-routing.h"
+
+#include <iomanip>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("vanet-host-routing");
+NS_OBJECT_ENSURE_REGISTERED (VanetHostRouting);
+
+VanetHostRouting::Redirection::Redirection () : to (Ipv4Address::GetAny ()), maxPackets (0)
+{
+}
+
+TypeId
+VanetHostRouting::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::VanetHostRouting")
+                          .SetParent<Ipv4RoutingProtocol> ()
+                          .AddConstructor<VanetHostRouting> ()
+                          .AddAttribute ("Buffered", "Packets held for a departing vehicle",
+                                         TypeId::ATTR_GET, UintegerValue (0),
+                                         MakeUintegerAccessor (&VanetHostRouting::m_buffered),
+                                         MakeUintegerChecker<uint64_t> ())
+                          .AddAttribute ("Redirected", "Packets sent to a vehicle's new address",
+                                         TypeId::ATTR_GET, UintegerValue (0),
+                                         MakeUintegerAccessor (&VanetHostRouting::m_redirected),
+                                         MakeUintegerChecker<uint64_t> ())
+                          .AddAttribute ("BufferDrops",
+                                         "Held packets dropped: buffer full, expired or no route",
+                                         TypeId::ATTR_GET, UintegerValue (0),
+                                         MakeUintegerAccessor (&VanetHostRouting::m_dropped),
+                                         MakeUintegerChecker<uint64_t> ());
+  return tid;
+}
+
+TypeId
+VanetHostRouting::GetInstanceTypeId () const
+{
+  return VanetHostRouting::GetTypeId ();
+}
+
+VanetHostRouting::VanetHostRouting () : m_buffered (0), m_redirected (0), m_dropped (0)
+{
+}
+
+VanetHostRouting::~VanetHostRouting ()
+{
+}
+
+void
+VanetHostRouting::DoDispose ()
+{
+  m_routes.clear ();
+  for (auto &r : m_redirects)
+    r.second.expire.Cancel ();
+  m_redirects.clear ();
+  m_ipv4 = 0;
+  Ipv4RoutingProtocol::DoDispose ();
+}
+
+Ptr<VanetHostRouting>
+VanetHostRouting::Get (Ptr<Node> node)
+{
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ABORT_MSG_IF (!ipv4, "Node " << node->GetId () << " has no Ipv4");
+  Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting> (ipv4->GetRoutingProtocol ());
+  NS_ABORT_MSG_IF (!list, "Node " << node->GetId () << " does not use Ipv4ListRouting");
+
+  int16_t priority;
+  for (uint32_t i = 0; i < list->GetNRoutingProtocols (); i++)
+    {
+      Ptr<VanetHostRouting> routing =
+          DynamicCast<VanetHostRouting> (list->GetRoutingProtocol (i, priority));
+      if (routing)
+        return routing;
+    }
+
+  // above the static routing (0), so host routes win over the default route
+  Ptr<VanetHostRouting> routing = CreateObject<VanetHostRouting> ();
+  list->AddRoutingProtocol (routing, 10);
+  return routing;
+}
+
+void
+VanetHostRouting::AddHostRoute (Ipv4Address dest, Ipv4Address gateway, uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << dest << gateway << interface);
+  Entry &e = m_routes[dest.Get ()];
+  e.gateway = gateway;
+  e.interface = interface;
+}
+
+bool
+VanetHostRouting::RemoveHostRoute (Ipv4Address dest)
+{
+  NS_LOG_FUNCTION (this << dest);
+  return m_routes.erase (dest.Get ()) > 0;
+}
+
+uint32_t
+VanetHostRouting::GetNRoutes () const
+{
+  return m_routes.size ();
+}
+
+void
+VanetHostRouting::Buffer (Ipv4Address dest, uint32_t maxPackets, Time timeout)
+{
+  NS_LOG_FUNCTION (this << dest << maxPackets << timeout);
+  Redirection &r = m_redirects[dest.Get ()];
+  if (r.to != Ipv4Address::GetAny ())
+    return; // already redirected
+  r.maxPackets = maxPackets;
+  r.expire.Cancel ();
+  r.expire = Simulator::Schedule (timeout, &VanetHostRouting::ClearRedirect, this, dest);
+}
+
+void
+VanetHostRouting::Redirect (Ipv4Address dest, Ipv4Address newDest, Time duration)
+{
+  NS_LOG_FUNCTION (this << dest << newDest << duration);
+  Redirection &r = m_redirects[dest.Get ()];
+  r.to = newDest;
+  for (const Held &h : r.held)
+    Send (h.packet, h.header, newDest, h.ucb);
+  r.held.clear ();
+  r.expire.Cancel ();
+  r.expire = Simulator::Schedule (duration, &VanetHostRouting::ClearRedirect, this, dest);
+}
+
+void
+VanetHostRouting::ClearRedirect (Ipv4Address dest)
+{
+  NS_LOG_FUNCTION (this << dest);
+  auto it = m_redirects.find (dest.Get ());
+  if (it == m_redirects.end ())
+    return;
+  m_dropped += it->second.held.size ();
+  it->second.expire.Cancel ();
+  m_redirects.erase (it);
+}
+
+void
+VanetHostRouting::HoldOrRedirect (Redirection &r, Ptr<const Packet> p, const Ipv4Header &header,
+                                  UnicastForwardCallback ucb)
+{
+  if (r.to != Ipv4Address::GetAny ())
+    Send (p, header, r.to, ucb);
+  else if (r.held.size () < r.maxPackets)
+    {
+      Held h = {p, header, ucb};
+      r.held.push_back (h);
+      m_buffered++;
+    }
+  else
+    m_dropped++; // tail drop keeps the held packets in order
+}
+
+void
+VanetHostRouting::Send (Ptr<const Packet> p, Ipv4Header header, Ipv4Address to,
+                        UnicastForwardCallback ucb)
+{
+  // the new address lives behind another RSU: route it like a locally sent packet
+  header.SetDestination (to);
+  Socket::SocketErrno err;
+  Ptr<Ipv4Route> route = m_ipv4->GetRoutingProtocol ()->RouteOutput (p->Copy (), header, 0, err);
+  if (!route)
+    {
+      m_dropped++;
+      return;
+    }
+  m_redirected++;
+  ucb (route, p, header);
+}
+
+Ptr<Ipv4Route>
+VanetHostRouting::Lookup (Ipv4Address dest) const
+{
+  auto it = m_routes.find (dest.Get ());
+  if (it == m_routes.end ())
+    return 0;
+
+  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+  route->SetDestination (dest);
+  route->SetGateway (it->second.gateway);
+  route->SetOutputDevice (m_ipv4->GetNetDevice (it->second.interface));
+  route->SetSource (m_ipv4->GetAddress (it->second.interface, 0).GetLocal ());
+  return route;
+}
+
+Ptr<Ipv4Route>
+VanetHostRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif,
+                               Socket::SocketErrno &sockerr)
+{
+  Ptr<Ipv4Route> route = Lookup (header.GetDestination ());
+  if (!route || (oif && oif != route->GetOutputDevice ()))
+    {
+      sockerr = Socket::ERROR_NOROUTETOHOST;
+      return 0;
+    }
+  sockerr = Socket::ERROR_NOTERROR;
+  return route;
+}
+
+bool
+VanetHostRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
+                              Ptr<const NetDevice> idev, UnicastForwardCallback ucb,
+                              MulticastForwardCallback mcb, LocalDeliverCallback lcb,
+                              ErrorCallback ecb)
+{
+  // local delivery is done by Ipv4ListRouting before asking the protocols
+  auto redirect = m_redirects.find (header.GetDestination ().Get ());
+  Ptr<Ipv4Route> route = Lookup (header.GetDestination ());
+  if (!route && redirect == m_redirects.end ())
+    return false;
+
+  if (!m_ipv4->IsForwarding (m_ipv4->GetInterfaceForDevice (idev)))
+    {
+      ecb (p, header, Socket::ERROR_NOROUTETOHOST);
+      return true;
+    }
+  if (redirect != m_redirects.end ())
+    HoldOrRedirect (redirect->second, p, header, ucb);
+  else
+    ucb (route, p, header);
+  return true;
+}
+
+void
+VanetHostRouting::NotifyInterfaceUp (uint32_t interface)
+{
+}
+
+void
+VanetHostRouting::NotifyInterfaceDown (uint32_t interface)
+{
+}
+
+void
+VanetHostRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
+{
+}
+
+void
+VanetHostRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
+{
+}
+
+void
+VanetHostRouting::SetIpv4 (Ptr<Ipv4> ipv4)
+{
+  m_ipv4 = ipv4;
+}
+
+void
+VanetHostRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+{
+  std::ostream *os = stream->GetStream ();
+  *os << "Host routes: " << m_routes.size () << std::endl;
+  for (const auto &r : m_routes)
+    *os << std::setw (16) << std::left << Ipv4Address (r.first) << std::setw (16)
+        << r.second.gateway << r.second.interface << std::endl;
+}
+
+} // namespace ns3
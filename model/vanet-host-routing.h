@@ -0,0 +1,103 @@
+#ifndef VANET_HOST_ROUTING_H
+#define VANET_HOST_ROUTING_H
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/node.h"
+#include "ns3/event-id.h"
+#include <deque>
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ * Host routes to vehicles, kept in a hash table so a handover adds or
+ * removes one entry per node in O(1). Added to the node's Ipv4ListRouting
+ * above the static routing; destinations without a host route fall
+ * through to the other protocols.
+ *
+ * On an RSU it also bridges handovers: packets forwarded to a departing
+ * vehicle can be held in a bounded per-address buffer, then re-addressed
+ * to the vehicle's new address and sent back over the backhaul. The
+ * rewrite leaves the transport checksums stale, so it suits the default
+ * ns-3 setup with checksums disabled.
+ */
+class VanetHostRouting : public Ipv4RoutingProtocol
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  VanetHostRouting ();
+  ~VanetHostRouting ();
+
+  /** Host routing of a node, added to its Ipv4ListRouting on first use */
+  static Ptr<VanetHostRouting> Get (Ptr<Node> node);
+
+  /** Route to a host, replacing the previous one (gateway 0.0.0.0: on link) */
+  void AddHostRoute (Ipv4Address dest, Ipv4Address gateway, uint32_t interface);
+  bool RemoveHostRoute (Ipv4Address dest);
+  uint32_t GetNRoutes () const;
+
+  /** Hold the packets forwarded to dest, at most maxPackets, until Redirect or timeout */
+  void Buffer (Ipv4Address dest, uint32_t maxPackets, Time timeout);
+  /** Send the held packets, and those forwarded to dest during duration, to newDest */
+  void Redirect (Ipv4Address dest, Ipv4Address newDest, Time duration);
+  /** Drop the held packets of dest and stop redirecting it */
+  void ClearRedirect (Ipv4Address dest);
+
+  virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header,
+                                      Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
+  virtual bool RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
+                           Ptr<const NetDevice> idev, UnicastForwardCallback ucb,
+                           MulticastForwardCallback mcb, LocalDeliverCallback lcb,
+                           ErrorCallback ecb);
+  virtual void NotifyInterfaceUp (uint32_t interface);
+  virtual void NotifyInterfaceDown (uint32_t interface);
+  virtual void NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address);
+  virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
+  virtual void SetIpv4 (Ptr<Ipv4> ipv4);
+  virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream,
+                                  Time::Unit unit = Time::S) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct Entry
+  {
+    Ipv4Address gateway;
+    uint32_t interface;
+  };
+
+  struct Held
+  {
+    Ptr<const Packet> packet;
+    Ipv4Header header;
+    UnicastForwardCallback ucb;
+  };
+
+  struct Redirection
+  {
+    Redirection ();
+    Ipv4Address to; /**< New address, 0.0.0.0 while buffering */
+    uint32_t maxPackets;
+    std::deque<Held> held; /**< Packets waiting for the new address, oldest first */
+    EventId expire;
+  };
+
+  Ptr<Ipv4Route> Lookup (Ipv4Address dest) const;
+  /** Hold the packet, or send it to the new address */
+  void HoldOrRedirect (Redirection &r, Ptr<const Packet> p, const Ipv4Header &header,
+                       UnicastForwardCallback ucb);
+  void Send (Ptr<const Packet> p, Ipv4Header header, Ipv4Address to, UnicastForwardCallback ucb);
+
+  Ptr<Ipv4> m_ipv4;
+  std::unordered_map<uint32_t, Entry> m_routes; /**< Host routes by destination */
+  std::unordered_map<uint32_t, Redirection> m_redirects; /**< By old destination */
+
+  uint64_t m_buffered; /**< Packets held for a departing vehicle */
+  uint64_t m_redirected; /**< Packets sent to a new address */
+  uint64_t m_dropped; /**< Packets over the buffer size, expired or without a route */
+};
+} // namespace ns3
+#endif
@@ -0,0 +1,202 @@
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-mac-queue.h"
+#include "ns3/txop.h"
+#include "vanet-memory-report.h"
+#include "beacon-search-net.h"
+#include "beacon-rsu-net.h"
+
+#include <iomanip>
+#include <iostream>
+#include <unistd.h>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("vanet-memory-report");
+NS_OBJECT_ENSURE_REGISTERED (VanetMemoryReport);
+
+TypeId
+VanetMemoryReport::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::VanetMemoryReport")
+          .SetParent<Object> ()
+          .AddConstructor<VanetMemoryReport> ()
+          .AddAttribute ("Interval", "Simulation time between two reports (0: only on WriteReport)",
+                         TimeValue (Seconds (60)),
+                         MakeTimeAccessor (&VanetMemoryReport::m_interval), MakeTimeChecker ())
+          .AddAttribute ("FileName", "Report file (empty: standard output)",
+                         StringValue ("contrib/vanetsim/results/memory.txt"),
+                         MakeStringAccessor (&VanetMemoryReport::m_fileName),
+                         MakeStringChecker ());
+  return tid;
+}
+
+TypeId
+VanetMemoryReport::GetInstanceTypeId () const
+{
+  return VanetMemoryReport::GetTypeId ();
+}
+
+VanetMemoryReport::VanetMemoryReport ()
+{
+}
+
+VanetMemoryReport::~VanetMemoryReport ()
+{
+}
+
+void
+VanetMemoryReport::DoDispose ()
+{
+  Simulator::Cancel (m_event);
+  m_sources.clear ();
+  if (m_file.is_open ())
+    m_file.close ();
+  Object::DoDispose ();
+}
+
+void
+VanetMemoryReport::AddSource (std::string name, Callback<uint64_t> bytes)
+{
+  m_sources.push_back (std::make_pair (name, bytes));
+}
+
+uint64_t
+VanetMemoryReport::GetResidentBytes ()
+{
+  std::ifstream statm ("/proc/self/statm");
+  uint64_t size = 0, resident = 0;
+  if (!(statm >> size >> resident))
+    return 0;
+  return resident * sysconf (_SC_PAGESIZE);
+}
+
+uint64_t
+VanetMemoryReport::GetPeakResidentBytes ()
+{
+  std::ifstream status ("/proc/self/status");
+  std::string key;
+  while (status >> key)
+    {
+      if (key == "VmHWM:")
+        {
+          uint64_t kb = 0;
+          status >> kb;
+          return kb * 1024;
+        }
+      status.ignore (256, '\n');
+    }
+  return 0;
+}
+
+void
+VanetMemoryReport::Start ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_fileName.empty ())
+    {
+      m_file.open (m_fileName.c_str ());
+      if (!m_file)
+        NS_FATAL_ERROR ("Cannot open " << m_fileName);
+    }
+  if (!m_interval.IsZero ())
+    m_event = Simulator::Schedule (m_interval, &VanetMemoryReport::Periodic, this);
+}
+
+void
+VanetMemoryReport::Periodic ()
+{
+  WriteReport ();
+  m_event = Simulator::Schedule (m_interval, &VanetMemoryReport::Periodic, this);
+}
+
+void
+VanetMemoryReport::CountObject (Ptr<const Object> object)
+{
+  if (object)
+    m_objects[object->GetInstanceTypeId ().GetName ()]++;
+}
+
+void
+VanetMemoryReport::WriteReport ()
+{
+  NS_LOG_FUNCTION (this);
+
+  static const char *txopNames[] = {"Txop", "VO_Txop", "VI_Txop", "BE_Txop", "BK_Txop"};
+
+  m_objects.clear ();
+  uint64_t queuedPackets = 0, queuedBytes = 0;
+  uint64_t beaconTables = 0, leaseMaps = 0;
+
+  for (NodeList::Iterator n = NodeList::Begin (); n != NodeList::End (); ++n)
+    {
+      Ptr<Node> node = *n;
+      Object::AggregateIterator aggregates = node->GetAggregateIterator ();
+      while (aggregates.HasNext ())
+        CountObject (aggregates.Next ());
+
+      for (uint32_t i = 0; i < node->GetNDevices (); ++i)
+        {
+          Ptr<NetDevice> dev = node->GetDevice (i);
+          CountObject (dev);
+          Ptr<WifiNetDevice> wifi = DynamicCast<WifiNetDevice> (dev);
+          if (!wifi)
+            continue;
+          CountObject (wifi->GetPhy ());
+          CountObject (wifi->GetMac ());
+          CountObject (wifi->GetRemoteStationManager ());
+
+          Ptr<WifiMac> mac = wifi->GetMac ();
+          for (const char *name : txopNames)
+            {
+              PointerValue ptr;
+              if (!mac || !mac->GetAttributeFailSafe (name, ptr) || !ptr.Get<Txop> ())
+                continue;
+              Ptr<WifiMacQueue> queue = ptr.Get<Txop> ()->GetWifiMacQueue ();
+              queuedPackets += queue->GetNPackets ();
+              queuedBytes += queue->GetNBytes ();
+            }
+        }
+
+      for (uint32_t i = 0; i < node->GetNApplications (); ++i)
+        {
+          Ptr<Application> app = node->GetApplication (i);
+          CountObject (app);
+          if (Ptr<BeaconSearchNet> vehicle = DynamicCast<BeaconSearchNet> (app))
+            beaconTables += vehicle->GetMemoryUsage ();
+          else if (Ptr<BeaconRsuNet> rsu = DynamicCast<BeaconRsuNet> (app))
+            leaseMaps += rsu->GetMemoryUsage ();
+        }
+    }
+
+  std::ostream &os = m_file.is_open () ? (std::ostream &) m_file : std::cout;
+  os << std::fixed << std::setprecision (1) << "# t=" << Simulator::Now ().GetSeconds ()
+     << "s rss=" << GetResidentBytes () / 1048576.0
+     << "MB peak=" << GetPeakResidentBytes () / 1048576.0 << "MB nodes=" << NodeList::GetNNodes ()
+     << std::endl;
+
+  os << "objects" << std::endl;
+  for (const auto &o : m_objects)
+    os << "  " << std::left << std::setw (48) << o.first << std::right << std::setw (10)
+       << o.second << std::endl;
+
+  os << "bytes" << std::endl;
+  os << "  " << std::left << std::setw (48) << "WifiMacQueue" << std::right << std::setw (14)
+     << queuedBytes << " (" << queuedPackets << " packets)" << std::endl;
+  os << "  " << std::left << std::setw (48) << "BeaconSearchNet::beaconsReceived" << std::right
+     << std::setw (14) << beaconTables << std::endl;
+  os << "  " << std::left << std::setw (48) << "BeaconRsuNet::m_ipAddrUsed" << std::right
+     << std::setw (14) << leaseMaps << std::endl;
+  for (auto &s : m_sources)
+    os << "  " << std::left << std::setw (48) << s.first << std::right << std::setw (14)
+       << s.second () << std::endl;
+  os << std::endl;
+}
+
+} // namespace ns3
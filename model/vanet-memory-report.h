@@ -0,0 +1,67 @@
+#ifndef VANET_MEMORY_REPORT_H
+#define VANET_MEMORY_REPORT_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Opt-in memory accounting for large runs.
+ *
+ * Each report has the resident set size (current and peak, from /proc),
+ * the number of live ns-3 objects by type found through the node list
+ * (aggregated objects, devices and their Wi-Fi PHY, MAC and station
+ * manager, applications), the packets and bytes waiting in the Wi-Fi MAC
+ * queues and the bytes held by the VANETSIM containers (received beacon
+ * tables, DHCP lease maps). Other subsystems add their own line with
+ * AddSource.
+ *
+ * Reports are written every Interval of simulation time; call WriteReport
+ * after Simulator::Run for the final one, while the nodes still exist.
+ */
+class VanetMemoryReport : public ns3::Object
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  VanetMemoryReport ();
+  ~VanetMemoryReport ();
+
+  /** Add a line to every report with the bytes returned by the callback */
+  void AddSource (std::string name, Callback<uint64_t> bytes);
+
+  /** Schedule the periodic reports */
+  void Start ();
+
+  /** Write one report now */
+  void WriteReport ();
+
+  /** Resident set size of this process in bytes (0 if /proc is not available) */
+  static uint64_t GetResidentBytes ();
+  /** Peak resident set size of this process in bytes (0 if /proc is not available) */
+  static uint64_t GetPeakResidentBytes ();
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void Periodic ();
+  void CountObject (Ptr<const Object> object);
+
+  Time m_interval; /**< Time between two reports (0: only on WriteReport) */
+  std::string m_fileName; /**< Output file (empty: standard output) */
+
+  std::ofstream m_file;
+  EventId m_event; /**< Next periodic report */
+  std::vector<std::pair<std::string, Callback<uint64_t>>> m_sources; /**< Extra byte counters */
+  std::map<std::string, uint32_t> m_objects; /**< Live objects by type, refilled per report */
+};
+} // namespace ns3
+#endif
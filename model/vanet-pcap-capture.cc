@@ -0,0 +1,275 @@
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/simulator.h"
+#include "ns3/mobility-model.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/node-container.h"
+#include "vanet-pcap-capture.h"
+#include "custom-data-tag.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("vanet-pcap-capture");
+NS_OBJECT_ENSURE_REGISTERED (VanetPcapCapture);
+
+namespace {
+
+#pragma pack(push, 1)
+struct PcapFileHeader
+{
+  uint32_t magic;
+  uint16_t versionMajor;
+  uint16_t versionMinor;
+  int32_t thisZone;
+  uint32_t sigFigs;
+  uint32_t snapLen;
+  uint32_t network;
+};
+
+struct PcapRecordHeader
+{
+  uint32_t tsSec;
+  uint32_t tsUsec;
+  uint32_t inclLen;
+  uint32_t origLen;
+};
+#pragma pack(pop)
+
+const uint32_t PCAP_MAGIC = 0xa1b2c3d4;
+const uint32_t DLT_IEEE802_11 = 105;
+
+} // namespace
+
+TypeId
+VanetPcapCapture::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::VanetPcapCapture")
+          .SetParent<Object> ()
+          .AddConstructor<VanetPcapCapture> ()
+          .AddAttribute ("Prefix", "Output files are Prefix-NNNN.pcap",
+                         StringValue ("contrib/vanetsim/results/capture"),
+                         MakeStringAccessor (&VanetPcapCapture::m_prefix), MakeStringChecker ())
+          .AddAttribute ("SnapLen", "Bytes kept per frame", UintegerValue (128),
+                         MakeUintegerAccessor (&VanetPcapCapture::m_snapLen),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("MessageTypes", "Bitmask of captured messages: 1 hello, 2 DHCP, 4 others",
+                         UintegerValue (HELLO | DHCP | OTHER),
+                         MakeUintegerAccessor (&VanetPcapCapture::m_messageTypes),
+                         MakeUintegerChecker<uint32_t> (1, 7))
+          .AddAttribute ("Direction", "Capture transmitted frames, received frames or both",
+                         EnumValue (VanetPcapCapture::TX),
+                         MakeEnumAccessor (&VanetPcapCapture::m_direction),
+                         MakeEnumChecker (VanetPcapCapture::TX, "Tx", VanetPcapCapture::RX, "Rx",
+                                          VanetPcapCapture::BOTH, "Both"))
+          .AddAttribute ("MaxFileSize", "Rotate after this many bytes (0: never)",
+                         UintegerValue (100 << 20),
+                         MakeUintegerAccessor (&VanetPcapCapture::m_maxFileSize),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("RotationInterval", "Rotate after this simulation time (0: never)",
+                         TimeValue (Seconds (0)),
+                         MakeTimeAccessor (&VanetPcapCapture::m_rotationInterval),
+                         MakeTimeChecker ())
+          .AddAttribute ("MaxFiles", "Rotated files kept, oldest are removed (0: keep all)",
+                         UintegerValue (0), MakeUintegerAccessor (&VanetPcapCapture::m_maxFiles),
+                         MakeUintegerChecker<uint32_t> ())
+          .AddAttribute ("BufferSize", "Bytes handed to the writer thread at once",
+                         UintegerValue (1 << 20),
+                         MakeUintegerAccessor (&VanetPcapCapture::m_bufferSize),
+                         MakeUintegerChecker<uint32_t> (1));
+  return tid;
+}
+
+TypeId
+VanetPcapCapture::GetInstanceTypeId () const
+{
+  return VanetPcapCapture::GetTypeId ();
+}
+
+VanetPcapCapture::VanetPcapCapture () : m_fileIndex (0), m_fileSize (0), m_framesCaptured (0)
+{
+}
+
+VanetPcapCapture::~VanetPcapCapture ()
+{
+}
+
+void
+VanetPcapCapture::DoDispose ()
+{
+  Close ();
+  Object::DoDispose ();
+}
+
+void
+VanetPcapCapture::AddArea (Vector center, double radius)
+{
+  Area area;
+  area.center = center;
+  area.radius = radius;
+  m_areas.push_back (area);
+}
+
+void
+VanetPcapCapture::AddRsuArea (Ptr<Node> rsu, double radius)
+{
+  AddArea (rsu->GetObject<MobilityModel> ()->GetPosition (), radius);
+}
+
+void
+VanetPcapCapture::Install (NodeContainer nodes)
+{
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    Install (*i);
+}
+
+void
+VanetPcapCapture::Install (Ptr<Node> node)
+{
+  if (!m_writer.IsOpen ())
+    Open ();
+  if (!m_nodes.insert (node->GetId ()).second)
+    return;
+
+  for (uint32_t i = 0; i < node->GetNDevices (); i++)
+    {
+      Ptr<WifiNetDevice> dev = DynamicCast<WifiNetDevice> (node->GetDevice (i));
+      if (!dev)
+        continue;
+
+      Ptr<WifiPhy> phy = dev->GetPhy ();
+      if (m_direction & TX)
+        phy->TraceConnectWithoutContext (
+            "MonitorSnifferTx", MakeBoundCallback (&VanetPcapCapture::SnifferTx, this, node));
+      if (m_direction & RX)
+        phy->TraceConnectWithoutContext (
+            "MonitorSnifferRx", MakeBoundCallback (&VanetPcapCapture::SnifferRx, this, node));
+    }
+}
+
+std::string
+VanetPcapCapture::GetFileName (uint32_t index) const
+{
+  char suffix[16];
+  std::snprintf (suffix, sizeof (suffix), "-%04u.pcap", index);
+  return m_prefix + suffix;
+}
+
+void
+VanetPcapCapture::Open ()
+{
+  NS_LOG_FUNCTION (this << m_prefix);
+
+  m_fileIndex = 0;
+  m_writer.Open (GetFileName (m_fileIndex), m_bufferSize, 8, m_maxFiles);
+  m_fileStart = Simulator::Now ();
+  m_fileSize = 0;
+
+  PcapFileHeader header = {PCAP_MAGIC, 2, 4, 0, 0, m_snapLen, DLT_IEEE802_11};
+  m_writer.Append (&header, sizeof (header));
+  m_fileSize += sizeof (header);
+
+  Simulator::ScheduleDestroy (&VanetPcapCapture::Close, this);
+}
+
+void
+VanetPcapCapture::RotateFile ()
+{
+  m_fileIndex++;
+  m_writer.Rotate (GetFileName (m_fileIndex));
+  m_fileStart = Simulator::Now ();
+  m_fileSize = 0;
+
+  PcapFileHeader header = {PCAP_MAGIC, 2, 4, 0, 0, m_snapLen, DLT_IEEE802_11};
+  m_writer.Append (&header, sizeof (header));
+  m_fileSize += sizeof (header);
+}
+
+void
+VanetPcapCapture::Capture (Ptr<Node> node, Ptr<const Packet> packet)
+{
+  if (!m_writer.IsOpen ())
+    return;
+
+  // message type filter
+  uint32_t type = OTHER;
+  CustomDataTag tag;
+  if (packet->PeekPacketTag (tag))
+    type = tag.isHelloMessage () ? HELLO : tag.isDhcpMessage () ? DHCP : OTHER;
+  if (!(type & m_messageTypes))
+    return;
+
+  // area filter
+  if (!m_areas.empty ())
+    {
+      Vector pos = node->GetObject<MobilityModel> ()->GetPosition ();
+      bool inside = false;
+      for (auto const &a : m_areas)
+        {
+          double dx = pos.x - a.center.x;
+          double dy = pos.y - a.center.y;
+          if (dx * dx + dy * dy <= a.radius * a.radius)
+            {
+              inside = true;
+              break;
+            }
+        }
+      if (!inside)
+        return;
+    }
+
+  Time now = Simulator::Now ();
+  if ((m_maxFileSize && m_fileSize >= m_maxFileSize) ||
+      (m_rotationInterval.IsStrictlyPositive () && now - m_fileStart >= m_rotationInterval))
+    RotateFile ();
+
+  uint32_t origLen = packet->GetSize ();
+  uint32_t inclLen = std::min (origLen, m_snapLen);
+  int64_t us = now.GetMicroSeconds ();
+  PcapRecordHeader record = {(uint32_t) (us / 1000000), (uint32_t) (us % 1000000), inclLen,
+                             origLen};
+
+  m_frame.resize (inclLen);
+  packet->CopyData (m_frame.data (), inclLen);
+  m_writer.Append (&record, sizeof (record));
+  m_writer.Append (m_frame.data (), inclLen);
+  m_fileSize += sizeof (record) + inclLen;
+  m_framesCaptured++;
+}
+
+void
+VanetPcapCapture::SnifferTx (VanetPcapCapture *capture, Ptr<Node> node, Ptr<const Packet> packet,
+                             uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu)
+{
+  capture->Capture (node, packet);
+}
+
+void
+VanetPcapCapture::SnifferRx (VanetPcapCapture *capture, Ptr<Node> node, Ptr<const Packet> packet,
+                             uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu,
+                             SignalNoiseDbm sn)
+{
+  capture->Capture (node, packet);
+}
+
+void
+VanetPcapCapture::Close ()
+{
+  if (!m_writer.IsOpen ())
+    return;
+  m_writer.Close ();
+  NS_LOG_INFO ("pcap capture " << m_prefix << ": " << m_framesCaptured << " frames in "
+                               << m_fileIndex + 1 << " files");
+}
+
+uint64_t
+VanetPcapCapture::GetFramesCaptured () const
+{
+  return m_framesCaptured;
+}
+
+} // namespace ns3
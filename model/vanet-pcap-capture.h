@@ -0,0 +1,93 @@
+#ifndef VANET_PCAP_CAPTURE_H
+#define VANET_PCAP_CAPTURE_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/node.h"
+#include "ns3/vector.h"
+#include "ns3/wifi-phy.h"
+#include "async-file-writer.h"
+#include <set>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Filtered 802.11 pcap capture (DLT_IEEE802_11).
+ *
+ * Unlike YansWifiPhyHelper::EnablePcap, which writes one file per device,
+ * all selected nodes go to a single capture stream:
+ *  - only the nodes passed to Install, optionally only while they are inside
+ *    one of the areas added with AddArea / AddRsuArea
+ *  - only the message types in MessageTypes (hello, DHCP, others)
+ *  - frames truncated to SnapLen bytes
+ *  - transmitted frames by default, so every frame is captured once
+ *
+ * The file is rotated to Prefix-NNNN.pcap after MaxFileSize bytes or
+ * RotationInterval, keeping at most MaxFiles files, and written by an
+ * AsyncFileWriter so disk I/O does not stall the simulation thread.
+ */
+class VanetPcapCapture : public ns3::Object
+{
+public:
+  enum MessageType { HELLO = 0x01, DHCP = 0x02, OTHER = 0x04 };
+  enum Direction { TX = 0x01, RX = 0x02, BOTH = 0x03 };
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  VanetPcapCapture ();
+  ~VanetPcapCapture ();
+
+  /** Only capture frames of nodes inside this circle (x, y) */
+  void AddArea (Vector center, double radius);
+  /** Only capture frames of nodes within radius of this RSU */
+  void AddRsuArea (Ptr<Node> rsu, double radius);
+
+  /** Capture the wifi devices of these nodes */
+  void Install (NodeContainer nodes);
+  void Install (Ptr<Node> node);
+
+  void Close ();
+
+  uint64_t GetFramesCaptured () const;
+
+private:
+  struct Area
+  {
+    Vector center;
+    double radius;
+  };
+
+  virtual void DoDispose (void);
+
+  void Open ();
+  void Capture (Ptr<Node> node, Ptr<const Packet> packet);
+  void RotateFile ();
+  std::string GetFileName (uint32_t index) const;
+
+  static void SnifferTx (VanetPcapCapture *capture, Ptr<Node> node, Ptr<const Packet> packet,
+                         uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu);
+  static void SnifferRx (VanetPcapCapture *capture, Ptr<Node> node, Ptr<const Packet> packet,
+                         uint16_t channelFreq, WifiTxVector tx, MpduInfo mpdu, SignalNoiseDbm sn);
+
+  std::string m_prefix; /**< Output file prefix */
+  uint32_t m_snapLen; /**< Bytes kept per frame */
+  uint32_t m_messageTypes; /**< MessageType bitmask */
+  Direction m_direction; /**< Frames captured */
+  uint64_t m_maxFileSize; /**< Rotate after this many bytes (0: never) */
+  Time m_rotationInterval; /**< Rotate after this time (0: never) */
+  uint32_t m_maxFiles; /**< Files kept (0: all) */
+  uint32_t m_bufferSize; /**< Bytes handed to the writer thread at once */
+
+  std::vector<Area> m_areas; /**< Capture areas (empty: everywhere) */
+  std::set<uint32_t> m_nodes; /**< Nodes already installed */
+
+  AsyncFileWriter m_writer; /**< Background file output */
+  std::vector<uint8_t> m_frame; /**< Truncated frame being written */
+  uint32_t m_fileIndex; /**< Current file number */
+  uint64_t m_fileSize; /**< Bytes in the current file */
+  Time m_fileStart; /**< Time the current file was opened */
+  uint64_t m_framesCaptured; /**< Frames written */
+};
+} // namespace ns3
+#endif
@@ -0,0 +1,176 @@
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+#include "ns3/object-factory.h"
+#include "vanet-progress.h"
+
+#include <iomanip>
+#include <iostream>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("vanet-progress");
+NS_OBJECT_ENSURE_REGISTERED (CountingMapScheduler);
+NS_OBJECT_ENSURE_REGISTERED (VanetProgress);
+
+uint64_t CountingMapScheduler::s_pending = 0;
+
+TypeId
+CountingMapScheduler::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::CountingMapScheduler")
+                          .SetParent<MapScheduler> ()
+                          .AddConstructor<CountingMapScheduler> ();
+  return tid;
+}
+
+CountingMapScheduler::CountingMapScheduler ()
+{
+}
+
+CountingMapScheduler::~CountingMapScheduler ()
+{
+}
+
+void
+CountingMapScheduler::Insert (const Event &ev)
+{
+  MapScheduler::Insert (ev);
+  s_pending++;
+}
+
+Scheduler::Event
+CountingMapScheduler::RemoveNext ()
+{
+  s_pending--;
+  return MapScheduler::RemoveNext ();
+}
+
+void
+CountingMapScheduler::Remove (const Event &ev)
+{
+  MapScheduler::Remove (ev);
+  s_pending--;
+}
+
+uint64_t
+CountingMapScheduler::GetPendingEvents ()
+{
+  return s_pending;
+}
+
+TypeId
+VanetProgress::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::VanetProgress")
+          .SetParent<Object> ()
+          .AddConstructor<VanetProgress> ()
+          .AddAttribute ("WallInterval", "Wall-clock time between two progress lines",
+                         TimeValue (Seconds (10)),
+                         MakeTimeAccessor (&VanetProgress::m_wallInterval), MakeTimeChecker ())
+          .AddAttribute ("CheckInterval", "Simulation time between two wall-clock checks",
+                         TimeValue (MilliSeconds (100)),
+                         MakeTimeAccessor (&VanetProgress::m_checkInterval), MakeTimeChecker ())
+          .AddAttribute ("CountPendingEvents",
+                         "Replace the scheduler by a CountingMapScheduler to report pending events",
+                         BooleanValue (true),
+                         MakeBooleanAccessor (&VanetProgress::m_countPending),
+                         MakeBooleanChecker ());
+  return tid;
+}
+
+TypeId
+VanetProgress::GetInstanceTypeId () const
+{
+  return VanetProgress::GetTypeId ();
+}
+
+VanetProgress::VanetProgress ()
+    : m_os (&std::cout), m_activeVehicles (0), m_lastEvents (0)
+{
+}
+
+VanetProgress::~VanetProgress ()
+{
+}
+
+void
+VanetProgress::SetStream (std::ostream *os)
+{
+  m_os = os;
+}
+
+void
+VanetProgress::NotifyVehicleAdded ()
+{
+  m_activeVehicles++;
+}
+
+void
+VanetProgress::NotifyVehicleRemoved ()
+{
+  if (m_activeVehicles)
+    m_activeVehicles--;
+}
+
+void
+VanetProgress::SetSumoClient (Ptr<VanetSumoClient> client)
+{
+  m_sumoClient = client;
+}
+
+void
+VanetProgress::Start ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_countPending)
+    Simulator::SetScheduler (ObjectFactory ("ns3::CountingMapScheduler"));
+
+  m_wallStart = Clock::now ();
+  m_lastWall = m_wallStart;
+  m_lastSumoWait = m_sumoClient ? m_sumoClient->GetSumoWaitTime () : Seconds (0);
+  m_lastEvents = Simulator::GetEventCount ();
+  m_lastSim = Simulator::Now ();
+  m_checkEvent = Simulator::Schedule (m_checkInterval, &VanetProgress::Check, this);
+}
+
+void
+VanetProgress::Check ()
+{
+  Clock::time_point now = Clock::now ();
+  if (now - m_lastWall >= std::chrono::nanoseconds (m_wallInterval.GetNanoSeconds ()))
+    Report (now);
+  m_checkEvent = Simulator::Schedule (m_checkInterval, &VanetProgress::Check, this);
+}
+
+void
+VanetProgress::Report (Clock::time_point now)
+{
+  double wall = std::chrono::duration<double> (now - m_lastWall).count ();
+  uint64_t events = Simulator::GetEventCount () - m_lastEvents;
+  double sim = (Simulator::Now () - m_lastSim).GetSeconds ();
+
+  *m_os << std::fixed << std::setprecision (1) << "[progress] wall="
+        << std::chrono::duration<double> (now - m_wallStart).count ()
+        << "s sim=" << Simulator::Now ().GetSeconds () << "s events/s=" << std::setprecision (0)
+        << events / wall << " sim/wall=" << std::setprecision (2) << sim / wall
+        << " vehicles=" << m_activeVehicles;
+  if (m_countPending)
+    *m_os << " pending=" << CountingMapScheduler::GetPendingEvents ();
+  if (m_sumoClient)
+    {
+      Time sumoWait = m_sumoClient->GetSumoWaitTime ();
+      double share = std::min (1.0, (sumoWait - m_lastSumoWait).GetSeconds () / wall);
+      *m_os << std::setprecision (0) << " ns3=" << 100 * (1 - share) << "% sumo-wait="
+            << 100 * share << "%";
+      m_lastSumoWait = sumoWait;
+    }
+  *m_os << std::endl;
+
+  m_lastWall = now;
+  m_lastEvents += events;
+  m_lastSim = Simulator::Now ();
+}
+
+} // namespace ns3
@@ -0,0 +1,86 @@
+#ifndef VANET_PROGRESS_H
+#define VANET_PROGRESS_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/map-scheduler.h"
+#include "vanet-sumo-client.h"
+#include <chrono>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * MapScheduler that also counts the events waiting to run.
+ * Installed by VanetProgress with Simulator::SetScheduler.
+ */
+class CountingMapScheduler : public MapScheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  CountingMapScheduler ();
+  ~CountingMapScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+  static uint64_t GetPendingEvents ();
+
+private:
+  static uint64_t s_pending; /**< Events in the (single) simulator queue */
+};
+
+/**
+ * Periodic progress line for long runs, paced by wall-clock time.
+ *
+ * Every CheckInterval of simulation time a cheap event looks at the wall
+ * clock; once WallInterval has passed it prints the simulation time, events
+ * per second, the sim-time / wall-time ratio, active vehicles, pending
+ * events and, with a SUMO client set, the share of the wall time the
+ * simulation thread spent waiting for SUMO.
+ */
+class VanetProgress : public ns3::Object
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  VanetProgress ();
+  ~VanetProgress ();
+
+  /** Start reporting; call before Simulator::Run */
+  void Start ();
+
+  /** Call from the SUMO node setup / shutdown callbacks */
+  void NotifyVehicleAdded ();
+  void NotifyVehicleRemoved ();
+
+  void SetStream (std::ostream *os);
+  /** Report the time spent waiting for this client's SUMO steps */
+  void SetSumoClient (Ptr<VanetSumoClient> client);
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  void Check ();
+  void Report (Clock::time_point now);
+
+  Time m_wallInterval; /**< Wall-clock time between two reports */
+  Time m_checkInterval; /**< Simulation time between two wall-clock checks */
+  bool m_countPending; /**< Install CountingMapScheduler */
+
+  std::ostream *m_os; /**< Report stream */
+  Ptr<VanetSumoClient> m_sumoClient; /**< Source of the SUMO wait time (optional) */
+  EventId m_checkEvent; /**< Next wall-clock check */
+  uint32_t m_activeVehicles; /**< Vehicles currently in SUMO */
+
+  Clock::time_point m_wallStart;
+  Clock::time_point m_lastWall; /**< Wall time of the last report */
+  Time m_lastSumoWait; /**< SUMO wait time at the last report */
+  uint64_t m_lastEvents; /**< Events executed at the last report */
+  Time m_lastSim; /**< Simulation time of the last report */
+};
+} // namespace ns3
+#endif
@@ -0,0 +1,740 @@
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/integer.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "vanet-sumo-client.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("vanet-sumo-client");
+NS_OBJECT_ENSURE_REGISTERED (VanetSumoClient);
+
+TypeId
+VanetSumoClient::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::VanetSumoClient")
+          .SetParent<Object> ()
+          .AddConstructor<VanetSumoClient> ()
+          .AddAttribute ("SumoConfigPath", "SUMO configuration file", StringValue (""),
+                         MakeStringAccessor (&VanetSumoClient::m_sumoConfigPath),
+                         MakeStringChecker ())
+          .AddAttribute ("SumoBinaryPath", "Directory of the SUMO binaries (empty: use PATH)",
+                         StringValue (""), MakeStringAccessor (&VanetSumoClient::m_sumoBinaryPath),
+                         MakeStringChecker ())
+          .AddAttribute ("SynchInterval", "Time between two synchronizations with SUMO",
+                         TimeValue (Seconds (0.1)),
+                         MakeTimeAccessor (&VanetSumoClient::m_synchInterval), MakeTimeChecker ())
+          .AddAttribute ("StartTime", "SUMO time at ns-3 time 0", TimeValue (Seconds (0)),
+                         MakeTimeAccessor (&VanetSumoClient::m_startTime), MakeTimeChecker ())
+          .AddAttribute ("SumoGUI", "Run sumo-gui instead of sumo", BooleanValue (false),
+                         MakeBooleanAccessor (&VanetSumoClient::m_sumoGui), MakeBooleanChecker ())
+          .AddAttribute ("SumoPort", "TraCI port", UintegerValue (3400),
+                         MakeUintegerAccessor (&VanetSumoClient::m_sumoPort),
+                         MakeUintegerChecker<uint16_t> ())
+          .AddAttribute ("PenetrationRate", "Share of SUMO vehicles that get an ns-3 node",
+                         DoubleValue (1.0), MakeDoubleAccessor (&VanetSumoClient::m_penetrationRate),
+                         MakeDoubleChecker<double> (0, 1))
+          .AddAttribute ("SumoLogFile", "Write the SUMO log to sumo-log.txt", BooleanValue (false),
+                         MakeBooleanAccessor (&VanetSumoClient::m_sumoLogFile),
+                         MakeBooleanChecker ())
+          .AddAttribute ("SumoStepLog", "Print the SUMO step log", BooleanValue (false),
+                         MakeBooleanAccessor (&VanetSumoClient::m_sumoStepLog),
+                         MakeBooleanChecker ())
+          .AddAttribute ("SumoSeed", "SUMO random seed", IntegerValue (0),
+                         MakeIntegerAccessor (&VanetSumoClient::m_sumoSeed),
+                         MakeIntegerChecker<int> ())
+          .AddAttribute ("SumoAdditionalCmdOptions", "Options appended to the SUMO command line",
+                         StringValue (""),
+                         MakeStringAccessor (&VanetSumoClient::m_sumoAdditionalCmdOptions),
+                         MakeStringChecker ())
+          .AddAttribute ("SumoWaitForSocket", "Time allowed for SUMO to open the TraCI socket",
+                         TimeValue (Seconds (1.0)),
+                         MakeTimeAccessor (&VanetSumoClient::m_sumoWaitForSocket),
+                         MakeTimeChecker ())
+          .AddAttribute ("Backend", "How SUMO is reached", EnumValue (VanetSumoClient::TRACI),
+                         MakeEnumAccessor (&VanetSumoClient::m_backendType),
+                         MakeEnumChecker (VanetSumoClient::TRACI, "TraCI",
+                                          VanetSumoClient::LIBSUMO, "libsumo"))
+          .AddAttribute ("Pipelined", "Step SUMO ahead on a helper thread", BooleanValue (false),
+                         MakeBooleanAccessor (&VanetSumoClient::m_pipelined),
+                         MakeBooleanChecker ())
+          .AddAttribute ("PipelineDepth", "Steps the helper thread may compute ahead",
+                         UintegerValue (1),
+                         MakeUintegerAccessor (&VanetSumoClient::m_pipelineDepth),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("SaveStateFile", "Save the SUMO state into this file at SaveStateTime",
+                         StringValue (""), MakeStringAccessor (&VanetSumoClient::m_saveStateFile),
+                         MakeStringChecker ())
+          .AddAttribute ("SaveStateTime", "SUMO time at which the state is saved",
+                         TimeValue (Seconds (0)),
+                         MakeTimeAccessor (&VanetSumoClient::m_saveStateTime), MakeTimeChecker ())
+          .AddAttribute ("LoadStateFile",
+                         "Start SUMO from this saved state (StartTime 0: use the state time)",
+                         StringValue (""), MakeStringAccessor (&VanetSumoClient::m_loadStateFile),
+                         MakeStringChecker ())
+          .AddAttribute ("AdaptiveSynch", "Widen the interval while vehicles are predictable",
+                         BooleanValue (false), MakeBooleanAccessor (&VanetSumoClient::m_adaptive),
+                         MakeBooleanChecker ())
+          .AddAttribute ("MaxSynchInterval", "Upper bound of the adaptive interval",
+                         TimeValue (Seconds (1)),
+                         MakeTimeAccessor (&VanetSumoClient::m_maxSynchInterval),
+                         MakeTimeChecker ())
+          .AddAttribute ("MaxAcceleration", "Vehicles accelerating more are not predictable (m/s^2)",
+                         DoubleValue (0.5), MakeDoubleAccessor (&VanetSumoClient::m_maxAcceleration),
+                         MakeDoubleChecker<double> (0))
+          .AddAttribute ("MaxTurnRate", "Vehicles turning faster are not predictable (degrees/s)",
+                         DoubleValue (5), MakeDoubleAccessor (&VanetSumoClient::m_maxTurnRate),
+                         MakeDoubleChecker<double> (0))
+          .AddAttribute ("PositionErrorBound",
+                         "Dead-reckoning error that resets the interval to SynchInterval (m)",
+                         DoubleValue (1.0),
+                         MakeDoubleAccessor (&VanetSumoClient::m_positionErrorBound),
+                         MakeDoubleChecker<double> (0))
+          .AddAttribute ("TrackStops", "Report vehicles reaching or leaving a stop",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&VanetSumoClient::m_trackStops),
+                         MakeBooleanChecker ())
+          .AddAttribute ("Synchronizations", "Number of synchronizations with SUMO",
+                         TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&VanetSumoClient::m_syncs),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("CommandsPosted", "Commands posted by applications", TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&VanetSumoClient::m_commandsPosted),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("CommandsSent", "Commands sent to SUMO after coalescing",
+                         TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&VanetSumoClient::m_commandsSent),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("PositionErrors", "Vehicles found beyond PositionErrorBound",
+                         TypeId::ATTR_GET, UintegerValue (0),
+                         MakeUintegerAccessor (&VanetSumoClient::m_positionErrors),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddTraceSource ("VehicleStopped", "A vehicle reached or left a stop or parking area",
+                           MakeTraceSourceAccessor (&VanetSumoClient::m_stopTrace),
+                           "ns3::VanetSumoClient::StopTracedCallback");
+  return tid;
+}
+
+TypeId
+VanetSumoClient::GetInstanceTypeId () const
+{
+  return VanetSumoClient::GetTypeId ();
+}
+
+VanetSumoClient::VanetSumoClient ()
+    : m_lastStepTime (0),
+      m_nextSteps (1),
+      m_commandsPosted (0),
+      m_commandsSent (0),
+      m_syncs (0),
+      m_positionErrors (0),
+      m_maxPositionError (0),
+      m_waitTime (std::chrono::steady_clock::duration::zero ()),
+      m_stop (false),
+      m_failed (false),
+      m_commandsFailed (0)
+{
+}
+
+VanetSumoClient::~VanetSumoClient ()
+{
+  Stop ();
+}
+
+void
+VanetSumoClient::DoDispose ()
+{
+  Stop ();
+  m_includeNode = nullptr;
+  m_excludeNode = nullptr;
+  m_vehicles.clear ();
+  m_vehicleIds.clear ();
+  Object::DoDispose ();
+}
+
+void
+VanetSumoClient::Stop ()
+{
+  m_syncEvent.Cancel ();
+  m_stop = true;
+  NotifyQueues ();
+  if (m_thread.joinable ())
+    m_thread.join ();
+  if (m_backend)
+    {
+      m_backend->Close ();
+      m_backend = 0;
+    }
+}
+
+std::vector<std::string>
+VanetSumoClient::GetCommandLine () const
+{
+  std::vector<std::string> args;
+  std::string binary = m_sumoGui ? "sumo-gui" : "sumo";
+  args.push_back (m_sumoBinaryPath.empty () ? binary : m_sumoBinaryPath + "/" + binary);
+  args.push_back ("-c");
+  args.push_back (m_sumoConfigPath);
+  // libsumo runs SUMO in this process: with a port SUMO would wait for a TraCI client
+  if (m_backendType == TRACI)
+    {
+      args.push_back ("--remote-port");
+      args.push_back (std::to_string (m_sumoPort));
+    }
+  args.push_back ("--step-length");
+  args.push_back (std::to_string (m_synchInterval.GetSeconds ()));
+  args.push_back ("--seed");
+  args.push_back (std::to_string (m_sumoSeed));
+  if (m_sumoLogFile)
+    {
+      args.push_back ("--log");
+      args.push_back ("sumo-log.txt");
+    }
+  if (!m_sumoStepLog)
+    args.push_back ("--no-step-log");
+  if (!m_saveStateFile.empty ())
+    {
+      args.push_back ("--save-state.times");
+      args.push_back (std::to_string (m_saveStateTime.GetSeconds ()));
+      args.push_back ("--save-state.files");
+      args.push_back (m_saveStateFile);
+    }
+  if (!m_loadStateFile.empty ())
+    {
+      args.push_back ("--load-state");
+      args.push_back (m_loadStateFile);
+      args.push_back ("--begin");
+      args.push_back (std::to_string (m_startTime.GetSeconds ()));
+    }
+  if (m_sumoGui)
+    {
+      args.push_back ("--start");
+      args.push_back ("--quit-on-end");
+    }
+
+  std::istringstream extra (m_sumoAdditionalCmdOptions);
+  std::string option;
+  while (extra >> option)
+    args.push_back (option);
+  return args;
+}
+
+double
+VanetSumoClient::GetStateTime (std::string fileName)
+{
+  // <snapshot xmlns:xsi=... time="300.00" version="1.1.0">
+  std::ifstream file (fileName.c_str ());
+  std::string line;
+  while (std::getline (file, line))
+    {
+      size_t snapshot = line.find ("<snapshot");
+      if (snapshot == std::string::npos)
+        continue;
+      size_t time = line.find (" time=\"", snapshot);
+      if (time == std::string::npos)
+        return -1;
+      size_t end = line.find ('"', time + 7);
+      if (end == std::string::npos)
+        return -1;
+      return ParseSumoTime (line.substr (time + 7, end - time - 7));
+    }
+  return -1;
+}
+
+double
+VanetSumoClient::ParseSumoTime (const std::string &text)
+{
+  // seconds, or with --human-readable-time HH:MM:SS[.ss] and D:HH:MM:SS[.ss]
+  std::vector<double> fields;
+  std::istringstream in (text);
+  std::string field;
+  while (std::getline (in, field, ':'))
+    {
+      char *end;
+      double value = std::strtod (field.c_str (), &end);
+      if (field.empty () || *end != '\0' || value < 0)
+        return -1;
+      fields.push_back (value);
+    }
+  if (fields.size () == 1)
+    return fields[0];
+  if (fields.size () < 3 || fields.size () > 4)
+    return -1;
+  static const double units[] = {86400, 3600, 60, 1};
+  double seconds = 0;
+  for (size_t i = 0; i < fields.size (); i++)
+    seconds += fields[i] * units[4 - fields.size () + i];
+  return seconds;
+}
+
+bool
+VanetSumoClient::IsEquipped (const std::string &vehicleId) const
+{
+  if (m_penetrationRate >= 1)
+    return true;
+
+  // FNV-1a of the id: the same vehicles are equipped in every run and on every thread
+  uint32_t hash = 2166136261u ^ (uint32_t) m_sumoSeed;
+  for (char c : vehicleId)
+    hash = (hash ^ (uint8_t) c) * 16777619u;
+  return hash % 10000 < m_penetrationRate * 10000;
+}
+
+void
+VanetSumoClient::SumoSetup (std::function<Ptr<Node> ()> includeNode,
+                            std::function<void (Ptr<Node>)> excludeNode)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_includeNode = includeNode;
+  m_excludeNode = excludeNode;
+
+  if (!m_loadStateFile.empty () && m_startTime.IsZero ())
+    {
+      double stateTime = GetStateTime (m_loadStateFile);
+      NS_ABORT_MSG_IF (stateTime < 0, "Can't read the time of " << m_loadStateFile
+                                                                 << ", set StartTime");
+      m_startTime = Seconds (stateTime);
+    }
+
+  if (m_backendType == LIBSUMO)
+    {
+      NS_ABORT_MSG_IF (!LibsumoBackend::IsAvailable (),
+                       "vanetsim was configured without --with-libsumo");
+      NS_ABORT_MSG_IF (m_sumoGui, "libsumo has no GUI");
+      m_backend = Create<LibsumoBackend> ();
+    }
+  else
+    m_backend = Create<TraciSumoBackend> (m_sumoPort, m_sumoWaitForSocket.GetSeconds ());
+  m_backend->Start (GetCommandLine ());
+  m_backend->Subscribe (m_adaptive, m_trackStops);
+
+  // vehicles already in SUMO at StartTime exist at ns-3 time 0
+  if (m_startTime.IsStrictlyPositive ())
+    {
+      SumoStep step;
+      m_lastStepTime = m_startTime.GetSeconds ();
+      RunStep (m_startTime.GetSeconds (), step, m_loadStateFile.empty ());
+      Apply (step);
+      NS_LOG_INFO (step.departed.size () << " vehicles in SUMO at " << m_startTime.GetSeconds ()
+                                         << " s");
+    }
+
+  if (m_pipelined)
+    {
+      m_stop = false;
+      m_steps.reset (new SpscQueue<SumoStep> (m_pipelineDepth));
+      m_batches.reset (new SpscQueue<std::vector<SumoCommand>> (m_pipelineDepth + 1));
+      m_thread = std::thread (&VanetSumoClient::PipelineLoop, this,
+                              (m_startTime + m_synchInterval).GetSeconds ());
+    }
+
+  m_syncEvent = Simulator::Schedule (m_synchInterval, &VanetSumoClient::SyncStep, this);
+  Simulator::ScheduleDestroy (&VanetSumoClient::Stop, this);
+}
+
+void
+VanetSumoClient::RunStep (double time, SumoStep &step, bool advance)
+{
+  // equipped vehicles that entered and left the network since the last synchronization
+  std::set<std::string> came, gone;
+  if (advance)
+    {
+      // one SUMO step at a time: the departed and arrived ids are those of the last step only
+      double interval = m_synchInterval.GetSeconds ();
+      int64_t steps = std::max<int64_t> (1, std::llround ((time - m_lastStepTime) / interval));
+      for (int64_t k = steps - 1; k >= 0; k--)
+        {
+          std::vector<std::string> departed, arrived;
+          m_backend->SimulationStep (time - k * interval);
+          m_backend->GetFlows (departed, arrived);
+          for (const auto &id : departed)
+            if (IsEquipped (id))
+              came.insert (id);
+          for (const auto &id : arrived)
+            if (IsEquipped (id))
+              gone.insert (id);
+        }
+    }
+  step.time = time;
+  step.maxError = 0;
+  step.errors = 0;
+  step.departed.clear ();
+  step.arrived.clear ();
+  step.vehicles.clear ();
+
+  // one exchange: the subscribed states of every vehicle came with the step
+  m_backend->GetVehicles (step.vehicles);
+  step.vehicles.erase (std::remove_if (step.vehicles.begin (), step.vehicles.end (),
+                                       [this] (const SumoVehicleState &state) {
+                                         return !IsEquipped (state.id);
+                                       }),
+                       step.vehicles.end ());
+  std::set<std::string> present;
+  for (const auto &state : step.vehicles)
+    present.insert (state.id);
+
+  for (auto it = m_tracked.begin (); it != m_tracked.end ();)
+    if (!present.count (it->first))
+      {
+        step.arrived.push_back (it->first);
+        it = m_tracked.erase (it);
+      }
+    else
+      ++it;
+
+  // no widening while vehicles come and go
+  bool predictable = step.arrived.empty () && came.empty () && gone.empty ();
+  double dt = time - m_lastStepTime;
+  for (const auto &state : step.vehicles)
+    {
+      const std::string &id = state.id;
+      auto it = m_tracked.find (id);
+      if (it == m_tracked.end ())
+        {
+          step.departed.push_back (id);
+          predictable = false;
+          m_tracked[id] = state;
+        }
+      else
+        {
+          if (!IsPredictable (state, it->second, dt, step))
+            predictable = false;
+          it->second = state;
+        }
+    }
+  // in and out within a widened interval: still a node, included and excluded at once
+  for (const auto &id : came)
+    if (gone.count (id) && !present.count (id) && !m_tracked.count (id))
+      {
+        step.departed.push_back (id);
+        step.arrived.push_back (id);
+      }
+
+  uint32_t maxSteps = std::max<int64_t> (1, m_maxSynchInterval.GetTimeStep () /
+                                                m_synchInterval.GetTimeStep ());
+  if (m_adaptive && predictable)
+    m_nextSteps = std::min (2 * m_nextSteps, maxSteps);
+  else
+    m_nextSteps = 1;
+  step.nextSteps = m_nextSteps;
+  m_lastStepTime = time;
+}
+
+bool
+VanetSumoClient::IsPredictable (const SumoVehicleState &state, const SumoVehicleState &last,
+                                double dt, SumoStep &step) const
+{
+  // where a constant velocity model left the vehicle
+  double heading = last.angle * M_PI / 180;
+  double dx = state.x - (last.x + last.speed * std::sin (heading) * dt);
+  double dy = state.y - (last.y + last.speed * std::cos (heading) * dt);
+  double error = std::sqrt (dx * dx + dy * dy);
+  step.maxError = std::max (step.maxError, error);
+  if (error > m_positionErrorBound)
+    {
+      step.errors++;
+      return false;
+    }
+  if (!m_adaptive)
+    return true;
+
+  double turn = std::fmod (state.angle - last.angle + 540, 360) - 180;
+  return !state.onJunction && std::abs (state.acceleration) <= m_maxAcceleration &&
+         std::abs (turn) <= m_maxTurnRate * dt;
+}
+
+void
+VanetSumoClient::PipelineLoop (double time)
+{
+  SumoStep step;
+  std::vector<SumoCommand> batch;
+  try
+    {
+      while (!m_stop)
+        {
+          bool popped = false;
+          while (m_batches->Pop (batch))
+            {
+              ApplyCommands (batch);
+              popped = true;
+            }
+          if (popped)
+            NotifyQueues ();
+          RunStep (time, step);
+          uint32_t nextSteps = step.nextSteps;
+          while (!m_steps->Push (step))
+            {
+              std::unique_lock<std::mutex> lock (m_queueMutex);
+              m_queueChanged.wait (lock, [this] { return m_stop || !m_steps->IsFull (); });
+              if (m_stop)
+                return;
+            }
+          NotifyQueues ();
+          time += nextSteps * m_synchInterval.GetSeconds ();
+        }
+    }
+  catch (std::exception &e)
+    {
+      std::lock_guard<std::mutex> lock (m_errorMutex);
+      m_error = e.what ();
+      m_failed = true;
+    }
+  NotifyQueues ();
+}
+
+void
+VanetSumoClient::NotifyQueues ()
+{
+  // under the mutex, so a waiter can't miss it between its check and its wait
+  std::lock_guard<std::mutex> lock (m_queueMutex);
+  m_queueChanged.notify_all ();
+}
+
+void
+VanetSumoClient::ApplyCommands (const std::vector<SumoCommand> &commands)
+{
+  for (const auto &c : commands)
+    {
+      try
+        {
+          m_backend->Apply (c);
+        }
+      catch (std::exception &e)
+        {
+          m_commandsFailed++;
+        }
+    }
+}
+
+void
+VanetSumoClient::SyncStep ()
+{
+  SumoStep step;
+  FlushCommands ();
+  auto start = std::chrono::steady_clock::now ();
+  if (m_pipelined)
+    {
+      while (!m_steps->Pop (step))
+        {
+          {
+            std::unique_lock<std::mutex> lock (m_queueMutex);
+            m_queueChanged.wait (lock, [this] { return m_failed || !m_steps->IsEmpty (); });
+          }
+          if (m_failed && m_steps->IsEmpty ())
+            {
+              std::lock_guard<std::mutex> lock (m_errorMutex);
+              NS_FATAL_ERROR ("SUMO pipeline failed: " << m_error);
+            }
+        }
+      NotifyQueues ();
+    }
+  else
+    RunStep ((Simulator::Now () + m_startTime).GetSeconds (), step);
+  m_waitTime += std::chrono::steady_clock::now () - start;
+
+  Apply (step);
+  m_syncEvent = Simulator::Schedule (TimeStep (m_synchInterval.GetTimeStep () * step.nextSteps),
+                                     &VanetSumoClient::SyncStep, this);
+}
+
+void
+VanetSumoClient::Apply (const SumoStep &step)
+{
+  m_syncs++;
+  m_positionErrors += step.errors;
+  m_maxPositionError = std::max (m_maxPositionError, step.maxError);
+
+  for (const auto &id : step.departed)
+    {
+      Ptr<Node> node = m_includeNode ();
+      m_vehicles[id] = node;
+      m_vehicleIds[node->GetId ()] = id;
+      NS_LOG_INFO ("Vehicle " << id << " departed as node " << node->GetId ());
+    }
+
+  for (const auto &v : step.vehicles)
+    {
+      auto it = m_vehicles.find (v.id);
+      if (it == m_vehicles.end ())
+        continue;
+      it->second->GetObject<MobilityModel> ()->SetPosition (Vector (v.x, v.y, v.z));
+      Ptr<ConstantVelocityMobilityModel> cv =
+          it->second->GetObject<ConstantVelocityMobilityModel> ();
+      if (cv)
+        {
+          double heading = v.angle * M_PI / 180;
+          cv->SetVelocity (Vector (v.speed * std::sin (heading), v.speed * std::cos (heading), 0));
+        }
+
+      bool stopped = v.stopState & 1;
+      if (stopped != (m_stopped.count (v.id) > 0))
+        {
+          if (stopped)
+            m_stopped.insert (v.id);
+          else
+            m_stopped.erase (v.id);
+          NS_LOG_INFO ("Vehicle " << v.id << (stopped ? " stopped" : " resumed"));
+          m_stopTrace (it->second, stopped);
+        }
+    }
+
+  for (const auto &id : step.arrived)
+    {
+      auto it = m_vehicles.find (id);
+      if (it == m_vehicles.end ())
+        continue;
+      NS_LOG_INFO ("Vehicle " << id << " arrived, node " << it->second->GetId ());
+      Ptr<ConstantVelocityMobilityModel> cv =
+          it->second->GetObject<ConstantVelocityMobilityModel> ();
+      if (cv)
+        cv->SetVelocity (Vector (0, 0, 0));
+      // a node back in the pool must not stay suspended
+      if (m_stopped.erase (id))
+        m_stopTrace (it->second, false);
+      m_excludeNode (it->second);
+      m_vehicleIds.erase (it->second->GetId ());
+      m_vehicles.erase (it);
+    }
+}
+
+std::string
+VanetSumoClient::GetVehicleId (Ptr<Node> node) const
+{
+  auto it = m_vehicleIds.find (node->GetId ());
+  return it == m_vehicleIds.end () ? "" : it->second;
+}
+
+void
+VanetSumoClient::Post (const SumoCommand &command)
+{
+  m_commandsPosted++;
+  // stops on different edges are different stops, the others replace each other
+  CommandKey key (command.vehicleId, command.type,
+                  command.type == SumoCommand::SET_STOP ? command.edge : "");
+  auto it = m_commandIndex.find (key);
+  if (it != m_commandIndex.end ())
+    m_commands.erase (it->second);
+  m_commandIndex[key] = m_commands.insert (m_commands.end (), command);
+}
+
+void
+VanetSumoClient::PostFor (Ptr<Node> vehicle, SumoCommand &command)
+{
+  command.vehicleId = GetVehicleId (vehicle);
+  if (command.vehicleId.empty ())
+    {
+      NS_LOG_WARN ("Node " << vehicle->GetId () << " is not a SUMO vehicle");
+      return;
+    }
+  Post (command);
+}
+
+void
+VanetSumoClient::SetSpeed (Ptr<Node> vehicle, double speed)
+{
+  SumoCommand c = {"", SumoCommand::SET_SPEED, speed, 0, "", 0};
+  PostFor (vehicle, c);
+}
+
+void
+VanetSumoClient::SlowDown (Ptr<Node> vehicle, double speed, Time duration)
+{
+  SumoCommand c = {"", SumoCommand::SLOW_DOWN, speed, duration.GetSeconds (), "", 0};
+  PostFor (vehicle, c);
+}
+
+void
+VanetSumoClient::ChangeTarget (Ptr<Node> vehicle, std::string edge)
+{
+  SumoCommand c = {"", SumoCommand::CHANGE_TARGET, 0, 0, edge, 0};
+  PostFor (vehicle, c);
+}
+
+void
+VanetSumoClient::SetStop (Ptr<Node> vehicle, std::string edge, double position, int lane,
+                          Time duration)
+{
+  SumoCommand c = {"", SumoCommand::SET_STOP, position, duration.GetSeconds (), edge, lane};
+  PostFor (vehicle, c);
+}
+
+void
+VanetSumoClient::Resume (Ptr<Node> vehicle)
+{
+  SumoCommand c = {"", SumoCommand::RESUME, 0, 0, "", 0};
+  PostFor (vehicle, c);
+}
+
+void
+VanetSumoClient::FlushCommands ()
+{
+  if (m_commands.empty ())
+    return;
+
+  std::vector<SumoCommand> batch (m_commands.begin (), m_commands.end ());
+  m_commandsSent += batch.size ();
+  if (m_pipelined)
+    {
+      while (!m_batches->Push (batch))
+        {
+          std::unique_lock<std::mutex> lock (m_queueMutex);
+          m_queueChanged.wait (lock, [this] { return m_failed || !m_batches->IsFull (); });
+          if (m_failed)
+            {
+              std::lock_guard<std::mutex> errorLock (m_errorMutex);
+              NS_FATAL_ERROR ("SUMO pipeline failed: " << m_error);
+            }
+        }
+      NotifyQueues ();
+    }
+  else
+    {
+      ApplyCommands (batch);
+      if (m_commandsFailed)
+        NS_LOG_WARN (m_commandsFailed << " commands rejected by SUMO so far");
+    }
+  m_commands.clear ();
+  m_commandIndex.clear ();
+}
+
+uint64_t
+VanetSumoClient::GetFailedCommands () const
+{
+  return m_commandsFailed;
+}
+
+Ptr<Node>
+VanetSumoClient::GetVehicleNode (std::string vehicleId) const
+{
+  auto it = m_vehicles.find (vehicleId);
+  return it == m_vehicles.end () ? 0 : it->second;
+}
+
+double
+VanetSumoClient::GetMaxPositionError () const
+{
+  return m_maxPositionError;
+}
+
+Time
+VanetSumoClient::GetSumoWaitTime () const
+{
+  return NanoSeconds (std::chrono::duration_cast<std::chrono::nanoseconds> (m_waitTime).count ());
+}
+
+} // namespace ns3
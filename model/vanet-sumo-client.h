@@ -0,0 +1,209 @@
+#ifndef VANET_SUMO_CLIENT_H
+#define VANET_SUMO_CLIENT_H
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/node.h"
+#include "ns3/traced-callback.h"
+#include "sumo-backend.h"
+#include "spsc-queue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
+
+namespace ns3 {
+
+/**
+ * SUMO coupling with the same attributes and SumoSetup contract as
+ * TraciClient, so it can replace it in the examples.
+ *
+ * Every SynchInterval the tracked vehicles (a PenetrationRate share of the
+ * departures) are created through the include callback, moved, and handed
+ * to the exclude callback when they arrive. ns-3 time t is SUMO time
+ * StartTime + t.
+ *
+ * In lock-step mode SUMO is stepped from the simulation thread. With
+ * Pipelined, a helper thread owns the SUMO connection and computes up to
+ * PipelineDepth steps ahead; results go through a lock-free SPSC queue and
+ * are applied at their own simulation time, so SUMO computes the next step
+ * while ns-3 processes the events of the current interval. A thread that
+ * finds its queue full or empty sleeps on a condition variable.
+ *
+ * With AdaptiveSynch the interval grows (doubling, up to MaxSynchInterval)
+ * while every tracked vehicle is predictable: no departure or arrival, low
+ * acceleration and turn rate, not on a junction, and the position
+ * extrapolated from the previous speed and heading within
+ * PositionErrorBound of SUMO's. Otherwise it falls back to SynchInterval.
+ * SUMO still advances one SynchInterval per exchange, reporting the ids
+ * that departed and arrived, so a vehicle entering and leaving within a
+ * widened interval ends it and still gets its node and exclude callback.
+ * Nodes with a ConstantVelocityMobilityModel get the SUMO velocity at each
+ * synchronization, so positions are dead-reckoned in between.
+ *
+ * Warm start: a warm-up run saves the SUMO state at SaveStateTime into
+ * SaveStateFile; later runs start from it with LoadStateFile. The vehicles
+ * of the snapshot get their nodes at ns-3 time 0, and StartTime defaults
+ * to the snapshot time, so applications keep their ns-3 start times.
+ *
+ * Applications change vehicles with Post or the SetSpeed, SlowDown,
+ * ChangeTarget, SetStop and Resume shortcuts. Commands are queued and sent
+ * in one batch at the next synchronization; a command replaces a queued
+ * command of the same type for the same vehicle (for SetStop, on the same
+ * edge) and takes its place at the end of the batch, so the batch keeps the
+ * posting order. With Pipelined the batch is applied by the helper thread
+ * before the next step it computes; that thread is already PipelineDepth
+ * steps ahead, so commands take effect PipelineDepth + 1 intervals later
+ * than in lock-step.
+ *
+ * With TrackStops the SUMO stop state of the tracked vehicles is read at
+ * every synchronization and VehicleStopped fires when a vehicle reaches or
+ * leaves a stop or parking area (and, if stopped, when it arrives), so
+ * applications can put parked vehicles into a low-activity mode.
+ *
+ * Backend selects how SUMO is reached: a separate process over the TraCI
+ * socket, or libsumo linked into this process (configure --with-libsumo).
+ * Either way the vehicle variables come from a single context subscription
+ * covering the network, so each SynchInterval of SUMO time is one exchange.
+ */
+class VanetSumoClient : public ns3::Object
+{
+public:
+  enum Backend { TRACI, LIBSUMO };
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  VanetSumoClient ();
+  ~VanetSumoClient ();
+
+  /** Start SUMO and the synchronization, before Simulator::Run */
+  void SumoSetup (std::function<Ptr<Node> ()> includeNode,
+                  std::function<void (Ptr<Node>)> excludeNode);
+
+  /** SUMO id of a vehicle node (empty if the node is not a vehicle) */
+  std::string GetVehicleId (Ptr<Node> node) const;
+  /** Node of a SUMO vehicle (0 if not tracked) */
+  Ptr<Node> GetVehicleNode (std::string vehicleId) const;
+
+  /** Queue a command for the next synchronization */
+  void Post (const SumoCommand &command);
+  void SetSpeed (Ptr<Node> vehicle, double speed);
+  void SlowDown (Ptr<Node> vehicle, double speed, Time duration);
+  void ChangeTarget (Ptr<Node> vehicle, std::string edge);
+  void SetStop (Ptr<Node> vehicle, std::string edge, double position, int lane, Time duration);
+  void Resume (Ptr<Node> vehicle);
+
+  /** Commands rejected by SUMO, e.g. for a vehicle that has just arrived */
+  uint64_t GetFailedCommands () const;
+
+  /** Largest dead-reckoning error seen at a synchronization (m) */
+  double GetMaxPositionError () const;
+
+  /** Wall-clock time the simulation thread spent waiting for SUMO */
+  Time GetSumoWaitTime () const;
+
+  /**
+   * TracedCallback signature for stop state changes.
+   *
+   * \param [in] vehicle Node of the vehicle.
+   * \param [in] stopped True if the vehicle reached a stop or parking area.
+   */
+  typedef void (*StopTracedCallback) (Ptr<Node> vehicle, bool stopped);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  std::vector<std::string> GetCommandLine () const;
+  /** Time of a plain XML SUMO state file (negative if not found) */
+  static double GetStateTime (std::string fileName);
+  /** Seconds of a SUMO time, plain or human-readable (negative if malformed) */
+  static double ParseSumoTime (const std::string &text);
+  bool IsEquipped (const std::string &vehicleId) const;
+  void Stop ();
+
+  /* called by the thread owning the backend */
+  void RunStep (double time, SumoStep &step, bool advance = true);
+  bool IsPredictable (const SumoVehicleState &state, const SumoVehicleState &last, double dt,
+                      SumoStep &step) const;
+  void PipelineLoop (double time);
+  void ApplyCommands (const std::vector<SumoCommand> &commands);
+  /** Wake the other thread after a push, a pop, a stop or a failure */
+  void NotifyQueues ();
+
+  /* simulation thread */
+  void SyncStep ();
+  void Apply (const SumoStep &step);
+  void FlushCommands ();
+  void PostFor (Ptr<Node> vehicle, SumoCommand &command);
+
+  std::string m_sumoConfigPath; /**< sumocfg file */
+  std::string m_sumoBinaryPath; /**< Directory of the SUMO binaries (empty: PATH) */
+  Time m_synchInterval; /**< Time between two synchronizations */
+  Time m_startTime; /**< SUMO time at ns-3 time 0 */
+  bool m_sumoGui; /**< Run sumo-gui */
+  uint16_t m_sumoPort; /**< TraCI port */
+  double m_penetrationRate; /**< Share of vehicles equipped with a node */
+  bool m_sumoLogFile; /**< Write sumo-log.txt */
+  bool m_sumoStepLog; /**< SUMO step log on the console */
+  int m_sumoSeed; /**< SUMO random seed */
+  std::string m_sumoAdditionalCmdOptions; /**< Appended to the SUMO command line */
+  Time m_sumoWaitForSocket; /**< Time allowed for SUMO to open the TraCI socket */
+  Backend m_backendType; /**< TraCI socket or in-process libsumo */
+  bool m_pipelined; /**< Step SUMO ahead on a helper thread */
+  uint32_t m_pipelineDepth; /**< Steps the helper thread may run ahead */
+  std::string m_saveStateFile; /**< SUMO state written at SaveStateTime */
+  Time m_saveStateTime; /**< SUMO time of the saved state */
+  std::string m_loadStateFile; /**< SUMO state to start from */
+  bool m_adaptive; /**< Widen the interval while vehicles are predictable */
+  Time m_maxSynchInterval; /**< Upper bound of the adaptive interval */
+  double m_maxAcceleration; /**< Predictable below this acceleration (m/s^2) */
+  double m_maxTurnRate; /**< Predictable below this heading change (degrees/s) */
+  double m_positionErrorBound; /**< Allowed dead-reckoning error (m) */
+  bool m_trackStops; /**< Read the stop state of the tracked vehicles */
+
+  Ptr<SumoBackend> m_backend;
+  std::map<std::string, SumoVehicleState> m_tracked; /**< Equipped vehicles in SUMO, backend side */
+  double m_lastStepTime; /**< SUMO time of the previous step, backend side */
+  uint32_t m_nextSteps; /**< Current interval in SynchIntervals, backend side */
+
+  std::function<Ptr<Node> ()> m_includeNode;
+  std::function<void (Ptr<Node>)> m_excludeNode;
+  std::map<std::string, Ptr<Node>> m_vehicles; /**< Nodes of the tracked vehicles */
+  std::map<uint32_t, std::string> m_vehicleIds; /**< Vehicle ids by node id */
+  std::set<std::string> m_stopped; /**< Tracked vehicles at a stop */
+  /** Vehicle, type and, for SET_STOP, edge of the commands that replace each other */
+  typedef std::tuple<std::string, int, std::string> CommandKey;
+  std::list<SumoCommand> m_commands; /**< Commands waiting for the next synchronization */
+  std::map<CommandKey, std::list<SumoCommand>::iterator> m_commandIndex; /**< In m_commands */
+  uint64_t m_commandsPosted; /**< Commands posted by applications */
+  uint64_t m_commandsSent; /**< Commands sent to SUMO after coalescing */
+  EventId m_syncEvent; /**< Next synchronization */
+  uint64_t m_syncs; /**< Synchronizations done */
+  uint64_t m_positionErrors; /**< Vehicles found beyond PositionErrorBound */
+  double m_maxPositionError; /**< Largest dead-reckoning error (m) */
+  std::chrono::steady_clock::duration m_waitTime; /**< Simulation thread waiting for SUMO */
+
+  std::thread m_thread; /**< Pipeline thread */
+  std::unique_ptr<SpscQueue<SumoStep>> m_steps; /**< Steps computed ahead by the pipeline thread */
+  std::unique_ptr<SpscQueue<std::vector<SumoCommand>>> m_batches; /**< Commands for the pipeline thread */
+  std::mutex m_queueMutex; /**< Guards the waits on the two queues */
+  std::condition_variable m_queueChanged; /**< A queue was pushed or popped */
+  std::atomic<bool> m_stop;
+  std::atomic<bool> m_failed;
+  std::atomic<uint64_t> m_commandsFailed; /**< Commands rejected by SUMO */
+  std::mutex m_errorMutex;
+  std::string m_error; /**< Exception caught by the pipeline thread */
+
+  TracedCallback<Ptr<Node>, bool> m_stopTrace; /**< Vehicle stopped or resumed */
+};
+} // namespace ns3
+#endif
@@ -0,0 +1,591 @@
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/pointer.h"
+#include "ns3/ipv4.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-mac-queue.h"
+#include "vanet-traffic-app.h"
+#include "beacon-search-net.h"
+
+namespace ns3 {
+NS_LOG_COMPONENT_DEFINE ("vanet-traffic-app");
+NS_OBJECT_ENSURE_REGISTERED (VanetTrafficTag);
+NS_OBJECT_ENSURE_REGISTERED (VanetTrafficClient);
+NS_OBJECT_ENSURE_REGISTERED (VanetTrafficServer);
+
+TypeId
+VanetTrafficTag::GetTypeId (void)
+{
+  static TypeId tid =
+      TypeId ("ns3::VanetTrafficTag").SetParent<Tag> ().AddConstructor<VanetTrafficTag> ();
+  return tid;
+}
+
+TypeId
+VanetTrafficTag::GetInstanceTypeId (void) const
+{
+  return VanetTrafficTag::GetTypeId ();
+}
+
+VanetTrafficTag::VanetTrafficTag ()
+    : m_vehicleId (0), m_seq (0), m_txTime (0), m_direction (UPLINK), m_register (0)
+{
+}
+
+uint32_t
+VanetTrafficTag::GetSerializedSize (void) const
+{
+  return sizeof (uint32_t) + sizeof (uint32_t) + sizeof (int64_t) + sizeof (uint8_t) +
+         sizeof (uint8_t);
+}
+
+void
+VanetTrafficTag::Serialize (TagBuffer i) const
+{
+  i.WriteU32 (m_vehicleId);
+  i.WriteU32 (m_seq);
+  i.WriteU64 (m_txTime);
+  i.WriteU8 (m_direction);
+  i.WriteU8 (m_register);
+}
+
+void
+VanetTrafficTag::Deserialize (TagBuffer i)
+{
+  m_vehicleId = i.ReadU32 ();
+  m_seq = i.ReadU32 ();
+  m_txTime = i.ReadU64 ();
+  m_direction = i.ReadU8 ();
+  m_register = i.ReadU8 ();
+}
+
+void
+VanetTrafficTag::Print (std::ostream &os) const
+{
+  os << "vehicle=" << m_vehicleId << " seq=" << m_seq << " tx=" << GetTxTime ()
+     << (m_direction == UPLINK ? " up" : " down") << (m_register ? " register" : "");
+}
+
+uint32_t
+VanetTrafficTag::GetVehicleId () const
+{
+  return m_vehicleId;
+}
+
+uint32_t
+VanetTrafficTag::GetSeq () const
+{
+  return m_seq;
+}
+
+Time
+VanetTrafficTag::GetTxTime () const
+{
+  return TimeStep (m_txTime);
+}
+
+VanetTrafficTag::Direction
+VanetTrafficTag::GetDirection () const
+{
+  return (Direction) m_direction;
+}
+
+bool
+VanetTrafficTag::IsRegister () const
+{
+  return m_register;
+}
+
+void
+VanetTrafficTag::SetVehicleId (uint32_t vehicleId)
+{
+  m_vehicleId = vehicleId;
+}
+
+void
+VanetTrafficTag::SetSeq (uint32_t seq)
+{
+  m_seq = seq;
+}
+
+void
+VanetTrafficTag::SetTxTime (Time t)
+{
+  m_txTime = t.GetTimeStep ();
+}
+
+void
+VanetTrafficTag::SetDirection (Direction direction)
+{
+  m_direction = direction;
+}
+
+void
+VanetTrafficTag::SetRegister (bool reg)
+{
+  m_register = reg;
+}
+
+TypeId
+VanetTrafficClient::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::VanetTrafficClient")
+          .SetParent<Application> ()
+          .AddConstructor<VanetTrafficClient> ()
+          .AddAttribute ("Remote", "Address of the VanetTrafficServer",
+                         Ipv4AddressValue (),
+                         MakeIpv4AddressAccessor (&VanetTrafficClient::m_remote),
+                         MakeIpv4AddressChecker ())
+          .AddAttribute ("Port", "Port of the VanetTrafficServer", UintegerValue (9000),
+                         MakeUintegerAccessor (&VanetTrafficClient::m_port),
+                         MakeUintegerChecker<uint16_t> ())
+          .AddAttribute ("Protocol", "Uplink transport", EnumValue (VanetTrafficClient::UDP),
+                         MakeEnumAccessor (&VanetTrafficClient::m_protocol),
+                         MakeEnumChecker (VanetTrafficClient::UDP, "Udp",
+                                          VanetTrafficClient::TCP, "Tcp"))
+          .AddAttribute ("Mode", "Uplink at DataRate (Cbr) or as fast as possible (Bulk)",
+                         EnumValue (VanetTrafficClient::CBR),
+                         MakeEnumAccessor (&VanetTrafficClient::m_mode),
+                         MakeEnumChecker (VanetTrafficClient::CBR, "Cbr",
+                                          VanetTrafficClient::BULK, "Bulk"))
+          .AddAttribute ("DataRate", "Uplink rate in Cbr mode", DataRateValue (DataRate ("64kbps")),
+                         MakeDataRateAccessor (&VanetTrafficClient::m_rate),
+                         MakeDataRateChecker ())
+          .AddAttribute ("PacketSize", "Payload bytes per packet", UintegerValue (512),
+                         MakeUintegerAccessor (&VanetTrafficClient::m_packetSize),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("BulkBacklog", "Bulk over UDP: packets kept in the wifi queue",
+                         UintegerValue (4),
+                         MakeUintegerAccessor (&VanetTrafficClient::m_bulkBacklog),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("KeepAlive", "Interval of the address registrations with the server",
+                         TimeValue (Seconds (1)),
+                         MakeTimeAccessor (&VanetTrafficClient::m_keepAlive), MakeTimeChecker ())
+          .AddTraceSource ("Tx", "Uplink data sent",
+                           MakeTraceSourceAccessor (&VanetTrafficClient::m_txTrace),
+                           "ns3::VanetTrafficClient::TrafficTracedCallback")
+          .AddTraceSource ("Rx", "Downlink data received",
+                           MakeTraceSourceAccessor (&VanetTrafficClient::m_rxTrace),
+                           "ns3::VanetTrafficClient::TrafficTracedCallback")
+          .AddTraceSource ("Detach", "The vehicle stopped sending",
+                           MakeTraceSourceAccessor (&VanetTrafficClient::m_detachTrace),
+                           "ns3::VanetTrafficClient::DetachTracedCallback");
+  return tid;
+}
+
+TypeId
+VanetTrafficClient::GetInstanceTypeId () const
+{
+  return VanetTrafficClient::GetTypeId ();
+}
+
+VanetTrafficClient::VanetTrafficClient ()
+    : m_port (9000),
+      m_protocol (UDP),
+      m_mode (CBR),
+      m_packetSize (512),
+      m_bulkBacklog (4),
+      m_attached (false),
+      m_tcpConnected (false),
+      m_seq (0)
+{
+}
+
+VanetTrafficClient::~VanetTrafficClient ()
+{
+}
+
+void
+VanetTrafficClient::DoDispose ()
+{
+  m_udp = 0;
+  m_tcp = 0;
+  m_txop = 0;
+  Application::DoDispose ();
+}
+
+void
+VanetTrafficClient::StartApplication ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_udp = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
+  m_udp->Bind (); // any address: follows the address changes
+  m_udp->SetRecvCallback (MakeCallback (&VanetTrafficClient::HandleRead, this));
+
+  for (uint32_t i = 0; i < GetNode ()->GetNDevices (); i++)
+    {
+      Ptr<WifiNetDevice> dev = DynamicCast<WifiNetDevice> (GetNode ()->GetDevice (i));
+      PointerValue ptr;
+      if (dev && dev->GetMac ()->GetAttributeFailSafe ("Txop", ptr))
+        {
+          m_txop = ptr.Get<Txop> ();
+          break;
+        }
+    }
+
+  Ptr<BeaconSearchNet> search;
+  for (uint32_t i = 0; i < GetNode ()->GetNApplications () && !search; i++)
+    search = DynamicCast<BeaconSearchNet> (GetNode ()->GetApplication (i));
+  if (search)
+    search->TraceConnectWithoutContext ("DhcpOfferRx",
+                                        MakeCallback (&VanetTrafficClient::NotifyOffer, this));
+  else
+    Attach (); // fixed address
+}
+
+void
+VanetTrafficClient::StopApplication ()
+{
+  NS_LOG_FUNCTION (this);
+  m_attached = false;
+  m_sendEvent.Cancel ();
+  m_registerEvent.Cancel ();
+  CloseTcp ();
+  if (m_udp)
+    m_udp->Close ();
+}
+
+void
+VanetTrafficClient::Detach ()
+{
+  if (!m_attached)
+    return;
+  m_attached = false;
+  m_sendEvent.Cancel ();
+  m_registerEvent.Cancel ();
+  CloseTcp ();
+  m_detachTrace (GetNode ()->GetId ());
+}
+
+void
+VanetTrafficClient::NotifyOffer (uint32_t rsuId, Ipv4Address addr)
+{
+  // the address is swapped right after the trace
+  Simulator::ScheduleNow (&VanetTrafficClient::Attach, this);
+}
+
+void
+VanetTrafficClient::Attach ()
+{
+  NS_LOG_FUNCTION (this);
+  m_attached = true;
+  Register ();
+
+  if (m_protocol == TCP)
+    {
+      // the connection is bound to the previous address
+      CloseTcp ();
+      ConnectTcp ();
+    }
+  if (m_protocol == UDP || m_mode == CBR)
+    {
+      m_sendEvent.Cancel ();
+      m_sendEvent = Simulator::ScheduleNow (&VanetTrafficClient::SendPacket, this);
+    }
+}
+
+void
+VanetTrafficClient::Register ()
+{
+  Ptr<Packet> packet = Create<Packet> (16);
+  VanetTrafficTag tag;
+  tag.SetVehicleId (GetNode ()->GetId ());
+  tag.SetTxTime (Now ());
+  tag.SetRegister (true);
+  packet->AddPacketTag (tag);
+  m_udp->SendTo (packet, 0, InetSocketAddress (m_remote, m_port));
+
+  m_registerEvent.Cancel ();
+  m_registerEvent = Simulator::Schedule (m_keepAlive, &VanetTrafficClient::Register, this);
+}
+
+Ptr<Packet>
+VanetTrafficClient::CreateData ()
+{
+  Ptr<Packet> packet = Create<Packet> (m_packetSize);
+  VanetTrafficTag tag;
+  tag.SetVehicleId (GetNode ()->GetId ());
+  tag.SetSeq (m_seq++);
+  tag.SetTxTime (Now ());
+  tag.SetDirection (VanetTrafficTag::UPLINK);
+  if (m_protocol == TCP)
+    packet->AddByteTag (tag); // packet tags do not survive the byte stream
+  else
+    packet->AddPacketTag (tag);
+  m_txTrace (tag, m_packetSize);
+  return packet;
+}
+
+void
+VanetTrafficClient::SendPacket ()
+{
+  if (!m_attached)
+    return;
+
+  if (m_protocol == TCP)
+    {
+      // Cbr over TCP: offered at DataRate, limited by the send buffer
+      if (m_tcpConnected && m_tcp->GetTxAvailable () >= m_packetSize)
+        m_tcp->Send (CreateData ());
+      m_sendEvent = Simulator::Schedule (m_rate.CalculateBytesTxTime (m_packetSize),
+                                         &VanetTrafficClient::SendPacket, this);
+      return;
+    }
+
+  if (m_mode == CBR)
+    {
+      // sent even without a route: counted as lost
+      m_udp->SendTo (CreateData (), 0, InetSocketAddress (m_remote, m_port));
+      m_sendEvent = Simulator::Schedule (m_rate.CalculateBytesTxTime (m_packetSize),
+                                         &VanetTrafficClient::SendPacket, this);
+      return;
+    }
+
+  // Bulk: keep the wifi queue busy without flooding it
+  for (uint32_t backlog = GetBacklog (); backlog < m_bulkBacklog; backlog++)
+    m_udp->SendTo (CreateData (), 0, InetSocketAddress (m_remote, m_port));
+  m_sendEvent = Simulator::Schedule (MilliSeconds (1), &VanetTrafficClient::SendPacket, this);
+}
+
+uint32_t
+VanetTrafficClient::GetBacklog () const
+{
+  return m_txop ? m_txop->GetWifiMacQueue ()->GetNPackets () : 0;
+}
+
+void
+VanetTrafficClient::ConnectTcp ()
+{
+  m_tcp = Socket::CreateSocket (GetNode (), TcpSocketFactory::GetTypeId ());
+  m_tcp->Bind ();
+  m_tcp->SetConnectCallback (MakeCallback (&VanetTrafficClient::TcpConnected, this),
+                             MakeCallback (&VanetTrafficClient::TcpFailed, this));
+  if (m_mode == BULK)
+    m_tcp->SetSendCallback (MakeCallback (&VanetTrafficClient::SendTcp, this));
+  m_tcp->Connect (InetSocketAddress (m_remote, m_port));
+}
+
+void
+VanetTrafficClient::CloseTcp ()
+{
+  m_connectEvent.Cancel ();
+  m_tcpConnected = false;
+  if (!m_tcp)
+    return;
+  m_tcp->SetConnectCallback (MakeNullCallback<void, Ptr<Socket>> (),
+                             MakeNullCallback<void, Ptr<Socket>> ());
+  m_tcp->SetSendCallback (MakeNullCallback<void, Ptr<Socket>, uint32_t> ());
+  m_tcp->Close ();
+  m_tcp = 0;
+}
+
+void
+VanetTrafficClient::TcpConnected (Ptr<Socket> socket)
+{
+  NS_LOG_INFO ("vehicle-id=" << GetNode ()->GetId () << " TCP uplink connected");
+  m_tcpConnected = true;
+  if (m_mode == BULK)
+    SendTcp (socket, socket->GetTxAvailable ());
+}
+
+void
+VanetTrafficClient::TcpFailed (Ptr<Socket> socket)
+{
+  NS_LOG_INFO ("vehicle-id=" << GetNode ()->GetId () << " TCP uplink failed");
+  if (m_attached && socket == m_tcp)
+    {
+      CloseTcp ();
+      m_connectEvent = Simulator::Schedule (m_keepAlive, &VanetTrafficClient::ConnectTcp, this);
+    }
+}
+
+void
+VanetTrafficClient::SendTcp (Ptr<Socket> socket, uint32_t available)
+{
+  while (m_attached && m_tcpConnected && socket->GetTxAvailable () >= m_packetSize)
+    if (socket->Send (CreateData ()) < 0)
+      break;
+}
+
+void
+VanetTrafficClient::HandleRead (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  Address from;
+  while ((packet = socket->RecvFrom (from)))
+    {
+      VanetTrafficTag tag;
+      if (packet->PeekPacketTag (tag))
+        m_rxTrace (tag, packet->GetSize ());
+    }
+}
+
+TypeId
+VanetTrafficServer::GetTypeId ()
+{
+  static TypeId tid =
+      TypeId ("ns3::VanetTrafficServer")
+          .SetParent<Application> ()
+          .AddConstructor<VanetTrafficServer> ()
+          .AddAttribute ("Port", "Listening port (UDP and TCP)", UintegerValue (9000),
+                         MakeUintegerAccessor (&VanetTrafficServer::m_port),
+                         MakeUintegerChecker<uint16_t> ())
+          .AddAttribute ("DownlinkRate", "UDP downlink rate per registered vehicle (0: none)",
+                         DataRateValue (DataRate ("64kbps")),
+                         MakeDataRateAccessor (&VanetTrafficServer::m_downlinkRate),
+                         MakeDataRateChecker ())
+          .AddAttribute ("PacketSize", "Downlink payload bytes per packet", UintegerValue (512),
+                         MakeUintegerAccessor (&VanetTrafficServer::m_packetSize),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("Timeout", "Stop the downlink of a vehicle silent for this long",
+                         TimeValue (Seconds (3)),
+                         MakeTimeAccessor (&VanetTrafficServer::m_timeout), MakeTimeChecker ())
+          .AddTraceSource ("Tx", "Downlink data sent",
+                           MakeTraceSourceAccessor (&VanetTrafficServer::m_txTrace),
+                           "ns3::VanetTrafficClient::TrafficTracedCallback")
+          .AddTraceSource ("Rx", "Uplink data received",
+                           MakeTraceSourceAccessor (&VanetTrafficServer::m_rxTrace),
+                           "ns3::VanetTrafficClient::TrafficTracedCallback");
+  return tid;
+}
+
+TypeId
+VanetTrafficServer::GetInstanceTypeId () const
+{
+  return VanetTrafficServer::GetTypeId ();
+}
+
+VanetTrafficServer::VanetTrafficServer () : m_port (9000), m_packetSize (512)
+{
+}
+
+VanetTrafficServer::~VanetTrafficServer ()
+{
+}
+
+void
+VanetTrafficServer::DoDispose ()
+{
+  m_udp = 0;
+  m_tcp = 0;
+  m_accepted.clear ();
+  m_clients.clear ();
+  Application::DoDispose ();
+}
+
+void
+VanetTrafficServer::StartApplication ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_udp = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
+  m_udp->Bind (InetSocketAddress (Ipv4Address::GetAny (), m_port));
+  m_udp->SetRecvCallback (MakeCallback (&VanetTrafficServer::HandleUdp, this));
+
+  m_tcp = Socket::CreateSocket (GetNode (), TcpSocketFactory::GetTypeId ());
+  m_tcp->Bind (InetSocketAddress (Ipv4Address::GetAny (), m_port));
+  m_tcp->Listen ();
+  m_tcp->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                            MakeCallback (&VanetTrafficServer::HandleAccept, this));
+}
+
+void
+VanetTrafficServer::StopApplication ()
+{
+  NS_LOG_FUNCTION (this);
+  for (auto &c : m_clients)
+    c.second.sendEvent.Cancel ();
+  for (Ptr<Socket> s : m_accepted)
+    s->Close ();
+  m_accepted.clear ();
+  if (m_tcp)
+    m_tcp->Close ();
+  if (m_udp)
+    m_udp->Close ();
+}
+
+void
+VanetTrafficServer::HandleUdp (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  Address from;
+  while ((packet = socket->RecvFrom (from)))
+    {
+      VanetTrafficTag tag;
+      if (!packet->PeekPacketTag (tag))
+        continue;
+
+      // the last address heard from a vehicle is where its downlink goes
+      Client &c = m_clients[tag.GetVehicleId ()];
+      c.address = from;
+      c.lastSeen = Now ();
+      if (!tag.IsRegister ())
+        m_rxTrace (tag, packet->GetSize ());
+      else if (m_downlinkRate.GetBitRate () > 0 && !c.sendEvent.IsRunning ())
+        c.sendEvent = Simulator::ScheduleNow (&VanetTrafficServer::SendDownlink, this,
+                                              tag.GetVehicleId ());
+    }
+}
+
+void
+VanetTrafficServer::HandleAccept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&VanetTrafficServer::HandleTcp, this));
+  m_accepted.push_back (socket);
+}
+
+void
+VanetTrafficServer::HandleTcp (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  Address from;
+  while ((packet = socket->RecvFrom (from)))
+    {
+      // a segment can carry parts of several packets written by the vehicle
+      ByteTagIterator it = packet->GetByteTagIterator ();
+      while (it.HasNext ())
+        {
+          ByteTagIterator::Item item = it.Next ();
+          if (item.GetTypeId () != VanetTrafficTag::GetTypeId ())
+            continue;
+          VanetTrafficTag tag;
+          item.GetTag (tag);
+          m_clients[tag.GetVehicleId ()].lastSeen = Now ();
+          m_rxTrace (tag, item.GetEnd () - item.GetStart ());
+        }
+    }
+}
+
+void
+VanetTrafficServer::SendDownlink (uint32_t vehicleId)
+{
+  Client &c = m_clients[vehicleId];
+  if (Now () - c.lastSeen > m_timeout)
+    {
+      NS_LOG_INFO ("vehicle-id=" << vehicleId << " silent, downlink stopped");
+      return;
+    }
+
+  Ptr<Packet> packet = Create<Packet> (m_packetSize);
+  VanetTrafficTag tag;
+  tag.SetVehicleId (vehicleId);
+  tag.SetSeq (c.seq++);
+  tag.SetTxTime (Now ());
+  tag.SetDirection (VanetTrafficTag::DOWNLINK);
+  packet->AddPacketTag (tag);
+  m_udp->SendTo (packet, 0, c.address);
+  m_txTrace (tag, m_packetSize);
+
+  c.sendEvent = Simulator::Schedule (m_downlinkRate.CalculateBytesTxTime (m_packetSize),
+                                     &VanetTrafficServer::SendDownlink, this, vehicleId);
+}
+
+} // namespace ns3
@@ -0,0 +1,190 @@
+#ifndef VANET_TRAFFIC_APP_H
+#define VANET_TRAFFIC_APP_H
+#include "ns3/application.h"
+#include "ns3/socket.h"
+#include "ns3/tag.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
+#include "ns3/txop.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Identifies the data of a vehicle flow, so the flow survives the address
+ * changes of a handover. Packet tag on UDP, byte tag on TCP.
+ */
+class VanetTrafficTag : public Tag
+{
+public:
+  enum Direction { UPLINK, DOWNLINK };
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual void Print (std::ostream &os) const;
+
+  VanetTrafficTag ();
+
+  uint32_t GetVehicleId () const;
+  uint32_t GetSeq () const;
+  Time GetTxTime () const;
+  Direction GetDirection () const;
+  bool IsRegister () const;
+
+  void SetVehicleId (uint32_t vehicleId);
+  void SetSeq (uint32_t seq);
+  void SetTxTime (Time t);
+  void SetDirection (Direction direction);
+  void SetRegister (bool reg);
+
+private:
+  uint32_t m_vehicleId;
+  uint32_t m_seq;
+  int64_t m_txTime; /**< Time steps */
+  uint8_t m_direction;
+  uint8_t m_register; /**< Registration of the vehicle address, no data */
+};
+
+/**
+ * Vehicle side of the traffic benchmark: UDP or TCP uplink to a
+ * VanetTrafficServer at a constant rate (Cbr) or as fast as the transport
+ * takes it (Bulk), and the receiver of the server's downlink.
+ *
+ * Traffic starts with the first address offered by the node's
+ * BeaconSearchNet. After each address change the vehicle registers its new
+ * address with the server and reconnects TCP, so the flow (keyed by the
+ * vehicle id in the tag) continues across handovers.
+ */
+class VanetTrafficClient : public ns3::Application
+{
+public:
+  enum Protocol { UDP, TCP };
+  enum Mode { CBR, BULK };
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  VanetTrafficClient ();
+  ~VanetTrafficClient ();
+
+  /** Stop sending, e.g. when the vehicle leaves the simulation; resumes with the next offer */
+  void Detach ();
+
+  /**
+   * TracedCallback signature for data sent or received.
+   *
+   * \param [in] tag Flow tag of the data.
+   * \param [in] bytes Payload bytes.
+   */
+  typedef void (*TrafficTracedCallback) (const VanetTrafficTag &tag, uint32_t bytes);
+
+  /**
+   * TracedCallback signature for a vehicle leaving.
+   *
+   * \param [in] vehicleId Node id of the vehicle.
+   */
+  typedef void (*DetachTracedCallback) (uint32_t vehicleId);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void StartApplication ();
+  void StopApplication ();
+
+  /** DhcpOfferRx of the node's BeaconSearchNet, before the address swap */
+  void NotifyOffer (uint32_t rsuId, Ipv4Address addr);
+  /** New address configured: register and restart the uplink */
+  void Attach ();
+  void Register ();
+  void SendPacket ();
+  void SendTcp (Ptr<Socket> socket, uint32_t available);
+  void ConnectTcp ();
+  void CloseTcp ();
+  void TcpConnected (Ptr<Socket> socket);
+  void TcpFailed (Ptr<Socket> socket);
+  void HandleRead (Ptr<Socket> socket);
+  Ptr<Packet> CreateData ();
+  /** Packets waiting in the wifi queue, for Bulk over UDP */
+  uint32_t GetBacklog () const;
+
+  Ipv4Address m_remote; /**< Server address */
+  uint16_t m_port; /**< Server port (UDP and TCP) */
+  Protocol m_protocol; /**< Uplink transport */
+  Mode m_mode; /**< Uplink pattern */
+  DataRate m_rate; /**< Cbr uplink rate */
+  uint32_t m_packetSize; /**< Payload bytes per packet */
+  uint32_t m_bulkBacklog; /**< Bulk over UDP: packets kept in the wifi queue */
+  Time m_keepAlive; /**< Registration refresh interval */
+
+  Ptr<Socket> m_udp; /**< Registrations, UDP uplink and downlink */
+  Ptr<Socket> m_tcp; /**< TCP uplink, replaced after each address change */
+  Ptr<Txop> m_txop; /**< Channel access of the wifi device */
+  bool m_attached; /**< Address from an RSU configured */
+  bool m_tcpConnected;
+  uint32_t m_seq; /**< Next uplink sequence number */
+  EventId m_sendEvent; /**< Next Cbr packet or Bulk backlog check */
+  EventId m_registerEvent; /**< Next registration refresh */
+  EventId m_connectEvent; /**< TCP reconnection after a failure */
+
+  TracedCallback<const VanetTrafficTag &, uint32_t> m_txTrace; /**< Uplink data sent */
+  TracedCallback<const VanetTrafficTag &, uint32_t> m_rxTrace; /**< Downlink data received */
+  TracedCallback<uint32_t> m_detachTrace; /**< Vehicle left */
+};
+
+/**
+ * Server side of the traffic benchmark: sink of the UDP and TCP uplinks
+ * and source of a UDP downlink to each registered vehicle, sent to the last
+ * address the vehicle registered.
+ */
+class VanetTrafficServer : public ns3::Application
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  VanetTrafficServer ();
+  ~VanetTrafficServer ();
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct Client
+  {
+    Address address; /**< Last registered address and port */
+    Time lastSeen; /**< Last registration or uplink packet */
+    uint32_t seq; /**< Next downlink sequence number */
+    EventId sendEvent; /**< Next downlink packet */
+  };
+
+  void StartApplication ();
+  void StopApplication ();
+
+  void HandleUdp (Ptr<Socket> socket);
+  void HandleAccept (Ptr<Socket> socket, const Address &from);
+  void HandleTcp (Ptr<Socket> socket);
+  void SendDownlink (uint32_t vehicleId);
+
+  uint16_t m_port; /**< Listening port (UDP and TCP) */
+  DataRate m_downlinkRate; /**< Downlink rate per vehicle (0: no downlink) */
+  uint32_t m_packetSize; /**< Downlink payload bytes per packet */
+  Time m_timeout; /**< Stop the downlink of a vehicle silent for this long */
+
+  Ptr<Socket> m_udp;
+  Ptr<Socket> m_tcp; /**< Listening socket */
+  std::vector<Ptr<Socket>> m_accepted; /**< TCP connections from the vehicles */
+  std::map<uint32_t, Client> m_clients; /**< Vehicle node id -> client */
+
+  TracedCallback<const VanetTrafficTag &, uint32_t> m_txTrace; /**< Downlink data sent */
+  TracedCallback<const VanetTrafficTag &, uint32_t> m_rxTrace; /**< Uplink data received */
+};
+} // namespace ns3
+#endif